@@ -2,9 +2,12 @@ uniform mat4 projection;
 
 in vec4 vertex;
 in vec2 tex_coord;
+in float vertex_m;
 out vec2 tex_coord_out;
+out float m;
 
 void main(void) {
    tex_coord_out = tex_coord;
+   m = vertex_m;
    gl_Position = projection * vertex;
 }
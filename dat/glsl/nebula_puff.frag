@@ -4,7 +4,7 @@ const float SCALAR = pow(2., 4./3.);
 
 uniform vec3 nebu_col;
 uniform float time;
-uniform vec2 r;
+in vec2 r;
 
 in vec2 pos;
 out vec4 colour_out;
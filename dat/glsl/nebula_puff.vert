@@ -0,0 +1,13 @@
+uniform mat4 projection;
+
+in vec4 vertex;
+in vec2 vertex_pos;
+in vec2 vertex_r;
+out vec2 pos;
+out vec2 r;
+
+void main(void) {
+   pos = vertex_pos;
+   r = vertex_r;
+   gl_Position = projection * vertex;
+}
@@ -0,0 +1,9 @@
+uniform sampler2D sampler;
+
+in vec2 tex_coord;
+in vec4 colour;
+out vec4 colour_out;
+
+void main(void) {
+   colour_out = colour * texture(sampler, tex_coord);
+}
@@ -0,0 +1,13 @@
+uniform mat4 projection;
+
+in vec4 vertex;
+in vec2 vertex_tex;
+in vec4 vertex_colour;
+out vec2 tex_coord;
+out vec4 colour;
+
+void main(void) {
+   tex_coord = vertex_tex;
+   colour = vertex_colour;
+   gl_Position = projection * vertex;
+}
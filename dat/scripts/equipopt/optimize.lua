@@ -134,6 +134,138 @@ special_ships["Heavy Drone"] = function( p )
 end
 
 
+--[[
+      Memoization of solved loadouts
+
+      Solving the MIP is by far the most expensive part of equipping a pilot,
+      and spawn scripts end up solving the same problem over and over again.
+      Solutions are stored in the global Lua cache so that they persist for
+      the whole session and are shared among all environments. A few different
+      solutions are kept for each problem and chosen at random so that fleets
+      still vary. Everything is thrown away when a unidiff is applied or
+      removed, as that can change what outfits are available.
+--]]
+optimize.memoize = true -- Set to false to always solve
+local memo_variants = 4 -- Number of different solutions stored per problem
+
+local function memo_get()
+   local nc = naev.cache()
+   local m = nc.equipopt_memo
+   local gen = diff.generation()
+   if not m then
+      m = { gen=gen, entries={}, hits=0, misses=0, invalidations=0 }
+      nc.equipopt_memo = m
+   elseif m.gen ~= gen then
+      m.gen = gen
+      m.entries = {}
+      m.invalidations = m.invalidations+1
+   end
+   return m
+end
+
+-- Serializes a value with sorted keys so equivalent tables give the same key,
+-- returns nil if the value can't be keyed (custom functions)
+local function memo_serialize( v, ignore )
+   local t = type(v)
+   if t=="table" then
+      local keys = {}
+      for k,_v in pairs(v) do
+         if k ~= ignore then
+            table.insert( keys, k )
+         end
+      end
+      table.sort( keys, function( a, b ) return tostring(a) < tostring(b) end )
+      local s = {}
+      for i,k in ipairs(keys) do
+         local sv = memo_serialize( v[k], ignore )
+         if not sv then
+            return nil
+         end
+         s[i] = tostring(k).."="..sv
+      end
+      return "{"..table.concat( s, "," ).."}"
+   elseif t=="function" then
+      -- Functions are different in each environment, so use a name for the
+      -- default. Other functions may depend on upvalues and can't be keyed.
+      if v==optimize.goodness_default then
+         return "goodness_default"
+      end
+      return nil
+   elseif t=="number" then
+      return string.format( "%.17g", v )
+   end
+   return tostring(v)
+end
+
+local function memo_key( ps, cores, outfit_list, params )
+   local names = {}
+   local seen = {}
+   for k,o in ipairs(outfit_list) do
+      local n = o:nameRaw()
+      if not seen[n] then
+         seen[n] = true
+         table.insert( names, n )
+      end
+   end
+   table.sort( names )
+   local c = {}
+   if cores then
+      for k,v in ipairs(cores) do
+         c[k] = (type(v)=="string" and v) or v:nameRaw()
+      end
+   end
+   -- type_range gets the row ids written into it while solving
+   local sp = memo_serialize( params, "id" )
+   local ss = memo_serialize( optimize.sparams or {} )
+   if not sp or not ss then
+      return nil
+   end
+   local _nebu_dens, nebu_vol = system.cur():nebula()
+   return ps:nameRaw()
+      .."|"..table.concat( c, "," )
+      .."|"..table.concat( names, "," )
+      .."|"..sp
+      .."|"..ss
+      .."|"..nebu_vol
+end
+
+-- Tries to equip a stored solution, returns true on success
+local function memo_apply( p, e )
+   local sol = e[ rnd.rnd(1,#e) ]
+   for k,o in ipairs(sol) do
+      if p:outfitAdd( o, 1, true ) < 1 then
+         p:outfitRm( "all" )
+         return false
+      end
+   end
+   -- Outfits can be fine one by one and not together
+   if not p:spaceworthy() then
+      p:outfitRm( "all" )
+      return false
+   end
+   return true
+end
+
+--[[--
+   Gets statistics about the loadout memoization.
+
+      @treturn number Number of times a stored solution was used.
+      @treturn number Number of times the problem had to be solved.
+      @treturn number Number of times the stored solutions were invalidated.
+--]]
+function optimize.memo_stats()
+   local m = memo_get()
+   return m.hits, m.misses, m.invalidations
+end
+
+--[[--
+   Clears all the stored loadouts and statistics.
+--]]
+function optimize.memo_clear()
+   naev.cache().equipopt_memo = nil
+end
+
+
 --[[
       Goodness functions to rank how good each outfits are
 --]]
@@ -290,6 +422,26 @@ function optimize.optimize( p, cores, outfit_list, params )
       end
    end
 
+   -- See if we already solved this problem, note that params gets modified
+   -- below so the key has to be computed before that
+   local memo, memo_k, memo_n
+   if optimize.memoize and not params.noremove and not pt.bioship then
+      memo = memo_get()
+      memo_k = memo_key( ps, cores, outfit_list, params )
+   end
+   if memo_k then
+      -- Without randomness all the solutions would be the same
+      memo_n = ((params.rnd > 0) and memo_variants) or 1
+      local e = memo.entries[ memo_k ]
+      if e and #e >= memo_n and memo_apply( p, e ) then
+         memo.hits = memo.hits+1
+         p:fillAmmo()
+         ai_setup.setup(p)
+         return true
+      end
+      memo.misses = memo.misses+1
+   end
+
    -- Global ship stuff
    local ss = p:shipstat( nil, true ) -- Should include cores!!
    local st = p:stats() -- also include cores
@@ -696,6 +848,7 @@ function optimize.optimize( p, cores, outfit_list, params )
    local smod = 1
    local done
    local z, x, constraints
+   local chosen
    repeat
       try = try + 1
       done = true
@@ -745,12 +898,15 @@ function optimize.optimize( p, cores, outfit_list, params )
 
       -- Interpret results
       c = 1
+      chosen = {}
       for i,s in ipairs(slots) do
          for j,o in ipairs(s.outfits) do
             if x[c] == 1 then
                local q = p:outfitAdd( o, 1, true )
                if q < 1 then
                   warn(string.format(_("Unable to equip outfit '%s' on '%s'!"), o,  p:name()))
+               else
+                  table.insert( chosen, o )
                end
             end
             c = c + 1
@@ -789,6 +945,18 @@ function optimize.optimize( p, cores, outfit_list, params )
          return false
       end
    end
+
+   -- Store the solution for later
+   if memo_k then
+      local e = memo.entries[ memo_k ]
+      if not e then
+         e = {}
+         memo.entries[ memo_k ] = e
+      end
+      if #e < memo_n then
+         table.insert( e, chosen )
+      end
+   end
    return true
 end
 
@@ -30,6 +30,10 @@
 #include "rng.h"
 #include "sound.h"
 #include "space.h"
+#include "threadpool.h"
+
+#define ASTEROID_UPDATE_GRAIN                                                  \
+   128 /**< Minimum amount of asteroids moved per thread. */
 
 /**
  * @brief Represents a small asteroid debris rendered in the player frame.
@@ -74,18 +78,26 @@ static int astgroup_cmp( const void *p1, const void *p2 );
 static int astgroup_parse( AsteroidTypeGroup *ag, const char *file );
 static int asttype_load( void );
 
+static void asteroid_updateMove( Asteroid *a );
+static void asteroid_updateRange( int start, int end, void *data );
 static int  asteroid_updateSingle( Asteroid *a );
 static void asteroid_renderSingle( const Asteroid *a );
 static void debris_renderSingle( const Debris *d, double cx, double cy );
 static void debris_init( Debris *deb );
 static int  asteroid_init( Asteroid *ast, const AsteroidAnchor *field );
 
-static int asteroid_updateSingle( Asteroid *a )
+/**
+ * @brief Moves a single asteroid.
+ *
+ * Only touches the asteroid itself, so it is safe to run from worker threads.
+ *
+ *    @param a Asteroid to move.
+ */
+static void asteroid_updateMove( Asteroid *a )
 {
    const AsteroidAnchor *ast = &cur_system->asteroids[a->parent];
    double                dt  = asteroid_dt;
    double                offx, offy, d;
-   int                   forced;
    int                   setvel = 0;
 
    /* Push back towards center. */
@@ -136,6 +148,40 @@ static int asteroid_updateSingle( Asteroid *a )
 
    /* Update angle. */
    a->ang += a->spin * dt;
+}
+
+/**
+ * @brief Moves a range of asteroids of an anchor, run from vpool_parallel.
+ *
+ *    @param start First asteroid to move.
+ *    @param end One past the last asteroid to move.
+ *    @param data Asteroid anchor the asteroids belong to.
+ */
+static void asteroid_updateRange( int start, int end, void *data )
+{
+   AsteroidAnchor *ast = data;
+   for ( int j = start; j < end; j++ ) {
+      Asteroid *a = &ast->asteroids[j];
+      /* Skip inexistent asteroids. */
+      if ( a->state == ASTEROID_XX )
+         continue;
+      asteroid_updateMove( a );
+   }
+}
+
+/**
+ * @brief Updates the state of a single asteroid after it has been moved.
+ *
+ * Uses the RNG and touches pilots, so it has to be run serially.
+ *
+ *    @param a Asteroid to update.
+ *    @return 0 on success.
+ */
+static int asteroid_updateSingle( Asteroid *a )
+{
+   const AsteroidAnchor *ast = &cur_system->asteroids[a->parent];
+   double                dt  = asteroid_dt;
+   int                   forced;
 
    /* igure out state change if applicable. */
    forced = a->timer < 0.; /* Forced by Lua or whatever. */
@@ -219,8 +265,11 @@ void asteroids_update( double dt )
             exc->affects = 0;
       }
 
-      /* Now just thread it and zoom. */
+      /* Now just thread it and zoom. Movement is independent per asteroid,
+       * while the state changes use the RNG and have to be done in order. */
       asteroid_dt = dt;
+      vpool_parallel( array_size( ast->asteroids ), ASTEROID_UPDATE_GRAIN,
+                      asteroid_updateRange, ast );
       for ( int j = 0; j < array_size( ast->asteroids ); j++ ) {
          Asteroid *a = &ast->asteroids[j];
          /* Skip inexistent asteroids. */
@@ -26,6 +26,26 @@ static int PointInPolygon( const CollPolyView *at, const vec2 *ap, float x,
                            float y );
 static int LineOnPolygon( const CollPolyView *at, const vec2 *ap, float x1,
                           float y1, float x2, float y2, vec2 *crash );
+static int CollideTransRow( const glTexture *at, int ax, int ay,
+                            const glTexture *bt, int bx, int by, int n );
+
+/**
+ * @brief Gets 64 pixels of a transparency map row starting at a pixel.
+ *
+ *    @param t Texture to get pixels of.
+ *    @param x X position of the first pixel.
+ *    @param y Y position of the row.
+ *    @return Bit i is set if pixel x+i isn't transparent.
+ */
+static inline uint64_t CollideTransBits( const glTexture *t, int x, int y )
+{
+   const uint64_t *row = &t->trans[y * t->tstride + x / 64];
+   int             s   = x % 64;
+   if ( s == 0 )
+      return row[0];
+   /* Rows have a trailing empty word so row[1] is always valid. */
+   return ( row[0] >> s ) | ( row[1] << ( 64 - s ) );
+}
 
 /**
  * @brief Loads a polygon from an xml node.
@@ -105,6 +125,39 @@ void poly_free( CollPoly *poly )
    array_free( poly->views );
 }
 
+/**
+ * @brief Finds the first pixel of a row span that isn't transparent in both
+ * textures.
+ *
+ * Tests 64 pixels at a time, finding the same pixel as testing them one by one
+ *  from the left would.
+ *
+ *    @param at Texture a.
+ *    @param ax X position of the span in texture a.
+ *    @param ay Y position of the span in texture a.
+ *    @param bt Texture b, or NULL to only check texture a.
+ *    @param bx X position of the span in texture b.
+ *    @param by Y position of the span in texture b.
+ *    @param n Number of pixels in the span.
+ *    @return Offset of the pixel in the span or -1 if there is none.
+ */
+static int CollideTransRow( const glTexture *at, int ax, int ay,
+                            const glTexture *bt, int bx, int by, int n )
+{
+   for ( int i = 0; i < n; i += 64 ) {
+      uint64_t m = CollideTransBits( at, ax + i, ay );
+      if ( m == 0 )
+         continue;
+      if ( bt != NULL )
+         m &= CollideTransBits( bt, bx + i, by );
+      if ( n - i < 64 )
+         m &= ( UINT64_C( 1 ) << ( n - i ) ) - 1;
+      if ( m != 0 )
+         return i + __builtin_ctzll( m );
+   }
+   return -1;
+}
+
 /**
  * @brief Checks whether or not two sprites collide.
  *
@@ -127,7 +180,6 @@ int CollideSprite( const glTexture *at, const int asx, const int asy,
                    const vec2 *ap, const glTexture *bt, const int bsx,
                    const int bsy, const vec2 *bp, vec2 *crash )
 {
-   int x, y;
    int ax1, ax2, ay1, ay2;
    int bx1, bx2, by1, by2;
    int inter_x0, inter_x1, inter_y0, inter_y1;
@@ -180,17 +232,17 @@ int CollideSprite( const glTexture *at, const int asx, const int asy,
    bbx = bsx * (int)( bt->sw ) - bx1;
    bby = rbsy * (int)( bt->sh ) - by1;
 
-   for ( y = inter_y0; y <= inter_y1; y++ )
-      for ( x = inter_x0; x <= inter_x1; x++ )
-         /* compute offsets for surface before pass to TransparentPixel test */
-         if ( ( !gl_isTrans( at, abx + x, aby + y ) ) &&
-              ( !gl_isTrans( bt, bbx + x, bby + y ) ) ) {
-
-            /* Set the crash position. */
-            crash->x = x;
-            crash->y = y;
-            return 1;
-         }
+   for ( int y = inter_y0; y <= inter_y1; y++ ) {
+      /* Test the whole row of the overlap at once. */
+      int i = CollideTransRow( at, abx + inter_x0, aby + y, bt, bbx + inter_x0,
+                               bby + y, inter_x1 - inter_x0 + 1 );
+      if ( i >= 0 ) {
+         /* Set the crash position. */
+         crash->x = inter_x0 + i;
+         crash->y = y;
+         return 1;
+      }
+   }
 
    return 0;
 }
@@ -212,7 +264,6 @@ int CollideSpritePolygon( const CollPolyView *at, const vec2 *ap,
                           const glTexture *bt, int bsx, int bsy, const vec2 *bp,
                           vec2 *crash )
 {
-   int x, y;
    int ax1, ax2, ay1, ay2;
    int bx1, bx2, by1, by2;
    int inter_x0, inter_x1, inter_y0, inter_y1;
@@ -257,16 +308,21 @@ int CollideSpritePolygon( const CollPolyView *at, const vec2 *ap,
    /* set up the base points */
    bbx = bsx * (int)( bt->sw ) - bx1;
    bby = rbsy * (int)( bt->sh ) - by1;
-   for ( y = inter_y0; y <= inter_y1; y++ ) {
-      for ( x = inter_x0; x <= inter_x1; x++ ) {
-         /* compute offsets for surface before pass to TransparentPixel test */
-         if ( ( !gl_isTrans( bt, bbx + x, bby + y ) ) ) {
-            if ( PointInPolygon( at, ap, (float)x, (float)y ) ) {
-               crash->x = x;
-               crash->y = y;
-               return 1;
-            }
+   for ( int y = inter_y0; y <= inter_y1; y++ ) {
+      int x = inter_x0;
+      while ( x <= inter_x1 ) {
+         /* Skip to the next pixel that isn't transparent. */
+         int i = CollideTransRow( bt, bbx + x, bby + y, NULL, 0, 0,
+                                  inter_x1 - x + 1 );
+         if ( i < 0 )
+            break;
+         x += i;
+         if ( PointInPolygon( at, ap, (float)x, (float)y ) ) {
+            crash->x = x;
+            crash->y = y;
+            return 1;
          }
+         x++;
       }
    }
 
@@ -968,15 +1024,27 @@ int CollideCircleSprite( const vec2 *ap, double ar, const glTexture *bt,
    bbx = bsx * (int)( bt->sw ) - bx1;
    bby = rbsy * (int)( bt->sh ) - by1;
    for ( int y = inter_y0; y <= inter_y1; y++ ) {
-      for ( int x = inter_x0; x <= inter_x1; x++ ) {
-         /* compute offsets for surface before pass to TransparentPixel test */
-         if ( ( !gl_isTrans( bt, bbx + x, bby + y ) ) ) {
-            if ( pow2( x - acx ) + pow2( y - acy ) <= r * r ) {
-               crash->x = x;
-               crash->y = y;
-               return 1;
-            }
-         }
+      int i, x0, x1, dx;
+      int rem = r * r - ( y - acy ) * ( y - acy );
+      if ( rem < 0 )
+         continue;
+
+      /* Horizontal extent of the circle on this row, dx*dx <= rem. */
+      dx = (int)sqrt( rem );
+      while ( ( dx + 1 ) * ( dx + 1 ) <= rem )
+         dx++;
+      while ( dx * dx > rem )
+         dx--;
+      x0 = MAX( inter_x0, acx - dx );
+      x1 = MIN( inter_x1, acx + dx );
+      if ( x0 > x1 )
+         continue;
+
+      i = CollideTransRow( bt, bbx + x0, bby + y, NULL, 0, 0, x1 - x0 + 1 );
+      if ( i >= 0 ) {
+         crash->x = x0 + i;
+         crash->y = y;
+         return 1;
       }
    }
 
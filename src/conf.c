@@ -202,6 +202,7 @@ void conf_setAudioDefaults( void )
    /* Sound. */
    conf.al_efx     = USE_EFX_DEFAULT;
    conf.nosound    = MUTE_SOUND_DEFAULT;
+   conf.sound_lazy = SOUND_LAZY_DEFAULT;
    conf.sound      = SOUND_VOLUME_DEFAULT;
    conf.music      = MUSIC_VOLUME_DEFAULT;
    conf.engine_vol = ENGINE_VOLUME_DEFAULT;
@@ -379,6 +380,7 @@ int conf_loadConfig( const char *file )
       /* Sound. */
       conf_loadBool( lEnv, "al_efx", conf.al_efx );
       conf_loadBool( lEnv, "nosound", conf.nosound );
+      conf_loadBool( lEnv, "sound_lazy", conf.sound_lazy );
       conf_loadFloat( lEnv, "sound", conf.sound );
       conf_loadFloat( lEnv, "music", conf.music );
       conf_loadFloat( lEnv, "engine_vol", conf.engine_vol );
@@ -1039,6 +1041,11 @@ int conf_saveConfig( const char *file )
    conf_saveBool( "nosound", conf.nosound );
    conf_saveEmptyLine();
 
+   conf_saveComment(
+      _( "Only decode sound effects the first time they are played" ) );
+   conf_saveBool( "sound_lazy", conf.sound_lazy );
+   conf_saveEmptyLine();
+
    conf_saveComment(
       _( "Volume of sound effects and music, between 0.0 and 1.0" ) );
    conf_saveFloat( "sound",
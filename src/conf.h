@@ -82,6 +82,7 @@
 /* Audio options */
 #define USE_EFX_DEFAULT 1 /**< Whether or not to use EFX (if using OpenAL). */
 #define MUTE_SOUND_DEFAULT 0      /**< Whether sound should be disabled. */
+#define SOUND_LAZY_DEFAULT 0      /**< Whether to decode sounds when used. */
 #define SOUND_VOLUME_DEFAULT 0.7  /**< Default sound volume. */
 #define MUSIC_VOLUME_DEFAULT 0.8  /**< Default music volume. */
 #define ENGINE_VOLUME_DEFAULT 0.8 /**< Default engine volume. */
@@ -140,6 +141,7 @@ typedef struct PlayerConf_s {
    int
       al_efx; /**< Should EFX extension be used? (only applicable for OpenAL) */
    int    nosound;    /**< Whether or not sound is on. */
+   int    sound_lazy; /**< Whether sounds are decoded on first use. */
    double sound;      /**< Sound level for sound effects. */
    double music;      /**< Sound level for music. */
    double engine_vol; /**< Sound level for engines (relative). */
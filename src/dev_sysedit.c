@@ -483,8 +483,7 @@ static void sysedit_btnNewSpob( unsigned int wid_unused, const char *unused )
    }
 
    /* Create the new spob. */
-   p       = spob_new();
-   p->name = name;
+   p = spob_new( name );
 
    /* Base spob data off another. */
    good = 0;
@@ -1917,6 +1916,7 @@ static void sysedit_editJumpClose( unsigned int wid, const char *unused )
       jp_rmFlag( j, JP_EXITONLY );
    }
    j->hide = atof( window_getInput( sysedit_widEdit, "inpHide" ) );
+   map_jumpDistInvalidate();
 
    window_close( wid, unused );
 }
@@ -1609,9 +1609,8 @@ static void uniedit_renameSys( void )
 
          free( oldName );
          free( newName );
-         free( sys->name );
 
-         sys->name = name;
+         system_rename( sys, name );
          dsys_saveSystem( sys );
 
          /* Re-save adjacent systems. */
@@ -1656,8 +1655,7 @@ static void uniedit_newSys( double x, double y )
    }
 
    /* Create the system. */
-   sys            = system_new();
-   sys->name      = name;
+   sys            = system_new( name );
    sys->pos.x     = x;
    sys->pos.y     = y;
    sys->spacedust = DUST_DENSITY_DEFAULT;
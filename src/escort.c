@@ -100,7 +100,7 @@ void escort_rmList( Pilot *p, unsigned int id )
  *    @param type Type of escort.
  *    @param add Whether or not to add it to the escort list.
  *    @param dockslot The outfit slot which launched the escort (-1 if N/A)
- *    @return The ID of the escort on success.
+ *    @return The ID of the escort on success or 0 on failure.
  */
 unsigned int escort_create( Pilot *p, const Ship *ship, const vec2 *pos,
                             const vec2 *vel, double dir, EscortType_t type,
@@ -126,6 +126,8 @@ unsigned int escort_create( Pilot *p, const Ship *ship, const vec2 *pos,
    /* Create the pilot. */
    pe = pilot_create( ship, NULL, p->faction, "escort", dir, pos, vel, f,
                       parent, dockslot );
+   if ( pe == NULL )
+      return 0;
    pe->parent = parent;
 
    /* Make invincible to player. */
@@ -195,17 +197,20 @@ unsigned int escort_create( Pilot *p, const Ship *ship, const vec2 *pos,
  *    @param type Type of escort.
  *    @param add Whether or not to add it to the escort list.
  *    @param dockslot The outfit slot which launched the escort (-1 if N/A)
- *    @return The ID of the escort on success.
+ *    @return The ID of the escort on success or 0 on failure.
  */
 unsigned int escort_createRef( Pilot *p, Pilot *pe, const vec2 *pos,
                                const vec2 *vel, double dir, EscortType_t type,
                                int add, int dockslot )
 {
-   if ( pilot_get( pe->id ) == NULL ) /* Not on stack yet. */
-      pilot_addStack( pe );           /* Sets the ID, and resets internals. */
-   else
+   if ( pilot_get( pe->id ) == NULL ) { /* Not on stack yet. */
+      /* Sets the ID, and resets internals. */
+      if ( pilot_addStack( pe ) == 0 )
+         return 0;
+   } else
       pilot_reset( pe ); /* Reset internals. */
    pe->parent = p->id;
+   pilot_quadtreeAlways( pe );
 
    /* Make invincible to player. */
    if ( pe->parent == PLAYER_ID )
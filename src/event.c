@@ -47,6 +47,8 @@
 
 #define EVENT_FLAG_UNIQUE ( 1 << 0 ) /**< Unique event. */
 
+#define EVENT_TRIGGER_MAX ( EVENT_TRIGGER_LOAD + 1 ) /**< Number of triggers. */
+
 /**
  * @brief Event data structure.
  */
@@ -79,6 +81,45 @@ typedef struct EventData_ {
  */
 static EventData *event_data = NULL; /**< Allocated event data. */
 
+/**
+ * @brief An event file read from disk with its XML header already parsed.
+ */
+typedef struct EventFile_ {
+   char     *file;    /**< Source file path. */
+   char     *filebuf; /**< Contents of the file. */
+   xmlDocPtr doc;     /**< Parsed XML header. */
+} EventFile;
+static EventFile *event_files =
+   NULL; /**< Array (array.h): Files read by events_loadXML. */
+
+/**
+ * @brief Entry of an event bucket keyed by spob or system name.
+ */
+typedef struct EventNameIdx_ {
+   const char *name; /**< Name of the spob or system, owned by the data. */
+   int         idx;  /**< Index in event_data. */
+} EventNameIdx;
+
+/**
+ * @brief Events of a trigger, bucketed by where they can happen so only
+ * plausible candidates have to be checked.
+ */
+typedef struct EventIndex_ {
+   int          *generic; /**< Array (array.h): Events that can happen
+                             anywhere. */
+   EventNameIdx *spob;    /**< Array (array.h): Events restricted to a spob,
+                             sorted by name. */
+   EventNameIdx *system;  /**< Array (array.h): Events restricted to a
+                             system, sorted by name. */
+} EventIndex;
+static EventIndex event_index[EVENT_TRIGGER_MAX]; /**< Events by trigger. */
+static int event_indexed = 0; /**< Whether event_index is up to date. */
+static char *event_chapter =
+   NULL; /**< Chapter event_chapter_match was computed for. */
+static int *event_chapter_match =
+   NULL; /**< Array (array.h): Cached chapter matches of the events, -1 if not
+            computed yet. */
+
 /*
  * Active events.
  */
@@ -91,12 +132,23 @@ static Event_t     *event_active = NULL; /**< Active events. */
 static unsigned int event_genID( void );
 static int          event_cmp( const void *a, const void *b );
 static int          event_parseFile( const char *file, EventData *temp );
+static int          event_readFile( const char *file, EventFile *ef );
+static int          event_parseRead( const EventFile *ef, EventData *temp );
+static void         event_freeFile( EventFile *ef );
 static int          event_parseXML( EventData *temp, const xmlNodePtr parent );
 static void         event_freeData( EventData *event );
 static int          event_create( int dataid, unsigned int *id );
 int                 events_saveActive( xmlTextWriterPtr writer );
 int                 events_loadActive( xmlNodePtr parent );
 static int          events_parseActive( xmlNodePtr parent );
+static int          event_cmpInt( const void *a, const void *b );
+static int          event_cmpNameIdx( const void *a, const void *b );
+static void         event_indexFree( void );
+static void         event_indexBuild( void );
+static void event_candidatesName( int **cand, const EventNameIdx *bucket,
+                                  const char *name );
+static int *event_candidates( EventTrigger_t trigger );
+static int  event_matchChapter( int dataid );
 
 /**
  * @brief Gets an event.
@@ -318,16 +370,14 @@ int event_alreadyRunning( int data )
  */
 void events_trigger( EventTrigger_t trigger )
 {
-   int created = 0;
-   for ( int i = 0; i < array_size( event_data ); i++ ) {
+   int  created = 0;
+   int *cand    = event_candidates( trigger );
+   for ( int k = 0; k < array_size( cand ); k++ ) {
+      int        i  = cand[k];
       EventData *ed = &event_data[i];
 
       if ( naev_isQuit() )
-         return;
-
-      /* Make sure trigger matches. */
-      if ( ed->trigger != trigger )
-         continue;
+         break;
 
       /* Spob. */
       if ( ( trigger == EVENT_TRIGGER_LAND || trigger == EVENT_TRIGGER_LOAD ) &&
@@ -375,25 +425,8 @@ void events_trigger( EventTrigger_t trigger )
       }
 
       /* If chapter, must match chapter regex. */
-      if ( ed->chapter_re != NULL ) {
-         pcre2_match_data *match_data =
-            pcre2_match_data_create_from_pattern( ed->chapter_re, NULL );
-         int rc =
-            pcre2_match( ed->chapter_re, (PCRE2_SPTR)player.chapter,
-                         strlen( player.chapter ), 0, 0, match_data, NULL );
-         pcre2_match_data_free( match_data );
-         if ( rc < 0 ) {
-            switch ( rc ) {
-            case PCRE2_ERROR_NOMATCH:
-               continue;
-            default:
-               WARN( _( "Matching error %d" ), rc );
-               break;
-            }
-            continue;
-         } else if ( rc == 0 )
-            continue;
-      }
+      if ( ( ed->chapter_re != NULL ) && !event_matchChapter( i ) )
+         continue;
 
       /* Test conditional. */
       if ( ed->cond != NULL ) {
@@ -409,12 +442,186 @@ void events_trigger( EventTrigger_t trigger )
       event_create( i, NULL );
       created++;
    }
+   array_free( cand );
 
    /* Run claims if necessary. */
    if ( created )
       claim_activateAll();
 }
 
+/**
+ * @brief Checks to see if the player's chapter matches the event's.
+ *
+ * Results are cached until the player's chapter changes, which is rare.
+ *
+ *    @param dataid Event to check, must have a chapter regex.
+ *    @return 1 if it matches, 0 otherwise.
+ */
+static int event_matchChapter( int dataid )
+{
+   const EventData  *ed = &event_data[dataid];
+   int               rc;
+   pcre2_match_data *match_data;
+
+   /* Invalidate if the chapter changed. */
+   if ( ( event_chapter == NULL ) ||
+        ( strcmp( event_chapter, player.chapter ) != 0 ) ||
+        ( array_size( event_chapter_match ) != array_size( event_data ) ) ) {
+      free( event_chapter );
+      event_chapter = strdup( player.chapter );
+      array_free( event_chapter_match );
+      event_chapter_match = array_create_size( int, array_size( event_data ) );
+      array_resize( &event_chapter_match, array_size( event_data ) );
+      for ( int i = 0; i < array_size( event_chapter_match ); i++ )
+         event_chapter_match[i] = -1;
+   }
+   if ( event_chapter_match[dataid] >= 0 )
+      return event_chapter_match[dataid];
+
+   match_data = pcre2_match_data_create_from_pattern( ed->chapter_re, NULL );
+   rc         = pcre2_match( ed->chapter_re, (PCRE2_SPTR)player.chapter,
+                             strlen( player.chapter ), 0, 0, match_data, NULL );
+   pcre2_match_data_free( match_data );
+   if ( ( rc < 0 ) && ( rc != PCRE2_ERROR_NOMATCH ) )
+      WARN( _( "Matching error %d" ), rc );
+   event_chapter_match[dataid] = ( rc > 0 );
+   return event_chapter_match[dataid];
+}
+
+/**
+ * @brief Compares two ints for qsort.
+ */
+static int event_cmpInt( const void *a, const void *b )
+{
+   return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * @brief Compares name bucket entries, by name and then index.
+ */
+static int event_cmpNameIdx( const void *a, const void *b )
+{
+   const EventNameIdx *ea  = a;
+   const EventNameIdx *eb  = b;
+   int                 ret = strcmp( ea->name, eb->name );
+   if ( ret != 0 )
+      return ret;
+   return ea->idx - eb->idx;
+}
+
+/**
+ * @brief Frees the event trigger index.
+ */
+static void event_indexFree( void )
+{
+   for ( int i = 0; i < EVENT_TRIGGER_MAX; i++ ) {
+      EventIndex *ei = &event_index[i];
+      array_free( ei->generic );
+      array_free( ei->spob );
+      array_free( ei->system );
+      memset( ei, 0, sizeof( EventIndex ) );
+   }
+   event_indexed = 0;
+}
+
+/**
+ * @brief Builds the event trigger index.
+ *
+ * Spobs only restrict land and load events, so other events with a spob are
+ * bucketed by system or as generic.
+ */
+static void event_indexBuild( void )
+{
+   event_indexFree();
+   for ( int i = 0; i < EVENT_TRIGGER_MAX; i++ ) {
+      EventIndex *ei = &event_index[i];
+      ei->generic    = array_create( int );
+      ei->spob       = array_create( EventNameIdx );
+      ei->system     = array_create( EventNameIdx );
+   }
+
+   for ( int i = 0; i < array_size( event_data ); i++ ) {
+      const EventData *ed = &event_data[i];
+      EventIndex      *ei;
+
+      if ( ( ed->trigger < 0 ) || ( ed->trigger >= EVENT_TRIGGER_MAX ) )
+         continue;
+      ei = &event_index[ed->trigger];
+
+      if ( ( ed->spob != NULL ) && ( ( ed->trigger == EVENT_TRIGGER_LAND ) ||
+                                     ( ed->trigger == EVENT_TRIGGER_LOAD ) ) ) {
+         EventNameIdx e = { .name = ed->spob, .idx = i };
+         array_push_back( &ei->spob, e );
+      } else if ( ed->system != NULL ) {
+         EventNameIdx e = { .name = ed->system, .idx = i };
+         array_push_back( &ei->system, e );
+      } else
+         array_push_back( &ei->generic, i );
+   }
+
+   for ( int i = 0; i < EVENT_TRIGGER_MAX; i++ ) {
+      EventIndex *ei = &event_index[i];
+      qsort( ei->spob, array_size( ei->spob ), sizeof( EventNameIdx ),
+             event_cmpNameIdx );
+      qsort( ei->system, array_size( ei->system ), sizeof( EventNameIdx ),
+             event_cmpNameIdx );
+   }
+   event_indexed = 1;
+}
+
+/**
+ * @brief Adds the events of a name bucket matching a name to a list.
+ */
+static void event_candidatesName( int **cand, const EventNameIdx *bucket,
+                                  const char *name )
+{
+   int lo = 0;
+   int hi = array_size( bucket );
+   while ( lo < hi ) {
+      int mid = ( lo + hi ) / 2;
+      if ( strcmp( bucket[mid].name, name ) < 0 )
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   for ( int i = lo; ( i < array_size( bucket ) ) &&
+                     ( strcmp( bucket[i].name, name ) == 0 );
+         i++ )
+      array_push_back( cand, bucket[i].idx );
+}
+
+/**
+ * @brief Gets the events that could be triggered right now.
+ *
+ * Only filters by trigger, spob and system, the rest still has to be checked.
+ *
+ *    @param trigger Trigger to get events of.
+ *    @return Array (array.h) of event_data indices, in data order. Must be
+ *          freed.
+ */
+static int *event_candidates( EventTrigger_t trigger )
+{
+   const EventIndex *ei;
+   int              *cand = array_create( int );
+
+   if ( !event_indexed )
+      event_indexBuild();
+   if ( ( trigger < 0 ) || ( trigger >= EVENT_TRIGGER_MAX ) )
+      return cand;
+   ei = &event_index[trigger];
+
+   for ( int i = 0; i < array_size( ei->generic ); i++ )
+      array_push_back( &cand, ei->generic[i] );
+   if ( land_spob != NULL )
+      event_candidatesName( &cand, ei->spob, land_spob->name );
+   if ( cur_system != NULL )
+      event_candidatesName( &cand, ei->system, cur_system->name );
+
+   /* Put back in data order. */
+   qsort( cand, array_size( cand ), sizeof( int ), event_cmpInt );
+   return cand;
+}
+
 /**
  * @brief Loads up an event from an XML node.
  *
@@ -559,6 +766,29 @@ static int event_cmp( const void *a, const void *b )
    return strcmp( ea->name, eb->name );
 }
 
+/**
+ * @brief Reads all the event files and parses their XML headers.
+ *
+ * Does not touch Lua nor any other subsystem, so it can be run on a worker
+ * thread while other data is loading. The events themselves are created by
+ * events_load().
+ *
+ *    @return 0 on success.
+ */
+int events_loadXML( void )
+{
+   char **files = ndata_listRecursive( EVENT_DATA_PATH );
+   event_files  = array_create_size( EventFile, array_size( files ) );
+   for ( int i = 0; i < array_size( files ); i++ ) {
+      EventFile ef;
+      if ( event_readFile( files[i], &ef ) == 0 )
+         array_push_back( &event_files, ef );
+      free( files[i] );
+   }
+   array_free( files );
+   return 0;
+}
+
 /**
  * @brief Loads all the events.
  *
@@ -569,15 +799,19 @@ int events_load( void )
 #if DEBUGGING
    Uint32 time = SDL_GetTicks();
 #endif /* DEBUGGING */
-   char **event_files = ndata_listRecursive( EVENT_DATA_PATH );
+
+   /* Read the files here if events_loadXML was not run ahead of time. */
+   if ( event_files == NULL )
+      events_loadXML();
 
    /* Run over events. */
    event_data = array_create_size( EventData, array_size( event_files ) );
    for ( int i = 0; i < array_size( event_files ); i++ ) {
-      event_parseFile( event_files[i], NULL );
-      free( event_files[i] );
+      event_parseRead( &event_files[i], NULL );
+      event_freeFile( &event_files[i] );
    }
    array_free( event_files );
+   event_files = NULL;
    array_shrink( &event_data );
 
 #ifdef DEBUGGING
@@ -616,13 +850,32 @@ int events_load( void )
  *    @param temp Data to load into, or NULL for initial load.
  */
 static int event_parseFile( const char *file, EventData *temp )
+{
+   EventFile ef;
+   int       ret = event_readFile( file, &ef );
+   if ( ret != 0 )
+      return ( ret < 0 ) ? -1 : 0;
+   ret = event_parseRead( &ef, temp );
+   event_freeFile( &ef );
+   return ret;
+}
+
+/**
+ * @brief Reads an event file and parses its XML header.
+ *
+ * Only touches the file system and libxml2, so it is safe to use from a
+ * worker thread.
+ *
+ *    @param file Source file path.
+ *    @param[out] ef File read, only set on success.
+ *    @return 0 on success, 1 if the file is not an event, -1 on error.
+ */
+static int event_readFile( const char *file, EventFile *ef )
 {
    size_t      bufsize;
-   xmlNodePtr  node;
    xmlDocPtr   doc;
    char       *filebuf;
    const char *pos, *start_pos;
-   int         ret;
 
    /* Load string. */
    filebuf = ndata_read( file, &bufsize );
@@ -642,7 +895,7 @@ static int event_parseFile( const char *file, EventData *temp )
       if ( ( pos != NULL ) && !strncmp( pos, "--common", bufsize ) )
          WARN( _( "Event '%s' has create function but no XML header!" ), file );
       free( filebuf );
-      return 0;
+      return 1;
    }
 
    /* Separate XML header and Lua. */
@@ -650,6 +903,7 @@ static int event_parseFile( const char *file, EventData *temp )
    pos       = strnstr( filebuf, "--]]", bufsize );
    if ( pos == NULL || start_pos == NULL ) {
       WARN( _( "Event file '%s' has missing XML header!" ), file );
+      free( filebuf );
       return -1;
    }
 
@@ -657,13 +911,31 @@ static int event_parseFile( const char *file, EventData *temp )
    doc = xmlParseMemory( start_pos, pos - start_pos );
    if ( doc == NULL ) {
       WARN( _( "Unable to parse document XML header for Event '%s'" ), file );
+      free( filebuf );
       return -1;
    }
 
+   ef->file    = strdup( file );
+   ef->filebuf = filebuf;
+   ef->doc     = doc;
+   return 0;
+}
+
+/**
+ * @brief Creates the event data from a file read by event_readFile.
+ *
+ *    @param ef File to load from.
+ *    @param temp Data to load into, or NULL for initial load.
+ */
+static int event_parseRead( const EventFile *ef, EventData *temp )
+{
+   xmlNodePtr node;
+   int        ret;
+
    /* Get the root node. */
-   node = doc->xmlChildrenNode;
+   node = ef->doc->xmlChildrenNode;
    if ( !xml_isNode( node, XML_EVENT_TAG ) ) {
-      WARN( _( "Malformed '%s' file: missing root element '%s'" ), file,
+      WARN( _( "Malformed '%s' file: missing root element '%s'" ), ef->file,
             XML_EVENT_TAG );
       return -1;
    }
@@ -671,8 +943,8 @@ static int event_parseFile( const char *file, EventData *temp )
    if ( temp == NULL )
       temp = &array_grow( &event_data );
    event_parseXML( temp, node );
-   temp->lua        = strdup( filebuf );
-   temp->sourcefile = strdup( file );
+   temp->lua        = strdup( ef->filebuf );
+   temp->sourcefile = strdup( ef->file );
 
    /* Clear chunk if already loaded. */
    if ( temp->chunk != LUA_NOREF ) {
@@ -683,18 +955,26 @@ static int event_parseFile( const char *file, EventData *temp )
    /* Check to see if syntax is valid. */
    ret = luaL_loadbuffer( naevL, temp->lua, strlen( temp->lua ), temp->name );
    if ( ret == LUA_ERRSYNTAX )
-      WARN( _( "Event Lua '%s' syntax error: %s" ), file,
+      WARN( _( "Event Lua '%s' syntax error: %s" ), ef->file,
             lua_tostring( naevL, -1 ) );
    else
       temp->chunk = luaL_ref( naevL, LUA_REGISTRYINDEX );
 
-   /* Clean up. */
-   xmlFreeDoc( doc );
-   free( filebuf );
-
    return 0;
 }
 
+/**
+ * @brief Frees a file read by event_readFile.
+ *
+ *    @param ef File to free.
+ */
+static void event_freeFile( EventFile *ef )
+{
+   free( ef->file );
+   free( ef->filebuf );
+   xmlFreeDoc( ef->doc );
+}
+
 /**
  * @brief Frees an EventData structure.
  *
@@ -755,6 +1035,13 @@ void events_exit( void )
       event_freeData( &event_data[i] );
    array_free( event_data );
    event_data = NULL;
+
+   /* Free the caches. */
+   event_indexFree();
+   free( event_chapter );
+   event_chapter = NULL;
+   array_free( event_chapter_match );
+   event_chapter_match = NULL;
 }
 
 /**
@@ -978,6 +1265,11 @@ int event_reload( const char *name )
       event_freeData( &save );
    else
       *temp = save;
+
+   /* Triggers may have changed. */
+   event_indexed = 0;
+   free( event_chapter );
+   event_chapter = NULL;
    return res;
 }
 
@@ -31,6 +31,7 @@ typedef enum EventTrigger_s {
 /*
  * Loading/exiting.
  */
+int  events_loadXML( void );
 int  events_load( void );
 void events_exit( void );
 void events_cleanup( void );
@@ -22,6 +22,7 @@
 #include "conf.h"
 #include "hook.h"
 #include "log.h"
+#include "nameindex.h"
 #include "ndata.h"
 #include "nlua.h"
 #include "nxml.h"
@@ -115,12 +116,14 @@ typedef struct Faction_ {
 static Faction *faction_stack = NULL; /**< Faction stack. */
 static int     *faction_grid  = NULL; /**< Grid of faction status. */
 static size_t   faction_mgrid = 0;    /**< Allocated memory. */
+static NameIndex faction_index; /**< Maps faction names to IDs. */
 
 /*
  * Prototypes
  */
 /* static */
 static int  faction_getRaw( const char *name );
+static void faction_buildIndex( void );
 static void faction_freeOne( Faction *f );
 static void faction_sanitizePlayer( Faction *faction );
 static void faction_modPlayerLua( int f, double mod, const char *source,
@@ -156,23 +159,19 @@ static int faction_getRaw( const char *name )
    if ( strcmp( name, "Escort" ) == 0 )
       return FACTION_PLAYER;
 
-   if ( name != NULL ) {
-      int i;
-      for ( i = 0; i < array_size( faction_stack ); i++ )
-         if ( strcmp( faction_stack[i].name, name ) == 0 )
-            break;
-
-      if ( i != array_size( faction_stack ) )
-         return i;
-
-      /* Dynamic factions are why we can't have nice things.
-      const Faction f = { .name = (char*)name };
-      Faction *found = bsearch( &f, faction_stack, array_size(faction_stack),
-      sizeof(Faction), faction_cmp ); if (found != NULL) return found -
-      faction_stack;
-      */
-   }
-   return -1;
+   return nameindex_get( &faction_index, name );
+}
+
+/**
+ * @brief Rebuilds the faction name index from the faction stack.
+ *
+ * If there are duplicated names, the first faction with the name wins.
+ */
+static void faction_buildIndex( void )
+{
+   nameindex_clear( &faction_index );
+   for ( int i = 0; i < array_size( faction_stack ); i++ )
+      nameindex_add( &faction_index, faction_stack[i].name, i );
 }
 
 /**
@@ -1655,6 +1654,7 @@ int factions_load( void )
    /* Sort by name. */
    qsort( faction_stack, array_size( faction_stack ), sizeof( Faction ),
           faction_cmp );
+   faction_buildIndex();
    faction_player = faction_get( "Player" );
 
    /* Second pass - sets allies and enemies */
@@ -1812,6 +1812,7 @@ void factions_free( void )
       faction_freeOne( &faction_stack[i] );
    array_free( faction_stack );
    faction_stack = NULL;
+   nameindex_free( &faction_index );
 
    /* Clean up faction grid. */
    free( faction_grid );
@@ -1972,6 +1973,7 @@ void factions_clearDynamic( void )
       faction_freeOne( f );
       array_erase( &faction_stack, f, f + 1 );
    }
+   faction_buildIndex();
    faction_computeGrid();
 }
 
@@ -2029,6 +2031,9 @@ int faction_dynAdd( int base, const char *name, const char *display,
    if ( colour != NULL )
       f->colour = *colour;
 
+   /* Existing factions with the same name take precedence. */
+   nameindex_add( &faction_index, f->name, f - faction_stack );
+
    /* TODO make this incremental. */
    faction_computeGrid();
 
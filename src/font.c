@@ -40,16 +40,28 @@
 #define DEFAULT_TEXTURE_SIZE                                                   \
    1024             /**< Default size of texture caches for glyphs. */
 #define MAX_ROWS 64 /**< Max number of rows per texture cache. */
+#define FONT_BATCH_VERTEX                                                      \
+   5 /**< Floats per batched glyph vertex: position, texture coordinates and \
+        distance units. */
 
 /**
  * OpenGL rendering stuff. Since we can't actually render with multiple threads
  * we can be lazy and use global variables.
  */
-static mat4       font_projection_mat; /**< Projection matrix. */
 static FT_Library font_library = NULL; /**< Global FreeType library. */
 static FT_UInt
    prev_glyph_index; /**< Index of last character drawn (for kerning). */
 static int prev_glyph_ft_index; /**< HACK: Index into which stsh->ft[_].face? */
+static GLfloat *font_batch =
+   NULL; /**< Vertices of the glyphs waiting to be drawn. */
+static GLuint   font_batchTex  = 0;    /**< Texture of the batched glyphs. */
+static glColour font_batchCol;         /**< Colour of the batched glyphs. */
+static gl_vbo  *font_batchVBO  = NULL; /**< VBO for batched glyphs. */
+static GLsizei  font_batchSize = 0;    /**< Size of the batch VBO. */
+static const glColour *font_outlineCol =
+   NULL; /**< Colour of the outline when it is hidden, NULL otherwise. */
+static GLfloat font_penX; /**< Pen position in distance field units. */
+static GLfloat font_penY; /**< Pen position in distance field units. */
 
 /**
  * @brief Stores the row information for a font.
@@ -133,12 +145,10 @@ typedef struct glFontStash_s {
    int          tw;            /**< Width of textures. */
    int          th;            /**< Height of textures. */
    glFontTex   *tex;           /**< Textures. */
-   gl_vbo      *vbo_tex;       /**< VBO associated to texture coordinates. */
-   gl_vbo      *vbo_vert;      /**< VBO associated to vertex coordinates. */
-   GLfloat     *vbo_tex_data;  /**< Copy of texture coordinate data. */
-   GLshort     *vbo_vert_data; /**< Copy of vertex coordinate data. */
-   int          nvbo;          /**< Amount of vbo data. */
-   int          mvbo;          /**< Amount of vbo memory. */
+   GLfloat     *vbo_tex_data;  /**< Texture coordinates of the glyph quads. */
+   GLshort     *vbo_vert_data; /**< Vertex coordinates of the glyph quads. */
+   int          nvbo;          /**< Amount of glyph quads. */
+   int          mvbo;          /**< Amount of glyph quad memory. */
    glFontGlyph *glyphs;        /**< Unicode glyphs. */
    int          lut[HASH_LUT_SIZE]; /**< Look up table. */
 
@@ -176,17 +186,19 @@ static uint32_t        font_nextChar( const char *s, size_t *i );
 /* Get unicode glyphs from cache. */
 static glFontGlyph *gl_fontGetGlyph( glFontStash *stsh, uint32_t ch );
 /* Render.
- * TODO this should be changed to be more like font-stash
- * (https://github.com/akrinke/Font-Stash) In particular, instead of writing
- * char by char, they should be batched up by textures and rendered when
- * gl_fontRenderEnd() is called, saving lots of opengl calls.
+ * Glyphs are batched up and only drawn when the texture or colour changes, or
+ * when gl_fontRenderEnd() is called, saving lots of opengl calls.
  */
 static void gl_fontRenderStart( const glFontStash *stsh, double x, double y,
                                 const glColour *c, double outlineR );
 static void gl_fontRenderStartH( const glFontStash *stsh, const mat4 *H,
                                  const glColour *c, double outlineR );
+static void gl_fontRenderLine( const glFontStash *stsh, double dy,
+                               const glColour *c );
 static int  gl_fontRenderGlyph( glFontStash *stsh, uint32_t ch,
                                 const glColour *c, int state );
+static void gl_fontRenderColour( const glColour *col, double a );
+static void gl_fontRenderFlush( void );
 static void gl_fontRenderEnd( void );
 /* Fussy layout concerns. */
 static void gl_fontKernStart( void );
@@ -306,7 +318,7 @@ static int gl_fontAddGlyphTex( glFontStash *stsh, font_char_t *ch,
    /* Check for error. */
    gl_checkErr();
 
-   /* Update VBOs. */
+   /* Store the quad. */
    stsh->nvbo++;
    if ( stsh->nvbo > stsh->mvbo ) {
       stsh->mvbo *= 2;
@@ -372,9 +384,6 @@ static int gl_fontAddGlyphTex( glFontStash *stsh, font_char_t *ch,
    vbo_vert[5] = vy;
    vbo_vert[6] = vx + vw; /* Bottom right. */
    vbo_vert[7] = vy;
-   /* Update vbos. */
-   gl_vboData( stsh->vbo_tex, sizeof( GLfloat ) * n, stsh->vbo_tex_data );
-   gl_vboData( stsh->vbo_vert, sizeof( GLshort ) * n, stsh->vbo_vert_data );
 
    /* Add space for the new character. */
    gr->x += ch->w;
@@ -383,12 +392,6 @@ static int gl_fontAddGlyphTex( glFontStash *stsh, font_char_t *ch,
    glyph->vbo_id    = ( n - 8 ) / 2;
    glyph->tex_index = tex - stsh->tex;
 
-   /* Since the VBOs have possibly changed, we have to reset the data. */
-   gl_vboActivateAttribOffset( stsh->vbo_vert, shaders.font.vertex, 0, 2,
-                               GL_SHORT, 0 );
-   gl_vboActivateAttribOffset( stsh->vbo_tex, shaders.font.tex_coord, 0, 2,
-                               GL_FLOAT, 0 );
-
    return 0;
 }
 
@@ -897,8 +900,8 @@ int gl_printTextRaw( const glFont *ft_font, const int width, const int height,
                      double outlineR, const char *text )
 {
    glPrintLineIterator iter;
-   int                 s;
-   double              x, y;
+   int                 s, started;
+   double              x, y, y0;
    uint32_t            ch;
    NTracingZone( _ctx, 1 );
 
@@ -906,8 +909,9 @@ int gl_printTextRaw( const glFont *ft_font, const int width, const int height,
       ft_font = &gl_defFont;
    glFontStash *stsh = gl_fontGetStash( ft_font );
 
-   x = bx;
-   y = by + height - (double)ft_font->h; /* y is top left corner */
+   x  = bx;
+   y  = by + height - (double)ft_font->h; /* y is top left corner */
+   y0 = y;
 
    /* Default to 1.5 line height. */
    if ( line_height == 0 )
@@ -916,22 +920,28 @@ int gl_printTextRaw( const glFont *ft_font, const int width, const int height,
    /* Clears restoration. */
    gl_printRestoreClear();
 
-   s = 0;
+   s       = 0;
+   started = 0;
    gl_printLineIteratorInit( &iter, ft_font, text, width );
    while ( ( y - by > -DOUBLE_TOL ) && gl_printLineIteratorNext( &iter ) ) {
       /* Must restore stuff. */
       gl_printRestoreLast();
 
-      /* Render it. */
-      gl_fontRenderStart( stsh, x, y, c, outlineR );
+      /* Render it, batching all the lines together. */
+      if ( !started ) {
+         gl_fontRenderStart( stsh, x, y, c, outlineR );
+         started = 1;
+      } else
+         gl_fontRenderLine( stsh, y - y0, c );
       for ( size_t i = iter.l_begin; i < iter.l_end; ) {
          ch = u8_nextchar( text, &i );
          s  = gl_fontRenderGlyph( stsh, ch, c, s );
       }
-      gl_fontRenderEnd();
 
       y -= line_height; /* move position down */
    }
+   if ( started )
+      gl_fontRenderEnd();
 
    NTracingZoneEnd( _ctx );
    return 0;
@@ -1349,6 +1359,7 @@ static void gl_fontRenderStartH( const glFontStash *stsh, const mat4 *H,
 {
    double          a, scale;
    const glColour *col;
+   mat4            projection;
 
    outlineR = ( outlineR == -1 ) ? 1 : MAX( outlineR, 0 );
 
@@ -1362,32 +1373,74 @@ static void gl_fontRenderStartH( const glFontStash *stsh, const mat4 *H,
       col = c;
 
    glUseProgram( shaders.font.program );
-   gl_uniformAColour( shaders.font.colour, col, a );
-   if ( outlineR == 0. )
+   font_batchCol.a = -1.; /* Force the colour to be set. */
+   gl_fontRenderColour( col, a );
+   if ( outlineR == 0. ) {
       gl_uniformAColour( shaders.font.outline_colour, col, 0. );
-   else
+      font_outlineCol = col;
+   } else {
       gl_uniformAColour( shaders.font.outline_colour, &cGrey10, a );
+      font_outlineCol = NULL;
+   }
 
-   scale               = (double)stsh->h / FONT_DISTANCE_FIELD_SIZE;
-   font_projection_mat = *H;
-   mat4_scale( &font_projection_mat, scale, scale, 1 );
+   /* Glyphs are positioned relative to this, in distance field units. */
+   scale      = (double)stsh->h / FONT_DISTANCE_FIELD_SIZE;
+   projection = *H;
+   mat4_scale( &projection, scale, scale, 1 );
+   gl_uniformMat4( shaders.font.projection, &projection );
+   font_penX = 0.;
+   font_penY = 0.;
 
    font_restoreLast = 0;
    gl_fontKernStart();
 
-   /* Activate the appropriate VBOs. */
+   if ( font_batch == NULL )
+      font_batch = array_create( GLfloat );
    glEnableVertexAttribArray( shaders.font.vertex );
-   gl_vboActivateAttribOffset( stsh->vbo_vert, shaders.font.vertex, 0, 2,
-                               GL_SHORT, 0 );
    glEnableVertexAttribArray( shaders.font.tex_coord );
-   gl_vboActivateAttribOffset( stsh->vbo_tex, shaders.font.tex_coord, 0, 2,
-                               GL_FLOAT, 0 );
+   glEnableVertexAttribArray( shaders.font.vertex_m );
 
    /* Depth testing is used to draw the outline under the glyph. */
    if ( outlineR > 0. )
       glEnable( GL_DEPTH_TEST );
 }
 
+/**
+ * @brief Starts a new line dy pixels vertically away from where the rendering
+ * started.
+ *
+ * Same as ending the rendering and starting it again at the new line, except
+ *  that the glyphs keep being batched.
+ */
+static void gl_fontRenderLine( const glFontStash *stsh, double dy,
+                               const glColour *c )
+{
+   double          a, scale;
+   const glColour *col;
+
+   /* Handle colour, like gl_fontRenderStartH(). */
+   a = ( c == NULL ) ? 1. : c->a;
+   if ( font_restoreLast )
+      col = ( font_lastCol == NULL ) ? &cWhite : font_lastCol;
+   else if ( c == NULL )
+      col = &cWhite;
+   else
+      col = c;
+   gl_fontRenderColour( col, a );
+   if ( ( font_outlineCol != NULL ) && ( font_outlineCol != col ) ) {
+      gl_fontRenderFlush();
+      gl_uniformAColour( shaders.font.outline_colour, col, 0. );
+      font_outlineCol = col;
+   }
+
+   scale     = (double)stsh->h / FONT_DISTANCE_FIELD_SIZE;
+   font_penX = 0.;
+   font_penY = dy / scale;
+
+   font_restoreLast = 0;
+   gl_fontKernStart();
+}
+
 /**
  * @brief Gets the colour from a character.
  */
@@ -1573,6 +1626,10 @@ static int gl_fontRenderGlyph( glFontStash *stsh, uint32_t ch,
    double       scale;
    int          kern_adv_x;
    glFontGlyph *glyph;
+   GLuint       tex;
+   GLfloat     *v;
+   /* Corners of the quad in the glyph data, as two triangles. */
+   const int corners[6] = { 0, 1, 2, 1, 3, 2 };
 
    /* Handle escape sequences. */
    if ( ( ch == FONT_COLOUR_CODE ) && ( state == 0 ) ) { /* Start sequence. */
@@ -1582,11 +1639,11 @@ static int gl_fontRenderGlyph( glFontStash *stsh, uint32_t ch,
       const glColour *col = gl_fontGetColour( ch );
       double          a   = ( c == NULL ) ? 1. : c->a;
       if ( col != NULL )
-         gl_uniformAColour( shaders.font.colour, col, a );
+         gl_fontRenderColour( col, a );
       else if ( c == NULL )
-         gl_uniformColour( shaders.font.colour, &cWhite );
+         gl_fontRenderColour( &cWhite, a );
       else
-         gl_uniformColour( shaders.font.colour, c );
+         gl_fontRenderColour( c, a );
       font_lastCol = col;
       return 0;
    }
@@ -1602,31 +1659,99 @@ static int gl_fontRenderGlyph( glFontStash *stsh, uint32_t ch,
    /* Kern if possible. */
    scale      = (double)stsh->h / FONT_DISTANCE_FIELD_SIZE;
    kern_adv_x = gl_fontKernGlyph( stsh, ch, glyph );
-   if ( kern_adv_x )
-      mat4_translate_x( &font_projection_mat, kern_adv_x / scale );
-
-   /* Activate texture. */
-   glBindTexture( GL_TEXTURE_2D, stsh->tex[glyph->tex_index].id );
+   font_penX += kern_adv_x / scale;
 
-   glUniform1f( shaders.font.m, glyph->m );
-   gl_uniformMat4( shaders.font.projection, &font_projection_mat );
+   /* Glyphs on another texture have to be drawn separately. */
+   tex = stsh->tex[glyph->tex_index].id;
+   if ( tex != font_batchTex ) {
+      gl_fontRenderFlush();
+      font_batchTex = tex;
+   }
 
-   /* Draw the element. */
-   glDrawArrays( GL_TRIANGLE_STRIP, glyph->vbo_id, 4 );
+   /* Queue the quad of the glyph as two triangles. */
+   array_resize( &font_batch,
+                 array_size( font_batch ) + 6 * FONT_BATCH_VERTEX );
+   v = &font_batch[array_size( font_batch ) - 6 * FONT_BATCH_VERTEX];
+   for ( int i = 0; i < 6; i++ ) {
+      int k = 2 * ( glyph->vbo_id + corners[i] );
+      v[0]  = stsh->vbo_vert_data[k] + font_penX;
+      v[1]  = stsh->vbo_vert_data[k + 1] + font_penY;
+      v[2]  = stsh->vbo_tex_data[k];
+      v[3]  = stsh->vbo_tex_data[k + 1];
+      v[4]  = glyph->m;
+      v += FONT_BATCH_VERTEX;
+   }
 
-   /* Translate matrix. */
-   mat4_translate_x( &font_projection_mat, glyph->adv_x / scale );
+   /* Advance the pen. */
+   font_penX += glyph->adv_x / scale;
 
    return 0;
 }
 
+/**
+ * @brief Sets the colour of the glyphs, drawing the batched ones first if it
+ * changes.
+ *
+ *    @param col Colour to use.
+ *    @param a Alpha to use instead of the one of the colour.
+ */
+static void gl_fontRenderColour( const glColour *col, double a )
+{
+   glColour c = { .r = col->r, .g = col->g, .b = col->b, .a = a };
+   if ( memcmp( &c, &font_batchCol, sizeof( glColour ) ) == 0 )
+      return;
+   gl_fontRenderFlush();
+   gl_uniformColour( shaders.font.colour, &c );
+   font_batchCol = c;
+}
+
+/**
+ * @brief Draws the batched glyphs in a single draw call.
+ */
+static void gl_fontRenderFlush( void )
+{
+   const GLsizei stride = sizeof( GLfloat ) * FONT_BATCH_VERTEX;
+   GLsizei       size   = sizeof( GLfloat ) * array_size( font_batch );
+
+   if ( size <= 0 )
+      return;
+
+   /* Upload, growing the VBO if necessary. */
+   if ( font_batchVBO == NULL )
+      font_batchVBO = gl_vboCreateStream( 0, NULL );
+   if ( size > font_batchSize ) {
+      gl_vboData( font_batchVBO, size, font_batch );
+      font_batchSize = size;
+   } else
+      gl_vboSubData( font_batchVBO, 0, size, font_batch );
+
+   gl_vboActivateAttribOffset( font_batchVBO, shaders.font.vertex, 0, 2,
+                               GL_FLOAT, stride );
+   gl_vboActivateAttribOffset( font_batchVBO, shaders.font.tex_coord,
+                               sizeof( GLfloat ) * 2, 2, GL_FLOAT, stride );
+   gl_vboActivateAttribOffset( font_batchVBO, shaders.font.vertex_m,
+                               sizeof( GLfloat ) * 4, 1, GL_FLOAT, stride );
+
+   glBindTexture( GL_TEXTURE_2D, font_batchTex );
+   glDrawArrays( GL_TRIANGLES, 0,
+                 array_size( font_batch ) / FONT_BATCH_VERTEX );
+
+   /* Keep the memory around for the next flush. */
+   array_erase( &font_batch, array_begin( font_batch ),
+                array_end( font_batch ) );
+}
+
 /**
  * @brief Ends the rendering engine.
  */
 static void gl_fontRenderEnd( void )
 {
+   gl_fontRenderFlush();
+   font_batchTex = 0;
+
    glDisableVertexAttribArray( shaders.font.vertex );
    glDisableVertexAttribArray( shaders.font.tex_coord );
+   glDisableVertexAttribArray( shaders.font.vertex_m );
    glUseProgram( 0 );
 
    glDisable( GL_DEPTH_TEST );
@@ -1753,14 +1878,10 @@ int gl_fontInit( glFont *font, const char *fname, const unsigned int h,
    stsh->glyphs = array_create( glFontGlyph );
    stsh->tex    = array_create( glFontTex );
 
-   /* Set up VBOs. */
+   /* Set up glyph quads. */
    stsh->mvbo          = 256;
    stsh->vbo_tex_data  = calloc( 8 * stsh->mvbo, sizeof( GLfloat ) );
    stsh->vbo_vert_data = calloc( 8 * stsh->mvbo, sizeof( GLshort ) );
-   stsh->vbo_tex       = gl_vboCreateStatic( sizeof( GLfloat ) * 8 * stsh->mvbo,
-                                             stsh->vbo_tex_data );
-   stsh->vbo_vert      = gl_vboCreateStatic( sizeof( GLshort ) * 8 * stsh->mvbo,
-                                             stsh->vbo_vert_data );
 
    return 0;
 }
@@ -1900,8 +2021,6 @@ void gl_freeFont( glFont *font )
    array_free( stsh->tex );
 
    array_free( stsh->glyphs );
-   gl_vboDestroy( stsh->vbo_tex );
-   gl_vboDestroy( stsh->vbo_vert );
    free( stsh->vbo_tex_data );
    free( stsh->vbo_vert_data );
 
@@ -1933,4 +2052,9 @@ void gl_fontExit( void )
    font_library = NULL;
    array_free( avail_fonts );
    avail_fonts = NULL;
+   gl_vboDestroy( font_batchVBO );
+   font_batchVBO  = NULL;
+   font_batchSize = 0;
+   array_free( font_batch );
+   font_batch = NULL;
 }
@@ -73,10 +73,11 @@ typedef enum HookType_e {
  * @brief Internal representation of a hook.
  */
 typedef struct Hook_ {
-   struct Hook_ *next; /**< Linked list. */
+   struct Hook_ *next;  /**< Linked list. */
+   struct Hook_ *snext; /**< Linked list of the hooks in the same stack. */
 
    unsigned int id;      /**< unique id */
-   char        *stack;   /**< stack it's a part of */
+   const char  *stack;   /**< stack it's a part of, interned */
    int          created; /**< Hook has just been created. */
    int delete;           /**< indicates it should be deleted when possible */
    int ran_once; /**< Indicates if the hook already ran, useful when iterating.
@@ -109,9 +110,21 @@ typedef struct Hook_ {
    } u; /**< Type specific data. */
 } Hook;
 
+/**
+ * @brief Interned hook stack with the hooks that belong to it.
+ */
+typedef struct HookStack_ {
+   char *name; /**< Name of the stack. */
+   Hook *list; /**< Hooks in the stack, in the same order as hook_list. */
+} HookStack;
+
 /*
  * the stack
  */
+static HookStack *hook_stacks =
+   NULL; /**< Array (array.h): Interned stacks, indexed by ID. */
+static int *hook_stacks_sorted =
+   NULL; /**< Array (array.h): Stack IDs sorted by name, for look ups. */
 static unsigned int hook_id           = 0;    /**< Unique hook id generator. */
 static Hook        *hook_list         = NULL; /**< Stack of hooks. */
 static int          hook_runningstack = 0;    /**< Check if stack is running. */
@@ -124,6 +137,8 @@ static int hook_loadingstack = 0; /**< Check if the hooks are being loaded. */
 static int  hooks_executeParam( const char *stack, const HookParam *param );
 static void hooks_updateDateExecute( ntime_t change );
 /* intern */
+static int          hook_stackFind( const char *stack, int *pos );
+static int          hook_stackGet( const char *stack );
 static void         hook_rmRaw( Hook *h );
 static void         hooks_purgeList( void );
 static Hook        *hook_get( unsigned int id );
@@ -458,6 +473,69 @@ static int hook_run( Hook *hook, const HookParam *param, int claims )
    return ret;
 }
 
+/**
+ * @brief Looks up an interned hook stack.
+ *
+ *    @param stack Name of the stack to look up.
+ *    @param[out] pos Position in hook_stacks_sorted where it is or should be
+ * inserted. Can be NULL.
+ *    @return ID of the stack or -1 if it doesn't exist.
+ */
+static int hook_stackFind( const char *stack, int *pos )
+{
+   int lo = 0;
+   int hi = array_size( hook_stacks_sorted );
+   while ( lo < hi ) {
+      int mid = ( lo + hi ) / 2;
+      int sid = hook_stacks_sorted[mid];
+      int cmp = strcmp( stack, hook_stacks[sid].name );
+      if ( cmp == 0 ) {
+         if ( pos != NULL )
+            *pos = mid;
+         return sid;
+      }
+      if ( cmp < 0 )
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   if ( pos != NULL )
+      *pos = lo;
+   return -1;
+}
+
+/**
+ * @brief Gets the ID of a hook stack, interning it if necessary.
+ *
+ *    @param stack Name of the stack to get.
+ *    @return ID of the stack.
+ */
+static int hook_stackGet( const char *stack )
+{
+   int        pos, sid;
+   HookStack *hs;
+
+   sid = hook_stackFind( stack, &pos );
+   if ( sid >= 0 )
+      return sid;
+
+   if ( hook_stacks == NULL ) {
+      hook_stacks        = array_create( HookStack );
+      hook_stacks_sorted = array_create( int );
+   }
+   sid      = array_size( hook_stacks );
+   hs       = &array_grow( &hook_stacks );
+   hs->name = strdup( stack );
+   hs->list = NULL;
+
+   /* Keep the look up table sorted. */
+   array_resize( &hook_stacks_sorted, array_size( hook_stacks_sorted ) + 1 );
+   memmove( &hook_stacks_sorted[pos + 1], &hook_stacks_sorted[pos],
+            ( array_size( hook_stacks_sorted ) - pos - 1 ) * sizeof( int ) );
+   hook_stacks_sorted[pos] = sid;
+   return sid;
+}
+
 /**
  * @brief Generates a new hook id.
  *
@@ -490,18 +568,18 @@ static Hook *hook_new( HookType_t type, const char *stack )
 {
    /* Get and create new hook. */
    Hook *new_hook = calloc( 1, sizeof( Hook ) );
-   if ( hook_list == NULL )
-      hook_list = new_hook;
-   else {
-      /* Put at front, O(1). */
-      new_hook->next = hook_list;
-      hook_list      = new_hook;
-   }
+   int   sid      = hook_stackGet( stack );
+
+   /* Put at front, O(1). Same for the stack so the order matches. */
+   new_hook->next        = hook_list;
+   hook_list             = new_hook;
+   new_hook->snext       = hook_stacks[sid].list;
+   hook_stacks[sid].list = new_hook;
 
    /* Fill out generic details. */
    new_hook->type    = type;
    new_hook->id      = hook_genID();
-   new_hook->stack   = strdup( stack );
+   new_hook->stack   = hook_stacks[sid].name;
    new_hook->created = 1;
 
    /** @TODO fix this hack. */
@@ -629,6 +707,17 @@ static void hooks_purgeList( void )
    if ( hook_runningstack )
       return;
 
+   /* Unlink from the stacks first, they get freed below. */
+   for ( int i = 0; i < array_size( hook_stacks ); i++ ) {
+      Hook **hp = &hook_stacks[i].list;
+      while ( *hp != NULL ) {
+         if ( ( *hp )->delete )
+            *hp = ( *hp )->snext;
+         else
+            hp = &( *hp )->snext;
+      }
+   }
+
    /* Second pass to delete. */
    hl = NULL;
    h  = hook_list;
@@ -671,19 +760,26 @@ void hooks_updateDate( ntime_t change )
  */
 static void hooks_updateDateExecute( ntime_t change )
 {
+   int sid;
+
    /* Don't update without player. */
    if ( ( player.p == NULL ) || player_isFlag( PLAYER_CREATING ) )
       return;
 
+   /* Date hooks are all in the "date" stack. */
+   sid = hook_stackFind( "date", NULL );
+   if ( sid < 0 )
+      return;
+
    /* Clear creation flags. */
-   for ( Hook *h = hook_list; h != NULL; h = h->next )
+   for ( Hook *h = hook_stacks[sid].list; h != NULL; h = h->snext )
       h->created = 0;
 
    /* On j=0 we increment all timers and try to run, then on j=1 we update the
     * timers. */
    hook_runningstack++; /* running hooks */
    for ( int j = 1; j >= 0; j-- ) {
-      for ( Hook *h = hook_list; h != NULL; h = h->next ) {
+      for ( Hook *h = hook_stacks[sid].list; h != NULL; h = h->snext ) {
          /* Not be deleting. */
          if ( h->delete )
             continue;
@@ -757,19 +853,25 @@ unsigned int hook_addDateEvt( unsigned int parent, const char *func,
 void hooks_update( double dt )
 {
    Hook *h;
+   int   sid;
 
    /* Don't update without player. */
    if ( ( player.p == NULL ) || player_isFlag( PLAYER_CREATING ) ||
         player_isFlag( PLAYER_DESTROYED ) )
       return;
 
+   /* Timer hooks are all in the "timer" stack. */
+   sid = hook_stackFind( "timer", NULL );
+   if ( sid < 0 )
+      return;
+
    /* Clear creation flags. */
-   for ( h = hook_list; h != NULL; h = h->next )
+   for ( h = hook_stacks[sid].list; h != NULL; h = h->snext )
       h->created = 0;
 
    hook_runningstack++; /* running hooks */
    for ( int j = 1; j >= 0; j-- ) {
-      for ( h = hook_list; h != NULL; h = h->next ) {
+      for ( h = hook_stacks[sid].list; h != NULL; h = h->snext ) {
          /* Not be deleting. */
          if ( h->delete )
             continue;
@@ -891,23 +993,28 @@ int hook_hasEventParent( unsigned int parent )
 
 static int hooks_executeParam( const char *stack, const HookParam *param )
 {
-   int run;
+   int run, sid;
 
    /* Don't update if player is dead. */
    if ( ( player.p == NULL ) || player_isFlag( PLAYER_DESTROYED ) )
       return 0;
 
+   /* Only the hooks of the stack are looked at. If it was never interned, it
+    * has no hooks. */
+   run = 0;
+   sid = hook_stackFind( stack, NULL );
+   if ( sid < 0 )
+      goto cleanup;
+
    /* Reset the current stack's ran and creation flags. */
-   for ( Hook *h = hook_list; h != NULL; h = h->next )
-      if ( strcmp( stack, h->stack ) == 0 ) {
-         h->ran_once = 0;
-         h->created  = 0;
-      }
+   for ( Hook *h = hook_stacks[sid].list; h != NULL; h = h->snext ) {
+      h->ran_once = 0;
+      h->created  = 0;
+   }
 
-   run = 0;
    hook_runningstack++; /* running hooks */
    for ( int j = 1; j >= 0; j-- ) {
-      for ( Hook *h = hook_list; h != NULL; h = h->next ) {
+      for ( Hook *h = hook_stacks[sid].list; h != NULL; h = h->snext ) {
          /* Should be deleted. */
          if ( h->delete )
             continue;
@@ -917,9 +1024,6 @@ static int hooks_executeParam( const char *stack, const HookParam *param )
          /* Don't update newly created hooks. */
          if ( h->created != 0 )
             continue;
-         /* Doesn't match stack. */
-         if ( strcmp( stack, h->stack ) != 0 )
-            continue;
 
          /* Run hook. */
          hook_run( h, param, j );
@@ -934,6 +1038,7 @@ static int hooks_executeParam( const char *stack, const HookParam *param )
    }
    hook_runningstack--; /* not running hooks anymore */
 
+cleanup:
    /* Free reference parameters. */
    if ( param != NULL ) {
       int n = 0;
@@ -1113,9 +1218,6 @@ static void hook_free( Hook *h )
    /* Remove from all the pilots. */
    pilots_rmHook( h->id );
 
-   /* Generic freeing. */
-   free( h->stack );
-
    /* Free type specific. */
    switch ( h->type ) {
    case HOOK_TYPE_MISN:
@@ -1151,6 +1253,14 @@ void hook_cleanup( void )
    }
    /* safe defaults just in case */
    hook_list = NULL;
+
+   /* Clear interned stacks. */
+   for ( int i = 0; i < array_size( hook_stacks ); i++ )
+      free( hook_stacks[i].name );
+   array_free( hook_stacks );
+   array_free( hook_stacks_sorted );
+   hook_stacks        = NULL;
+   hook_stacks_sorted = NULL;
 }
 
 /**
@@ -163,6 +163,8 @@ static void map_selectCur( void );
 static void map_genModeList( void );
 static void map_update_commod_av_price();
 static void map_onClose( unsigned int wid, const char *str );
+/* Pathfinding. */
+static void A_free( void );
 
 /**
  * @brief Initializes the map subsystem.
@@ -186,6 +188,9 @@ void map_exit( void )
       decorator_stack = NULL;
    }
 
+   /* Pathfinding. */
+   A_free();
+
    ovr_exit();
 }
 
@@ -2788,141 +2793,114 @@ void map_toggleNotes()
  * @brief Node structure for A* pathfinding.
  */
 typedef struct SysNode_ {
-   struct SysNode_ *next;  /**< Next node */
-   struct SysNode_ *gnext; /**< Next node in the garbage collector. */
-
    struct SysNode_ *parent; /**< Parent node. */
    StarSystem      *sys;    /**< System in node. */
    int              g;      /**< step */
    double           d;      /**< the distance to go access the systems. */
    const vec2      *pos;    /**< position of the entry of the system. */
+   unsigned int     seq;    /**< Order the node was opened in, breaks ties. */
+   unsigned int     visit;  /**< Search the node was last touched by. */
+   int              heap;   /**< Position in the open heap, -1 if not open. */
+   int              closed; /**< Whether or not the node is closed. */
 } SysNode;                  /**< System Node for use in A* pathfinding. */
-static SysNode *A_gc;
+static SysNode *A_nodes =
+   NULL; /**< Array (array.h): Nodes of the search, indexed by system id. */
+static SysNode **A_open =
+   NULL; /**< Array (array.h): Open nodes, as a binary heap. */
+static unsigned int A_visit = 0; /**< Current search. */
+static unsigned int A_seq   = 0; /**< Open node counter of the search. */
+static int         *A_jumpdist[2] = {
+   NULL, NULL }; /**< Jump counts between all systems, ignoring whether they
+                        are known, without and with hidden jumps. */
+static int A_jumpdist_n = 0; /**< Number of systems in A_jumpdist. */
 /* prototypes */
-static SysNode *A_newNode( StarSystem *sys );
-static int      A_g( const SysNode *n );
-static double   A_d( const SysNode *n );
+static SysNode *A_node( const StarSystem *sys );
 static int      A_less( const SysNode *op1, const SysNode *op2 );
-static SysNode *A_add( SysNode *first, SysNode *cur );
-static SysNode *A_rm( SysNode *first, const StarSystem *cur );
-static SysNode *A_in( SysNode *first, const StarSystem *cur );
-static SysNode *A_lowest( SysNode *first );
-static void     A_freeList( SysNode *first );
+static void     A_heapUp( int i );
+static void     A_heapDown( int i );
+static void     A_push( SysNode *n );
+static SysNode *A_pop( void );
+static void     A_jumpDistCompute( int show_hidden );
 static int      map_decorator_parse( MapDecorator *temp, const char *file );
-/** @brief Creates a new node link to star system. */
-static SysNode *A_newNode( StarSystem *sys )
-{
-   SysNode *n = malloc( sizeof( SysNode ) );
-
-   n->next = NULL;
-   n->sys  = sys;
-
-   n->gnext = A_gc;
-   A_gc     = n;
-
+/** @brief Gets the node of a system for the current search, resetting it if it
+ * is from an older one. */
+static SysNode *A_node( const StarSystem *sys )
+{
+   SysNode *n = &A_nodes[sys->id];
+   if ( n->visit != A_visit ) {
+      n->visit  = A_visit;
+      n->sys    = (StarSystem *)sys;
+      n->heap   = -1;
+      n->closed = 0;
+   }
    return n;
 }
-/** @brief Gets the g from a node. */
-static int A_g( const SysNode *n )
-{
-   return n->g;
-}
-/** @brief Gets the d from a node. */
-static double A_d( const SysNode *n )
-{
-   return n->d;
-}
-/** @brief op1 is less than op2. */
+/** @brief op1 is less than op2. Ties go to the node opened first. */
 static int A_less( const SysNode *op1, const SysNode *op2 )
 {
-   return ( A_g( op1 ) < A_g( op2 ) ) ||
-          ( A_g( op1 ) == A_g( op2 ) && A_d( op1 ) < A_d( op2 ) );
+   if ( op1->g != op2->g )
+      return op1->g < op2->g;
+   if ( op1->d != op2->d )
+      return op1->d < op2->d;
+   return op1->seq < op2->seq;
 }
-/** @brief Adds a node to the linked list. */
-static SysNode *A_add( SysNode *first, SysNode *cur )
+/** @brief Moves a node up the open heap until it's in place. */
+static void A_heapUp( int i )
 {
-   SysNode *n;
-
-   if ( first == NULL )
-      return cur;
-
-   n = first;
-   while ( n->next != NULL )
-      n = n->next;
-   n->next = cur;
-
-   return first;
-}
-/* @brief Removes a node from a linked list. */
-static SysNode *A_rm( SysNode *first, const StarSystem *cur )
-{
-   SysNode *n, *p;
-
-   if ( first->sys == cur ) {
-      n           = first->next;
-      first->next = NULL;
-      return n;
-   }
-
-   p = first;
-   n = p->next;
-   do {
-      if ( n->sys == cur ) {
-         p->next = n->next;
-         n->next = NULL;
+   SysNode *n = A_open[i];
+   while ( i > 0 ) {
+      int p = ( i - 1 ) / 2;
+      if ( !A_less( n, A_open[p] ) )
          break;
-      }
-      p = n;
-   } while ( ( n = n->next ) != NULL );
-
-   return first;
-}
-/** @brief Checks to see if node is in linked list. */
-static SysNode *A_in( SysNode *first, const StarSystem *cur )
-{
-   SysNode *n;
-
-   if ( first == NULL )
-      return NULL;
-
-   n = first;
-   do {
-      if ( n->sys == cur )
-         return n;
-   } while ( ( n = n->next ) != NULL );
-   return NULL;
+      A_open[i]       = A_open[p];
+      A_open[i]->heap = i;
+      i               = p;
+   }
+   A_open[i] = n;
+   n->heap   = i;
 }
-/** @brief Returns the lowest ranking node from a linked list of nodes. */
-static SysNode *A_lowest( SysNode *first )
+/** @brief Moves a node down the open heap until it's in place. */
+static void A_heapDown( int i )
 {
-   SysNode *lowest, *n;
-
-   if ( first == NULL )
-      return NULL;
-
-   n      = first;
-   lowest = n;
-   do {
-      if ( A_less( n, lowest ) )
-         lowest = n;
-   } while ( ( n = n->next ) != NULL );
-   return lowest;
+   int      size = array_size( A_open );
+   SysNode *n    = A_open[i];
+   while ( 1 ) {
+      int c = 2 * i + 1;
+      if ( c >= size )
+         break;
+      if ( ( c + 1 < size ) && A_less( A_open[c + 1], A_open[c] ) )
+         c++;
+      if ( !A_less( A_open[c], n ) )
+         break;
+      A_open[i]       = A_open[c];
+      A_open[i]->heap = i;
+      i               = c;
+   }
+   A_open[i] = n;
+   n->heap   = i;
 }
-/** @brief Frees a linked list. */
-static void A_freeList( SysNode *first )
+/** @brief Adds a node to the open heap, or updates it if already there. */
+static void A_push( SysNode *n )
 {
-   SysNode *p, *n;
-
-   if ( first == NULL )
-      return;
-
-   p = NULL;
-   n = first;
-   do {
-      free( p );
-      p = n;
-   } while ( ( n = n->gnext ) != NULL );
-   free( p );
+   n->seq = A_seq++;
+   if ( n->heap < 0 ) {
+      array_push_back( &A_open, n );
+      n->heap = array_size( A_open ) - 1;
+   }
+   /* Updated nodes always get a lower cost, so they can only go up. */
+   A_heapUp( n->heap );
+}
+/** @brief Removes the lowest ranking node from the open heap. */
+static SysNode *A_pop( void )
+{
+   SysNode *n    = A_open[0];
+   int      last = array_size( A_open ) - 1;
+   A_open[0]     = A_open[last];
+   array_resize( &A_open, last );
+   if ( last > 0 )
+      A_heapDown( 0 );
+   n->heap = -1;
+   return n;
 }
 
 /** @brief Sets map_zoom to zoom and recreates the faction disk texture. */
@@ -2952,14 +2930,10 @@ StarSystem **map_getJumpPath( StarSystem *sysstart, const vec2 *posstart,
                               int show_hidden, StarSystem **old_data,
                               double *o_distance )
 {
-   int         j, ojumps;
+   int         j, ojumps, nsys;
    StarSystem *ssys, *esys, **res;
+   SysNode    *cur;
 
-   SysNode *cur, *neighbour;
-   SysNode *open, *closed;
-   SysNode *ocost, *ccost;
-
-   A_gc   = NULL;
    res    = old_data;
    ojumps = array_size( old_data );
 
@@ -2997,18 +2971,34 @@ StarSystem **map_getJumpPath( StarSystem *sysstart, const vec2 *posstart,
       }
    }
 
-   /* start the linked lists */
-   open = closed = NULL;
-   cur           = A_newNode( ssys );
-   cur->parent   = NULL;
-   cur->g        = 0;
-   cur->d        = 0.0;
-   cur->pos      = p_pos_entry;
-   open = A_add( open, cur ); /* Initial open node is the start system */
+   /* Set up the nodes, they are reused between searches. */
+   nsys = array_size( system_getAll() );
+   if ( A_nodes == NULL ) {
+      A_nodes = array_create_size( SysNode, nsys );
+      A_open  = array_create( SysNode * );
+   }
+   if ( array_size( A_nodes ) < nsys ) {
+      int n = array_size( A_nodes );
+      array_resize( &A_nodes, nsys );
+      memset( &A_nodes[n], 0, ( nsys - n ) * sizeof( SysNode ) );
+   }
+   A_visit++;
+   A_seq = 0;
+   array_resize( &A_open, 0 );
+
+   /* start the open heap */
+   cur         = A_node( ssys );
+   cur->parent = NULL;
+   cur->g      = 0;
+   cur->d      = 0.0;
+   cur->pos    = p_pos_entry;
+   A_push( cur ); /* Initial open node is the start system */
 
    j = 0;
-   while ( ( cur = A_lowest( open ) ) ) {
+   while ( array_size( A_open ) > 0 ) {
       int cost;
+      cur = A_open[0];
+
       /* End condition. */
       if ( cur->sys == esys )
          break;
@@ -3019,13 +3009,14 @@ StarSystem **map_getJumpPath( StarSystem *sysstart, const vec2 *posstart,
          break;
 
       /* Get best from open and toss to closed */
-      open   = A_rm( open, cur->sys );
-      closed = A_add( closed, cur );
-      cost = A_g( cur ) + 1; /* Base unit is jump and always increases by 1. */
+      A_pop();
+      cur->closed = 1;
+      cost = cur->g + 1; /* Base unit is jump and always increases by 1. */
 
       for ( int i = 0; i < array_size( cur->sys->jumps ); i++ ) {
          JumpPoint  *jp  = &cur->sys->jumps[i];
          StarSystem *sys = jp->target;
+         SysNode    *neighbour;
 
          /* Make sure it's reachable */
          if ( !ignore_known ) {
@@ -3041,40 +3032,35 @@ StarSystem **map_getJumpPath( StarSystem *sysstart, const vec2 *posstart,
          if ( !show_hidden && jp_isFlag( jp, JP_HIDDEN ) )
             continue;
 
+         /* Closed nodes can't be improved, as the jump count always goes up
+          * and it takes precedence over the distance. */
+         neighbour = A_node( sys );
+         if ( neighbour->closed )
+            continue;
+
          /* Update cost */
-         const SysNode n_cost = { .g = cost,
-                                  .d = A_d( cur ) +
-                                       ( ( cur->pos != NULL )
-                                            ? vec2_dist( cur->pos, &jp->pos )
-                                            : 0.0 ) };
-
-         /* Check to see if it's already in the closed set. */
-         ccost = A_in( closed, sys );
-         if ( ( ccost != NULL ) && !A_less( &n_cost, ccost ) )
+         const SysNode n_cost = { .g   = cost,
+                                  .d   = cur->d + ( ( cur->pos != NULL )
+                                                       ? vec2_dist( cur->pos,
+                                                                    &jp->pos )
+                                                       : 0.0 ),
+                                  .seq = A_seq };
+
+         /* Ignore if it's open and current is not better. */
+         if ( ( neighbour->heap >= 0 ) && !A_less( &n_cost, neighbour ) )
             continue;
-         // closed = A_rm( closed, sys );
-
-         /* Remove if it exists and current is better. */
-         ocost = A_in( open, sys );
-         if ( ocost != NULL ) {
-            if ( A_less( &n_cost, ocost ) )
-               open = A_rm( open, sys ); /* New path is better */
-            else
-               continue; /* This node is worse, so ignore it. */
-         }
 
-         /* Create the node. */
+         /* Set up the node. */
          const JumpPoint *jp_entry = jump_getTarget( cur->sys, sys );
-         neighbour                 = A_newNode( sys );
          neighbour->parent         = cur;
          neighbour->g              = n_cost.g;
          neighbour->d              = n_cost.d;
          neighbour->pos = ( jp_entry != NULL ) ? &jp_entry->pos : NULL;
-         open           = A_add( open, neighbour );
+         A_push( neighbour );
       }
 
       /* Safety check in case not linked. */
-      if ( open == NULL )
+      if ( array_size( A_open ) == 0 )
          break;
    }
 
@@ -3084,7 +3070,7 @@ StarSystem **map_getJumpPath( StarSystem *sysstart, const vec2 *posstart,
 
    /* Build path backwards if not broken from loop. */
    if ( cur != NULL && esys == cur->sys ) {
-      int njumps = A_g( cur ) + ojumps;
+      int njumps = cur->g + ojumps;
       assert( njumps > ojumps );
       if ( res == NULL )
          res = array_create_size( StarSystem *, njumps );
@@ -3099,11 +3085,107 @@ StarSystem **map_getJumpPath( StarSystem *sysstart, const vec2 *posstart,
       array_free( old_data );
    }
 
-   /* free the linked lists */
-   A_freeList( A_gc );
    return res;
 }
 
+/**
+ * @brief Computes the jump counts from every system with a breadth-first
+ * search.
+ *
+ *    @param show_hidden Whether or not to use hidden jump points.
+ */
+static void A_jumpDistCompute( int show_hidden )
+{
+   const StarSystem *systems = system_getAll();
+   int               n       = array_size( systems );
+   int              *queue   = malloc( n * sizeof( int ) );
+   int              *dist;
+
+   if ( A_jumpdist_n != n ) {
+      for ( int i = 0; i < 2; i++ ) {
+         free( A_jumpdist[i] );
+         A_jumpdist[i] = NULL;
+      }
+      A_jumpdist_n = n;
+   }
+   dist = malloc( (size_t)n * n * sizeof( int ) );
+
+   for ( int s = 0; s < n; s++ ) {
+      int *row  = &dist[(size_t)s * n];
+      int  head = 0;
+      int  tail = 0;
+      for ( int i = 0; i < n; i++ )
+         row[i] = -1;
+      row[s]        = 0;
+      queue[tail++] = s;
+      while ( head < tail ) {
+         const StarSystem *sys = &systems[queue[head++]];
+         for ( int i = 0; i < array_size( sys->jumps ); i++ ) {
+            const JumpPoint *jp = &sys->jumps[i];
+            int              t  = jp->target->id;
+            if ( jp_isFlag( jp, JP_EXITONLY ) )
+               continue;
+            if ( !show_hidden && jp_isFlag( jp, JP_HIDDEN ) )
+               continue;
+            if ( row[t] >= 0 )
+               continue;
+            row[t]        = row[sys->id] + 1;
+            queue[tail++] = t;
+         }
+      }
+   }
+
+   free( queue );
+   A_jumpdist[show_hidden] = dist;
+}
+
+/**
+ * @brief Gets the number of jumps between two systems, regardless of whether
+ * or not the player knows them.
+ *
+ * Gives the same jump count as map_getJumpPath() with ignore_known set, but
+ * uses a table of all the distances that is computed on first use.
+ *
+ *    @param sysstart System to start from.
+ *    @param sysend System to end at.
+ *    @param show_hidden Whether or not to use hidden jump points.
+ *    @return Number of jumps or -1 if there is no path.
+ */
+int map_jumpDist( const StarSystem *sysstart, const StarSystem *sysend,
+                  int show_hidden )
+{
+   show_hidden = !!show_hidden;
+   if ( ( A_jumpdist[show_hidden] == NULL ) ||
+        ( A_jumpdist_n != array_size( system_getAll() ) ) )
+      A_jumpDistCompute( show_hidden );
+   return A_jumpdist[show_hidden][(size_t)sysstart->id * A_jumpdist_n +
+                                  sysend->id];
+}
+
+/**
+ * @brief Frees the pathfinding data.
+ */
+static void A_free( void )
+{
+   array_free( A_nodes );
+   A_nodes = NULL;
+   array_free( A_open );
+   A_open = NULL;
+   map_jumpDistInvalidate();
+}
+
+/**
+ * @brief Invalidates the jump distance table, has to be called when jumps
+ * change.
+ */
+void map_jumpDistInvalidate( void )
+{
+   for ( int i = 0; i < 2; i++ ) {
+      free( A_jumpdist[i] );
+      A_jumpdist[i] = NULL;
+   }
+}
+
 /**
  * @brief Marks maps around a radius of currently system as known.
  *
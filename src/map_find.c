@@ -38,8 +38,6 @@ static char      **map_foundOutfitNames =
 /* Tech hack. */
 static tech_group_t **map_known_techs =
    NULL; /**< Array (array.h) of known techs. */
-static Spob **map_known_spobs =
-   NULL; /**< Array (array.h) of known spobs with techs. */
 
 /*
  * Prototypes.
@@ -87,7 +85,6 @@ static int map_knownInit( void )
 
    map_knownClean();
    map_known_techs = array_create( tech_group_t * );
-   map_known_spobs = array_create( Spob * );
 
    /* Get techs. */
    for ( int i = 0; i < array_size( sys ); i++ ) {
@@ -97,10 +94,8 @@ static int map_knownInit( void )
       for ( int j = 0; j < array_size( sys[i].spobs ); j++ ) {
          Spob *spob = sys[i].spobs[j];
 
-         if ( spob_isKnown( spob ) && spob->tech != NULL ) {
-            array_push_back( &map_known_spobs, spob );
+         if ( spob_isKnown( spob ) && spob->tech != NULL )
             array_push_back( &map_known_techs, spob->tech );
-         }
       }
    }
 
@@ -114,8 +109,6 @@ static void map_knownClean( void )
 {
    array_free( map_known_techs );
    map_known_techs = NULL;
-   array_free( map_known_spobs );
-   map_known_spobs = NULL;
 }
 
 /**
@@ -708,6 +701,7 @@ static int map_findSearchOutfits( unsigned int wid_map_find, const char *name )
    const char   *oname, *sysname;
    char        **list;
    const Outfit *o;
+   const int    *ids;
 
    assert( "Outfit search is not reentrant!" && map_foundOutfitNames == NULL );
 
@@ -748,24 +742,17 @@ static int map_findSearchOutfits( unsigned int wid_map_find, const char *name )
    if ( o == NULL )
       return -1;
 
-   /* Construct found table. */
+   /* Construct found table from the spobs that sell the outfit. */
    found = NULL;
    n     = 0;
-   len   = array_size( map_known_techs );
+   ids   = tech_getSpobsOutfit( o, &len );
    for ( int i = 0; i < len; i++ ) {
-      /* Try to find the outfit in the spob. */
-      int         j;
-      Spob       *spob;
       StarSystem *sys;
-      Outfit    **olist = tech_getOutfit( map_known_techs[i] );
-      for ( j = array_size( olist ) - 1; j >= 0; j-- )
-         if ( olist[j] == o )
-            break;
-      array_free( olist );
-      olist = NULL;
-      if ( j < 0 )
+      Spob       *spob = spob_getIndex( ids[i] );
+
+      /* Spob must be known. */
+      if ( !spob_isKnown( spob ) )
          continue;
-      spob = map_known_spobs[i];
 
       /* Must have an outfitter. */
       if ( !spob_hasService( spob, SPOB_SERVICE_OUTFITS ) )
@@ -853,7 +840,7 @@ static int map_findSearchShips( unsigned int wid_map_find, const char *name )
    const char *sname, *sysname;
    char      **list;
    const Ship *s;
-   Ship      **slist;
+   const int  *ids;
 
    /* Match spob first. */
    s     = NULL;
@@ -887,23 +874,16 @@ static int map_findSearchShips( unsigned int wid_map_find, const char *name )
    if ( s == NULL )
       return -1;
 
-   /* Construct found table. */
+   /* Construct found table from the spobs that sell the ship. */
    found = NULL;
    n     = 0;
-   len   = array_size( map_known_techs );
+   ids   = tech_getSpobsShip( s, &len );
    for ( int i = 0; i < len; i++ ) {
-      int j;
-
-      /* Try to find the ship in the spob. */
-      slist = tech_getShip( map_known_techs[i] );
-      for ( j = array_size( slist ) - 1; j >= 0; j-- )
-         if ( slist[j] == s )
-            break;
-      array_free( slist );
-      slist = NULL;
-      if ( j < 0 )
+      spob = spob_getIndex( ids[i] );
+
+      /* Spob must be known. */
+      if ( !spob_isKnown( spob ) )
          continue;
-      spob = map_known_spobs[i];
 
       /* Must have an shipyard. */
       if ( !spob_hasService( spob, SPOB_SERVICE_SHIPYARD ) )
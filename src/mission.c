@@ -38,6 +38,40 @@
 
 #define XML_MISSION_TAG "mission" /**< XML mission tag. */
 
+#define MIS_AVAIL_MAX ( MIS_AVAIL_ENTER + 1 ) /**< Number of locations. */
+
+/**
+ * @brief Entry of a mission bucket keyed by spob or system name.
+ */
+typedef struct MissionNameIdx_ {
+   const char *name; /**< Name of the spob or system, owned by the data. */
+   int         idx;  /**< Index in mission_stack. */
+} MissionNameIdx;
+
+/**
+ * @brief Entry of a mission bucket keyed by faction.
+ */
+typedef struct MissionFactionIdx_ {
+   int faction; /**< Faction ID. */
+   int idx;     /**< Index in mission_stack. */
+} MissionFactionIdx;
+
+/**
+ * @brief Missions available at a location, bucketed by what restricts them so
+ * only plausible candidates have to be checked.
+ */
+typedef struct MissionIndex_ {
+   int *all; /**< Array (array.h): All the missions at the location. */
+   int *generic; /**< Array (array.h): Missions without spob, system, nor
+                    faction restrictions. */
+   MissionFactionIdx *faction; /**< Array (array.h): Missions only restricted
+                                  by faction, sorted by faction. */
+   MissionNameIdx *spob;   /**< Array (array.h): Missions restricted to a spob,
+                              sorted by name. */
+   MissionNameIdx *system; /**< Array (array.h): Missions restricted to a
+                              system but not spob, sorted by name. */
+} MissionIndex;
+
 /*
  * current player missions
  */
@@ -51,6 +85,24 @@ static char       **player_missions_failed =
  */
 static MissionData *mission_stack = NULL; /**< Unmutable after creation */
 
+/**
+ * @brief A mission file read from disk with its XML header already parsed.
+ */
+typedef struct MissionFile_ {
+   char     *file;    /**< Source file path. */
+   char     *filebuf; /**< Contents of the file. */
+   xmlDocPtr doc;     /**< Parsed XML header. */
+} MissionFile;
+static MissionFile *mission_files =
+   NULL; /**< Array (array.h): Files read by missions_loadXML. */
+static MissionIndex mission_index[MIS_AVAIL_MAX]; /**< Missions by location. */
+static int mission_indexed = 0; /**< Whether mission_index is up to date. */
+static char *mission_chapter =
+   NULL; /**< Chapter mission_chapter_match was computed for. */
+static int *mission_chapter_match =
+   NULL; /**< Array (array.h): Cached chapter matches of the missions, -1 if
+            not computed yet. */
+
 /*
  * prototypes
  */
@@ -68,7 +120,20 @@ static int mission_matchFaction( const MissionData *misn, int faction );
 static int mission_location( const char *loc );
 /* Loading. */
 static int missions_cmp( const void *a, const void *b );
+static int mission_cmpInt( const void *a, const void *b );
+static int mission_cmpNameIdx( const void *a, const void *b );
+static int mission_cmpFactionIdx( const void *a, const void *b );
+static void mission_indexFree( void );
+static void mission_candidatesName( int **cand, const MissionNameIdx *bucket,
+                                    const char *name );
+static void mission_indexBuild( void );
+static int *mission_candidates( MissionAvailability loc, int faction,
+                                const Spob *pnt, const StarSystem *sys );
+static int  mission_matchChapter( const MissionData *misn );
 static int mission_parseFile( const char *file, MissionData *temp );
+static int mission_readFile( const char *file, MissionFile *mf );
+static int mission_parseRead( MissionFile *mf, MissionData *temp );
+static void mission_freeFile( MissionFile *mf );
 static int mission_parseXML( MissionData *temp, const xmlNodePtr parent );
 static int missions_parseActive( xmlNodePtr parent );
 /* Misc. */
@@ -234,26 +299,61 @@ int mission_alreadyRunning( const MissionData *misn )
    return n;
 }
 
+/**
+ * @brief Checks to see if the player's chapter matches the mission's.
+ *
+ * Results are cached until the player's chapter changes, which is rare.
+ *
+ *    @param misn Mission to check, must have a chapter regex.
+ *    @return 1 if it matches, 0 otherwise.
+ */
+static int mission_matchChapter( const MissionData *misn )
+{
+   int               idx = misn - mission_stack;
+   int               rc;
+   pcre2_match_data *match_data;
+
+   /* Invalidate if the chapter changed. */
+   if ( ( mission_chapter == NULL ) ||
+        ( strcmp( mission_chapter, player.chapter ) != 0 ) ||
+        ( array_size( mission_chapter_match ) != array_size( mission_stack ) ) ) {
+      free( mission_chapter );
+      mission_chapter = strdup( player.chapter );
+      array_free( mission_chapter_match );
+      mission_chapter_match =
+         array_create_size( int, array_size( mission_stack ) );
+      array_resize( &mission_chapter_match, array_size( mission_stack ) );
+      for ( int i = 0; i < array_size( mission_chapter_match ); i++ )
+         mission_chapter_match[i] = -1;
+   }
+   if ( mission_chapter_match[idx] >= 0 )
+      return mission_chapter_match[idx];
+
+   match_data =
+      pcre2_match_data_create_from_pattern( misn->avail.chapter_re, NULL );
+   rc = pcre2_match( misn->avail.chapter_re, (PCRE2_SPTR)player.chapter,
+                     strlen( player.chapter ), 0, 0, match_data, NULL );
+   pcre2_match_data_free( match_data );
+   if ( rc < 0 ) {
+      switch ( rc ) {
+      case PCRE2_ERROR_NOMATCH:
+         mission_chapter_match[idx] = 0;
+         break;
+      default:
+         WARN( _( "Matching error %d" ), rc );
+         mission_chapter_match[idx] = 1;
+         break;
+      }
+   } else
+      mission_chapter_match[idx] = ( rc != 0 );
+   return mission_chapter_match[idx];
+}
+
 static int mission_meetConditionals( const MissionData *misn )
 {
    /* If chapter, must match chapter. */
-   if ( misn->avail.chapter_re != NULL ) {
-      pcre2_match_data *match_data =
-         pcre2_match_data_create_from_pattern( misn->avail.chapter_re, NULL );
-      int rc = pcre2_match( misn->avail.chapter_re, (PCRE2_SPTR)player.chapter,
-                            strlen( player.chapter ), 0, 0, match_data, NULL );
-      pcre2_match_data_free( match_data );
-      if ( rc < 0 ) {
-         switch ( rc ) {
-         case PCRE2_ERROR_NOMATCH:
-            return -1;
-         default:
-            WARN( _( "Matching error %d" ), rc );
-            break;
-         }
-      } else if ( rc == 0 )
-         return 1;
-   }
+   if ( ( misn->avail.chapter_re != NULL ) && !mission_matchChapter( misn ) )
+      return -1;
 
    /* Must not be already done or running if unique. */
    if ( mis_isFlag( misn, MISSION_UNIQUE ) &&
@@ -325,16 +425,14 @@ static int mission_meetReq( const MissionData *misn, int faction,
 void missions_run( MissionAvailability loc, int faction, const Spob *pnt,
                    const StarSystem *sys )
 {
-   for ( int i = 0; i < array_size( mission_stack ); i++ ) {
+   int *cand = mission_candidates( loc, faction, pnt, sys );
+   for ( int i = 0; i < array_size( cand ); i++ ) {
       Mission      mission;
       double       chance;
-      MissionData *misn = &mission_stack[i];
+      MissionData *misn = &mission_stack[cand[i]];
 
       if ( naev_isQuit() )
-         return;
-
-      if ( misn->avail.loc != loc )
-         continue;
+         break;
 
       if ( !mission_meetReq( misn, faction, pnt, sys ) )
          continue;
@@ -349,6 +447,7 @@ void missions_run( MissionAvailability loc, int faction, const Spob *pnt,
             &mission ); /* it better clean up for itself or we do it */
       }
    }
+   array_free( cand );
 }
 
 /**
@@ -930,17 +1029,25 @@ int mission_compare( const void *arg1, const void *arg2 )
 Mission *missions_genList( int faction, const Spob *pnt, const StarSystem *sys,
                            MissionAvailability loc )
 {
-   int      rep;
+   int      rep, k;
+   int     *cand, *all;
    Mission *tmp = array_create( Mission );
 
    NTracingZone( _ctx, 1 );
 
-   /* Find available missions. */
-   for ( int i = 0; i < array_size( mission_stack ); i++ ) {
+   /* Find available missions, copying the index as create() may rebuild it. */
+   cand = mission_candidates( loc, faction, pnt, sys );
+   all  = mission_candidates( loc, -1, NULL, NULL );
+   k    = 0;
+   for ( int i = 0; i < array_size( all ); i++ ) {
       double       chance;
-      MissionData *misn = &mission_stack[i];
-      if ( misn->avail.loc != loc )
-         continue;
+      int          iscand;
+      MissionData *misn = &mission_stack[all[i]];
+
+      /* Both are in stack order. */
+      while ( ( k < array_size( cand ) ) && ( cand[k] < all[i] ) )
+         k++;
+      iscand = ( k < array_size( cand ) ) && ( cand[k] == all[i] );
 
       /* Must hit chance. */
       chance = (double)( misn->avail.chance % 100 ) / 100.;
@@ -952,11 +1059,13 @@ Mission *missions_genList( int faction, const Spob *pnt, const StarSystem *sys,
       for ( int j = 0; j < rep; j++ ) {
          Mission newm;
 
+         /* Draw even for missions that can't appear, so the random numbers
+          * used don't depend on the candidates. */
          if ( RNGF() > chance )
             continue;
 
          /* Must meet requirements. */
-         if ( !mission_meetReq( misn, faction, pnt, sys ) )
+         if ( !iscand || !mission_meetReq( misn, faction, pnt, sys ) )
             continue;
 
          /* Initialize the mission. */
@@ -965,6 +1074,8 @@ Mission *missions_genList( int faction, const Spob *pnt, const StarSystem *sys,
          array_push_back( &tmp, newm );
       }
    }
+   array_free( cand );
+   array_free( all );
 
    /* Sort. */
    if ( array_size( tmp ) > 0 )
@@ -975,6 +1086,194 @@ Mission *missions_genList( int faction, const Spob *pnt, const StarSystem *sys,
    return tmp;
 }
 
+/**
+ * @brief Compares two ints for qsort.
+ */
+static int mission_cmpInt( const void *a, const void *b )
+{
+   return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * @brief Compares name bucket entries, by name and then index.
+ */
+static int mission_cmpNameIdx( const void *a, const void *b )
+{
+   const MissionNameIdx *ma  = a;
+   const MissionNameIdx *mb  = b;
+   int                   ret = strcmp( ma->name, mb->name );
+   if ( ret != 0 )
+      return ret;
+   return ma->idx - mb->idx;
+}
+
+/**
+ * @brief Compares faction bucket entries, by faction and then index.
+ */
+static int mission_cmpFactionIdx( const void *a, const void *b )
+{
+   const MissionFactionIdx *ma = a;
+   const MissionFactionIdx *mb = b;
+   if ( ma->faction != mb->faction )
+      return ma->faction - mb->faction;
+   return ma->idx - mb->idx;
+}
+
+/**
+ * @brief Frees the mission availability index.
+ */
+static void mission_indexFree( void )
+{
+   for ( int i = 0; i < MIS_AVAIL_MAX; i++ ) {
+      MissionIndex *mi = &mission_index[i];
+      array_free( mi->all );
+      array_free( mi->generic );
+      array_free( mi->faction );
+      array_free( mi->spob );
+      array_free( mi->system );
+      memset( mi, 0, sizeof( MissionIndex ) );
+   }
+   mission_indexed = 0;
+}
+
+/**
+ * @brief Builds the mission availability index.
+ *
+ * Buckets are kept sorted by mission_stack index so candidates are checked in
+ * the same order as the stack, which is sorted by priority.
+ */
+static void mission_indexBuild( void )
+{
+   mission_indexFree();
+   for ( int i = 0; i < MIS_AVAIL_MAX; i++ ) {
+      MissionIndex *mi = &mission_index[i];
+      mi->all          = array_create( int );
+      mi->generic      = array_create( int );
+      mi->faction      = array_create( MissionFactionIdx );
+      mi->spob         = array_create( MissionNameIdx );
+      mi->system       = array_create( MissionNameIdx );
+   }
+
+   for ( int i = 0; i < array_size( mission_stack ); i++ ) {
+      const MissionData *misn = &mission_stack[i];
+      MissionIndex      *mi;
+
+      if ( ( misn->avail.loc < 0 ) || ( misn->avail.loc >= MIS_AVAIL_MAX ) )
+         continue;
+      mi = &mission_index[misn->avail.loc];
+      array_push_back( &mi->all, i );
+
+      if ( misn->avail.spob != NULL ) {
+         MissionNameIdx e = { .name = misn->avail.spob, .idx = i };
+         array_push_back( &mi->spob, e );
+      } else if ( misn->avail.system != NULL ) {
+         MissionNameIdx e = { .name = misn->avail.system, .idx = i };
+         array_push_back( &mi->system, e );
+      } else if ( array_size( misn->avail.factions ) > 0 ) {
+         for ( int j = 0; j < array_size( misn->avail.factions ); j++ ) {
+            MissionFactionIdx e = { .faction = misn->avail.factions[j],
+                                    .idx     = i };
+            array_push_back( &mi->faction, e );
+         }
+      } else
+         array_push_back( &mi->generic, i );
+   }
+
+   for ( int i = 0; i < MIS_AVAIL_MAX; i++ ) {
+      MissionIndex *mi = &mission_index[i];
+      qsort( mi->faction, array_size( mi->faction ),
+             sizeof( MissionFactionIdx ), mission_cmpFactionIdx );
+      qsort( mi->spob, array_size( mi->spob ), sizeof( MissionNameIdx ),
+             mission_cmpNameIdx );
+      qsort( mi->system, array_size( mi->system ), sizeof( MissionNameIdx ),
+             mission_cmpNameIdx );
+   }
+   mission_indexed = 1;
+}
+
+/**
+ * @brief Adds the missions of a name bucket matching a name to a list.
+ */
+static void mission_candidatesName( int **cand, const MissionNameIdx *bucket,
+                                    const char *name )
+{
+   int lo = 0;
+   int hi = array_size( bucket );
+   while ( lo < hi ) {
+      int mid = ( lo + hi ) / 2;
+      if ( strcmp( bucket[mid].name, name ) < 0 )
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   for ( int i = lo; ( i < array_size( bucket ) ) &&
+                     ( strcmp( bucket[i].name, name ) == 0 );
+         i++ )
+      array_push_back( cand, bucket[i].idx );
+}
+
+/**
+ * @brief Gets the missions that could be available somewhere.
+ *
+ * Only does the cheap filtering, mission_meetReq still has to be run on them.
+ *
+ *    @param loc Location to get missions of.
+ *    @param faction Faction of the spob, or -1 to not filter by faction.
+ *    @param pnt Spob to get missions of.
+ *    @param sys System to get missions of.
+ *    @return Array (array.h) of mission_stack indices, in stack order. Must be
+ *          freed.
+ */
+static int *mission_candidates( MissionAvailability loc, int faction,
+                                const Spob *pnt, const StarSystem *sys )
+{
+   const MissionIndex *mi;
+   int                *cand = array_create( int );
+   int                 n, lo, hi;
+
+   if ( !mission_indexed )
+      mission_indexBuild();
+   if ( ( loc < 0 ) || ( loc >= MIS_AVAIL_MAX ) )
+      return cand;
+   mi = &mission_index[loc];
+
+   /* Can't filter by faction. */
+   if ( faction < 0 ) {
+      array_resize( &cand, array_size( mi->all ) );
+      memcpy( cand, mi->all, array_size( mi->all ) * sizeof( int ) );
+      return cand;
+   }
+
+   for ( int i = 0; i < array_size( mi->generic ); i++ )
+      array_push_back( &cand, mi->generic[i] );
+   if ( pnt != NULL )
+      mission_candidatesName( &cand, mi->spob, pnt->name );
+   if ( sys != NULL )
+      mission_candidatesName( &cand, mi->system, sys->name );
+   lo = 0;
+   hi = array_size( mi->faction );
+   while ( lo < hi ) {
+      int mid = ( lo + hi ) / 2;
+      if ( mi->faction[mid].faction < faction )
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   for ( int i = lo; ( i < array_size( mi->faction ) ) &&
+                     ( mi->faction[i].faction == faction );
+         i++ )
+      array_push_back( &cand, mi->faction[i].idx );
+
+   /* Put back in stack order, dropping duplicate factions. */
+   qsort( cand, array_size( cand ), sizeof( int ), mission_cmpInt );
+   n = 0;
+   for ( int i = 0; i < array_size( cand ); i++ )
+      if ( ( n == 0 ) || ( cand[n - 1] != cand[i] ) )
+         cand[n++] = cand[i];
+   array_resize( &cand, n );
+   return cand;
+}
+
 /**
  * @brief Gets location based on a human readable string.
  *
@@ -1136,6 +1435,29 @@ static int missions_cmp( const void *a, const void *b )
    return strcmp( ma->name, mb->name );
 }
 
+/**
+ * @brief Reads all the mission files and parses their XML headers.
+ *
+ * Does not touch Lua nor any other subsystem, so it can be run on a worker
+ * thread while other data is loading. The missions themselves are created by
+ * missions_load().
+ *
+ *    @return 0 on success.
+ */
+int missions_loadXML( void )
+{
+   char **files  = ndata_listRecursive( MISSION_DATA_PATH );
+   mission_files = array_create_size( MissionFile, array_size( files ) );
+   for ( int i = 0; i < array_size( files ); i++ ) {
+      MissionFile mf;
+      if ( mission_readFile( files[i], &mf ) == 0 )
+         array_push_back( &mission_files, mf );
+      free( files[i] );
+   }
+   array_free( files );
+   return 0;
+}
+
 /**
  * @brief Loads all the mission data.
  *
@@ -1146,17 +1468,20 @@ int missions_load( void )
 #if DEBUGGING
    Uint32 time = SDL_GetTicks();
 #endif /* DEBUGGING */
-   char **mission_files;
+
+   /* Read the files here if missions_loadXML was not run ahead of time. */
+   if ( mission_files == NULL )
+      missions_loadXML();
 
    /* Run over missions. */
-   mission_files = ndata_listRecursive( MISSION_DATA_PATH );
    mission_stack =
       array_create_size( MissionData, array_size( mission_files ) );
    for ( int i = 0; i < array_size( mission_files ); i++ ) {
-      mission_parseFile( mission_files[i], NULL );
-      free( mission_files[i] );
+      mission_parseRead( &mission_files[i], NULL );
+      mission_freeFile( &mission_files[i] );
    }
    array_free( mission_files );
+   mission_files = NULL;
    array_shrink( &mission_stack );
 
 #ifdef DEBUGGING
@@ -1195,9 +1520,29 @@ int missions_load( void )
  *    @param temp Data to load into, or NULL for initial load.
  */
 static int mission_parseFile( const char *file, MissionData *temp )
+{
+   MissionFile mf;
+   int         ret = mission_readFile( file, &mf );
+   if ( ret != 0 )
+      return -1;
+   ret = mission_parseRead( &mf, temp );
+   mission_freeFile( &mf );
+   return ret;
+}
+
+/**
+ * @brief Reads a mission file and parses its XML header.
+ *
+ * Only touches the file system and libxml2, so it is safe to use from a
+ * worker thread.
+ *
+ *    @param file Source file path.
+ *    @param[out] mf File read, only set on success.
+ *    @return 0 on success, 1 if the file is not a mission, -1 on error.
+ */
+static int mission_readFile( const char *file, MissionFile *mf )
 {
    xmlDocPtr   doc;
-   xmlNodePtr  node;
    size_t      bufsize;
    char       *filebuf;
    const char *pos, *start_pos;
@@ -1221,7 +1566,7 @@ static int mission_parseFile( const char *file, MissionData *temp )
          WARN( _( "Mission '%s' has create function but no XML header!" ),
                file );
       free( filebuf );
-      return -1;
+      return 1;
    }
 
    /* Separate XML header and Lua. */
@@ -1229,6 +1574,7 @@ static int mission_parseFile( const char *file, MissionData *temp )
    pos       = strnstr( filebuf, "--]]", bufsize );
    if ( pos == NULL || start_pos == NULL ) {
       WARN( _( "Mission file '%s' has missing XML header!" ), file );
+      free( filebuf );
       return -1;
    }
 
@@ -1236,22 +1582,38 @@ static int mission_parseFile( const char *file, MissionData *temp )
    doc = xmlParseMemory( start_pos, pos - start_pos );
    if ( doc == NULL ) {
       WARN( _( "Unable to parse document XML header for Mission '%s'" ), file );
+      free( filebuf );
       return -1;
    }
 
-   node = doc->xmlChildrenNode;
+   mf->file    = strdup( file );
+   mf->filebuf = filebuf;
+   mf->doc     = doc;
+   return 0;
+}
+
+/**
+ * @brief Creates the mission data from a file read by mission_readFile.
+ *
+ *    @param mf File to load from. The Lua source is taken from it.
+ *    @param temp Data to load into, or NULL for initial load.
+ */
+static int mission_parseRead( MissionFile *mf, MissionData *temp )
+{
+   xmlNodePtr node = mf->doc->xmlChildrenNode;
    if ( !xml_isNode( node, XML_MISSION_TAG ) ) {
       WARN( _( "Malformed XML header for '%s' mission: missing root element "
                "'%s'" ),
-            file, XML_MISSION_TAG );
+            mf->file, XML_MISSION_TAG );
       return -1;
    }
 
    if ( temp == NULL )
       temp = &array_grow( &mission_stack );
    mission_parseXML( temp, node );
-   temp->lua        = filebuf;
-   temp->sourcefile = strdup( file );
+   temp->lua        = mf->filebuf;
+   temp->sourcefile = strdup( mf->file );
+   mf->filebuf      = NULL;
 
    /* Clear chunk if already loaded. */
    if ( temp->chunk != LUA_NOREF ) {
@@ -1263,17 +1625,26 @@ static int mission_parseFile( const char *file, MissionData *temp )
    int ret =
       luaL_loadbuffer( naevL, temp->lua, strlen( temp->lua ), temp->name );
    if ( ret == LUA_ERRSYNTAX )
-      WARN( _( "Mission Lua '%s' syntax error: %s" ), file,
+      WARN( _( "Mission Lua '%s' syntax error: %s" ), mf->file,
             lua_tostring( naevL, -1 ) );
    else
       temp->chunk = luaL_ref( naevL, LUA_REGISTRYINDEX );
 
-   /* Clean up. */
-   xmlFreeDoc( doc );
-
    return 0;
 }
 
+/**
+ * @brief Frees a file read by mission_readFile.
+ *
+ *    @param mf File to free.
+ */
+static void mission_freeFile( MissionFile *mf )
+{
+   free( mf->file );
+   free( mf->filebuf );
+   xmlFreeDoc( mf->doc );
+}
+
 /**
  * @brief Frees all the mission data.
  */
@@ -1288,6 +1659,13 @@ void missions_free( void )
    array_free( mission_stack );
    mission_stack = NULL;
 
+   /* Free the caches. */
+   mission_indexFree();
+   free( mission_chapter );
+   mission_chapter = NULL;
+   array_free( mission_chapter_match );
+   mission_chapter_match = NULL;
+
    /* Free the player mission stack. */
    array_free( player_missions );
    player_missions = NULL;
@@ -1700,5 +2078,10 @@ int mission_reload( const char *name )
       mission_freeData( &save );
    else
       *temp = save;
+
+   /* Availability may have changed. */
+   mission_indexed = 0;
+   free( mission_chapter );
+   mission_chapter = NULL;
    return res;
 }
@@ -163,6 +163,7 @@ int mission_unlinkCargo( Mission *misn, unsigned int cargo_id );
 /*
  * load/quit
  */
+int        missions_loadXML( void );
 int        missions_load( void );
 int        missions_loadActive( xmlNodePtr parent );
 int        missions_loadCommodity( xmlNodePtr parent );
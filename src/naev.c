@@ -122,6 +122,29 @@ static int          load_force_render = 0;
 static unsigned int load_last_render  = 0;
 static SDL_mutex   *load_mutex;
 
+/**
+ * @brief Phases of update_routine that get profiled.
+ */
+typedef enum UpdatePhase_ {
+   UPDATE_PHASE_PURGE,   /**< Purging dead pilots and weapons. */
+   UPDATE_PHASE_SPACE,   /**< Space and special effects. */
+   UPDATE_PHASE_COLLIDE, /**< Weapon collisions. */
+   UPDATE_PHASE_PILOTS,  /**< Pilots and their AI. */
+   UPDATE_PHASE_WEAPONS, /**< Weapons. */
+   UPDATE_PHASE_OTHER,   /**< Camera and autonav. */
+   UPDATE_PHASE_HOOKS,   /**< Update hooks. */
+   UPDATE_PHASE_MAX,     /**< Number of phases. */
+} UpdatePhase;
+
+/**
+ * @brief Time spent in each phase of update_routine.
+ */
+typedef struct UpdateProfile_ {
+   Uint64 time[UPDATE_PHASE_MAX]; /**< Performance counter ticks per phase. */
+} UpdateProfile;
+static UpdateProfile *update_prof =
+   NULL; /**< Profile to fill in update_routine, NULL to not profile. */
+
 /*
  * prototypes
  */
@@ -137,6 +160,7 @@ static void   fps_init( void );
 static double fps_elapsed( void );
 static void   fps_control( void );
 static void   update_all( int dohooks );
+static void   update_profMark( Uint64 *t, UpdatePhase phase );
 /* Misc. */
 static void loadscreen_update( double done, const char *msg );
 void        main_loop( int nested ); /* externed in dialogue.c */
@@ -525,6 +549,7 @@ int main( int argc, char **argv )
    lua_exit();        /* Closes Lua state, and invalidates all Lua. */
    sound_exit();      /* Kills the sound */
    gl_exit();         /* Kills video output */
+   threadpool_exit(); /* Frees the threadpool ranges. */
 
    /* Has to be run last or it will mess up sound settings. */
    conf_cleanup(); /* Free some memory the configuration allocated. */
@@ -677,82 +702,264 @@ static void loadscreen_unload( void )
 }
 
 /**
- * @brief Loads all the data, makes main() simpler.
+ * @brief Stages of load_all, in the order the main thread goes through them.
  */
-#define LOADING_STAGES 17. /**< Amount of loading stages. */
-void load_all( void )
-{
-   NTracingFrameMarkStart( "load_all" );
-
-   int stage = 0;
-   /* We can do fast stuff here. */
-   sp_load();
+typedef enum LoadStageID_ {
+   LOAD_SP,          /**< Ship stats. */
+   LOAD_COMMODITY,   /**< Commodities. */
+   LOAD_SPFX,        /**< Special effects. */
+   LOAD_EFFECT,      /**< Effects. */
+   LOAD_DTYPE,       /**< Damage types. */
+   LOAD_FACTIONS,    /**< Factions. */
+   LOAD_OUTFITS,     /**< Outfits. */
+   LOAD_SHIPS,       /**< Ships. */
+   LOAD_POST,        /**< Faction and outfit post-processing. */
+   LOAD_AI,          /**< AI profiles. */
+   LOAD_TECH,        /**< Tech groups. */
+   LOAD_SPACE,       /**< Spobs and systems. */
+   LOAD_EVENTS_XML,  /**< Event files and XML headers. */
+   LOAD_MISSION_XML, /**< Mission files and XML headers. */
+   LOAD_EVENTS,      /**< Events. */
+   LOAD_MISSIONS,    /**< Missions. */
+   LOAD_DIFF,        /**< Unidiffs. */
+   LOAD_MAPS,        /**< Outfit maps. */
+   LOAD_LANES,       /**< Safe lanes. */
+   LOAD_DETAILS,     /**< Everything else. */
+   LOAD_STAGES,      /**< Number of loading stages. */
+} LoadStageID;
+
+#define LOAD_DEP( s ) ( 1u << ( s ) ) /**< Dependency mask of a stage. */
 
-   /* order is very important as they're interdependent */
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Commodities…" ) );
-   commodity_load(); /* dep for space */
+/**
+ * @brief A loading stage.
+ *
+ * Stages marked as worker may not touch Lua, OpenGL nor use the threadpool
+ * themselves. They get launched on the threadpool as soon as their
+ * dependencies are done, and the main thread only waits on them once a
+ * stage depending on them is reached.
+ */
+typedef struct LoadStage_ {
+   const char *name; /**< Name to use when reporting timings. */
+   const char *msg;  /**< Loadscreen message (untranslated), or NULL. */
+   int ( *load )( void ); /**< Does the actual loading. */
+   unsigned int deps;     /**< Stages that have to be done first. */
+   int          worker;   /**< Can be run on a worker thread. */
+} LoadStage;
 
-   loadscreen_update( ++stage / LOADING_STAGES,
-                      _( "Loading Special Effects…" ) );
-   spfx_load(); /* no dep */
+/**
+ * @brief State of a loading stage while load_all is running.
+ */
+typedef struct LoadJob_ {
+   const LoadStage *stage; /**< Stage to run. */
+   ThreadQueue     *queue; /**< Queue of the stage if running on a worker. */
+   Uint32           start; /**< Ticks when the stage started. */
+   Uint32           end;   /**< Ticks when the stage finished. */
+} LoadJob;
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Effects…" ) );
-   effect_load(); /* no dep */
+/**
+ * @brief Does the faction and outfit post-processing.
+ */
+static int load_post( void )
+{
+   factions_loadPost();
+   return outfit_loadPost();
+}
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Damage Types…" ) );
-   dtype_load(); /* dep for outfits */
+/**
+ * @brief Computes the safe lanes.
+ */
+static int load_lanes( void )
+{
+   safelanes_init();
+   return 0;
+}
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Factions…" ) );
-   factions_load(); /* dep for fleet, space, missions, AI */
+/**
+ * @brief Loads the last bits that need everything else.
+ */
+static int load_details( void )
+{
+   difficulty_load();
+   background_init();
+   map_load();
+   map_system_load();
+   space_loadLua();
+   pilots_init();
+   weapon_init();
+   player_init(); /* Initialize player stuff. */
+   return 0;
+}
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Outfits…" ) );
-   outfit_load(); /* dep for ships, factions */
+/**
+ * @brief The loading stages, order is very important as they're
+ * interdependent. Dependencies on earlier main thread stages are implied by
+ * the order, but are listed anyway to document them.
+ */
+static const LoadStage load_stages[LOAD_STAGES] = {
+   [LOAD_SP]          = { "sp", NULL, sp_load, 0, 0 },
+   [LOAD_COMMODITY]   = { "commodity", N_( "Loading Commodities…" ),
+                          commodity_load, 0, 0 },
+   [LOAD_SPFX]        = { "spfx", N_( "Loading Special Effects…" ),
+                          spfx_load, 0, 0 },
+   [LOAD_EFFECT]      = { "effect", N_( "Loading Effects…" ),
+                          effect_load, 0, 0 },
+   [LOAD_DTYPE]       = { "dtype", NULL, dtype_load, 0, 1 },
+   [LOAD_FACTIONS]    = { "factions", N_( "Loading Factions…" ),
+                          factions_load, 0, 0 },
+   [LOAD_OUTFITS]     = { "outfits", N_( "Loading Outfits…" ),
+                          outfit_load, LOAD_DEP( LOAD_SPFX ) |
+                          LOAD_DEP( LOAD_EFFECT ) | LOAD_DEP( LOAD_DTYPE ), 0 },
+   [LOAD_SHIPS]       = { "ships", N_( "Loading Ships…" ),
+                          ships_load, LOAD_DEP( LOAD_OUTFITS ), 0 },
+   [LOAD_POST]        = { "post", NULL, load_post,
+                          LOAD_DEP( LOAD_FACTIONS ) | LOAD_DEP( LOAD_SHIPS ), 0 },
+   [LOAD_AI]          = { "ai", N_( "Loading AI…" ), ai_load,
+                          LOAD_DEP( LOAD_POST ), 0 },
+   [LOAD_TECH]        = { "tech", N_( "Loading Techs…" ), tech_load,
+                          LOAD_DEP( LOAD_POST ), 0 },
+   [LOAD_SPACE]       = { "space", N_( "Loading the Universe…" ), space_load,
+                          LOAD_DEP( LOAD_COMMODITY ) | LOAD_DEP( LOAD_TECH ), 0 },
+   [LOAD_EVENTS_XML]  = { "events_xml", NULL, events_loadXML, 0, 1 },
+   [LOAD_MISSION_XML] = { "missions_xml", NULL, missions_loadXML, 0, 1 },
+   [LOAD_EVENTS]      = { "events", N_( "Loading Events…" ), events_load,
+                          LOAD_DEP( LOAD_SPACE ) |
+                          LOAD_DEP( LOAD_EVENTS_XML ), 0 },
+   [LOAD_MISSIONS]    = { "missions", N_( "Loading Missions…" ), missions_load,
+                          LOAD_DEP( LOAD_SPACE ) |
+                          LOAD_DEP( LOAD_MISSION_XML ), 0 },
+   [LOAD_DIFF]        = { "diff", N_( "Loading the UniDiffs…" ), diff_init,
+                          LOAD_DEP( LOAD_SPACE ), 0 },
+   [LOAD_MAPS]        = { "maps", N_( "Populating Maps…" ), outfit_mapParse,
+                          LOAD_DEP( LOAD_SPACE ), 0 },
+   [LOAD_LANES]       = { "lanes", N_( "Calculating Patrols…" ), load_lanes,
+                          LOAD_DEP( LOAD_SPACE ), 0 },
+   [LOAD_DETAILS]     = { "details", N_( "Initializing Details…" ),
+                          load_details, LOAD_DEP( LOAD_LANES ), 0 },
+};
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Ships…" ) );
-   ships_load(); /* dep for fleet */
+/**
+ * @brief Runs a loading stage, keeping track of how long it took.
+ */
+static int load_run( void *data )
+{
+   LoadJob *job = data;
+   job->start   = SDL_GetTicks();
+   job->stage->load();
+   job->end = SDL_GetTicks();
+   return 0;
+}
 
-   /* Handle dependent faction/outfit stuff. */
-   factions_loadPost();
-   outfit_loadPost();
+/**
+ * @brief Launches the worker stages that have all their dependencies done.
+ *
+ *    @param jobs State of the stages.
+ *    @param done Stages that are done.
+ *    @param launched Stages already launched.
+ *    @return Stages that were launched.
+ */
+static unsigned int load_launch( LoadJob *jobs, unsigned int done,
+                                 unsigned int launched )
+{
+   unsigned int ret = 0;
+   for ( int i = 0; i < LOAD_STAGES; i++ ) {
+      const LoadStage *ls = &load_stages[i];
+      if ( !ls->worker || ( launched & LOAD_DEP( i ) ) ||
+           ( ( ls->deps & done ) != ls->deps ) )
+         continue;
+      jobs[i].queue = vpool_create();
+      vpool_enqueue( jobs[i].queue, load_run, &jobs[i] );
+      vpool_start( jobs[i].queue );
+      ret |= LOAD_DEP( i );
+   }
+   return ret;
+}
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading AI…" ) );
-   ai_load(); /* dep for fleets */
+/**
+ * @brief Waits for worker stages to be done.
+ *
+ *    @param jobs State of the stages.
+ *    @param wait Stages to wait for, must have been launched.
+ *    @return Number of stages waited for.
+ */
+static int load_join( LoadJob *jobs, unsigned int wait )
+{
+   int n = 0;
+   for ( int i = 0; i < LOAD_STAGES; i++ ) {
+      if ( !( wait & LOAD_DEP( i ) ) )
+         continue;
+      vpool_wait( jobs[i].queue );
+      vpool_cleanup( jobs[i].queue );
+      jobs[i].queue = NULL;
+      n++;
+   }
+   return n;
+}
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Techs…" ) );
-   tech_load(); /* dep for space */
+/**
+ * @brief Loads all the data, makes main() simpler.
+ *
+ * The stages in load_stages are run in order on the main thread, except for
+ * the worker stages which get overlapped with them on the threadpool.
+ */
+void load_all( void )
+{
+   NTracingFrameMarkStart( "load_all" );
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading the Universe…" ) );
-   space_load(); /* dep for events/missions */
+   LoadJob      jobs[LOAD_STAGES];
+   unsigned int done     = 0;
+   unsigned int launched = 0;
+   int          ndone    = 0;
+#if DEBUGGING
+   Uint32 time = SDL_GetTicks();
+#endif /* DEBUGGING */
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Events…" ) );
-   events_load();
+   for ( int i = 0; i < LOAD_STAGES; i++ ) {
+      jobs[i].stage = &load_stages[i];
+      jobs[i].queue = NULL;
+   }
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading Missions…" ) );
-   missions_load();
+   for ( int i = 0; i < LOAD_STAGES; i++ ) {
+      const LoadStage *ls = &load_stages[i];
+      unsigned int     wait;
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Loading the UniDiffs…" ) );
-   diff_init();
+      /* Get the background stages that can run going. */
+      launched |= load_launch( jobs, done, launched );
+      if ( ls->worker )
+         continue;
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Populating Maps…" ) );
-   outfit_mapParse();
+      /* Wait for the background stages this one needs. Worker stages only
+       * depend on earlier main thread stages, so they are all launched. */
+      wait = ls->deps & launched & ~done;
+      ndone += load_join( jobs, wait );
+      done |= wait;
+#if DEBUGGING
+      if ( ( ls->deps & done ) != ls->deps )
+         WARN( _( "Loading stage '%s' run before its dependencies!" ),
+               ls->name );
+#endif /* DEBUGGING */
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Calculating Patrols…" ) );
-   safelanes_init();
+      if ( ls->msg != NULL )
+         loadscreen_update( (double)ndone / LOAD_STAGES, _( ls->msg ) );
+      load_run( &jobs[i] );
+      done |= LOAD_DEP( i );
+      ndone++;
+   }
+   /* Should be nothing left, but just in case. */
+   load_join( jobs, launched & ~done );
+   loadscreen_update( 1., _( "Loading Completed!" ) );
 
-   loadscreen_update( ++stage / LOADING_STAGES, _( "Initializing Details…" ) );
 #if DEBUGGING
-   if ( stage > LOADING_STAGES )
-      WARN( _( "Too many loading stages, please increase LOADING_STAGES" ) );
+   if ( conf.devmode ) {
+      for ( int i = 0; i < LOAD_STAGES; i++ )
+         DEBUG( _( "Loading stage %-12s %s %.3f s to %.3f s" ),
+                load_stages[i].name,
+                load_stages[i].worker ? _( "(worker)" ) : _( "(main)  " ),
+                ( jobs[i].start - time ) / 1000.,
+                ( jobs[i].end - time ) / 1000. );
+      DEBUG( _( "Loaded all data in %.3f s" ),
+             ( SDL_GetTicks() - time ) / 1000. );
+   }
 #endif /* DEBUGGING */
-   difficulty_load();
-   background_init();
-   map_load();
-   map_system_load();
-   space_loadLua();
-   pilots_init();
-   weapon_init();
-   player_init(); /* Initialize player stuff. */
-   loadscreen_update( 1., _( "Loading Completed!" ) );
 
    NTracingFrameMarkEnd( "load_all" );
 }
@@ -1075,6 +1282,9 @@ void update_routine( double dt, int dohooks )
 
    double real_update = dt / dt_mod;
 
+   /* Only bother with timings when profiling. */
+   Uint64 t = ( update_prof != NULL ) ? SDL_GetPerformanceCounter() : 0;
+
    if ( dohooks ) {
       hook_exclusionStart();
 
@@ -1085,16 +1295,21 @@ void update_routine( double dt, int dohooks )
    /* Clean up dead elements and build quadtrees. */
    pilots_updatePurge();
    weapons_updatePurge();
+   update_profMark( &t, UPDATE_PHASE_PURGE );
 
    /* Core stuff independent of collisions. */
    space_update( dt, real_update );
    spfx_update( dt, real_update );
+   update_profMark( &t, UPDATE_PHASE_SPACE );
 
    if ( dt > 0. ) {
       /* First compute weapon collisions. */
       weapons_updateCollide( dt );
+      update_profMark( &t, UPDATE_PHASE_COLLIDE );
       pilots_update( dt );
+      update_profMark( &t, UPDATE_PHASE_PILOTS );
       weapons_update( dt ); /* Has weapons think and update positions. */
+      update_profMark( &t, UPDATE_PHASE_WEAPONS );
 
       /* Update camera. */
       cam_update( dt );
@@ -1102,6 +1317,7 @@ void update_routine( double dt, int dohooks )
 
    /* Player autonav. */
    player_updateAutonav( real_update );
+   update_profMark( &t, UPDATE_PHASE_OTHER );
 
    if ( dohooks ) {
       NTracingZoneName( _ctx_hook, "hooks[update]", 1 );
@@ -1116,6 +1332,7 @@ void update_routine( double dt, int dohooks )
       /* Run the update hook. */
       hooks_runParam( "update", h );
       NTracingZoneEnd( _ctx_hook );
+      update_profMark( &t, UPDATE_PHASE_HOOKS );
    }
 
    /* Update the elapsed time, should be with all the modifications and such. */
@@ -1124,6 +1341,22 @@ void update_routine( double dt, int dohooks )
    NTracingZoneEnd( _ctx );
 }
 
+/**
+ * @brief Adds the time since the last mark to a phase of the update profile.
+ *
+ *    @param[in,out] t Performance counter of the last mark.
+ *    @param phase Phase that just finished.
+ */
+static void update_profMark( Uint64 *t, UpdatePhase phase )
+{
+   Uint64 now;
+   if ( update_prof == NULL )
+      return;
+   now = SDL_GetPerformanceCounter();
+   update_prof->time[phase] += now - *t;
+   *t = now;
+}
+
 /**
  * @brief Sets the window caption.
  */
@@ -1,6 +1,10 @@
 #define NOMAIN 1
 #include "naev.c"
 
+/** @cond */
+#include <inttypes.h>
+/** @endcond */
+
 #include "lualib.h"
 #include "nlua_bkg.h"
 #include "nlua_camera.h"
@@ -14,6 +18,207 @@ const char *__asan_default_options()
    return "detect_leaks=0";
 }
 
+/*
+ * Headless benchmarking.
+ */
+static int benchL_seed( lua_State *L );
+static int benchL_space( lua_State *L );
+static int benchL_run( lua_State *L );
+static int benchL_hash( lua_State *L );
+
+static const luaL_Reg bench_methods[] = {
+   { "seed", benchL_seed },
+   { "space", benchL_space },
+   { "run", benchL_run },
+   { "hash", benchL_hash },
+   { 0, 0 } }; /**< Benchmark Lua methods. */
+
+static const char *bench_phases[UPDATE_PHASE_MAX] = {
+   "purge", "space", "collide", "pilots", "weapons", "other", "hooks",
+}; /**< Names of the update phases. */
+
+/**
+ * @brief Seeds the random number generator so runs can be reproduced.
+ *
+ * Only reseeds the engine's generator, math.random has to be seeded
+ * separately with math.randomseed.
+ *
+ *    @luatparam number seed Seed to use.
+ * @luafunc seed
+ */
+static int benchL_seed( lua_State *L )
+{
+   rng_seed( (unsigned int)luaL_checkinteger( L, 1 ) );
+   return 0;
+}
+
+/**
+ * @brief Enters a system, like jumping into it.
+ *
+ *    @luatparam string sys Name of the system to enter.
+ *    @luatparam[opt=false] boolean simulate Whether or not to run the usual
+ * pre-simulation of the system.
+ * @luafunc space
+ */
+static int benchL_space( lua_State *L )
+{
+   const char *sysname = luaL_checkstring( L, 1 );
+   int         s       = sound_disabled;
+   sound_disabled      = 1;
+   space_init( sysname, lua_toboolean( L, 2 ) );
+   sound_disabled = s;
+   return 0;
+}
+
+/**
+ * @brief Counts the weapons that are alive, skipping free and destroyed slots.
+ */
+static int bench_countWeapons( void )
+{
+   const Weapon *weapon_stack = weapon_getStack();
+   int           n            = 0;
+   for ( int i = 0; i < array_size( weapon_stack ); i++ )
+      if ( !weapon_isFlag( &weapon_stack[i], WEAPON_FLAG_DESTROYED ) )
+         n++;
+   return n;
+}
+
+/**
+ * @brief Runs the game simulation with a fixed time step and no rendering.
+ *
+ * Hooks are not run, which is the same as the system pre-simulation.
+ *
+ * The returned table has the fields "ticks", "dt", "elapsed" (in seconds),
+ * "phases" (table of seconds spent in each phase of the update), "pilots" and
+ * "weapons" (tables with the "mean", "max" and "last" count per tick).
+ *
+ *    @luatparam integer ticks Number of updates to run.
+ *    @luatparam[opt=1/60] number dt Time step of each update.
+ *    @luatreturn table Timings and counts of the run.
+ * @luafunc run
+ */
+static int benchL_run( lua_State *L )
+{
+   int           ticks = luaL_checkinteger( L, 1 );
+   double        dt    = luaL_optnumber( L, 2, 1. / 60. );
+   double        freq  = (double)SDL_GetPerformanceFrequency();
+   UpdateProfile prof;
+   Uint64        start, elapsed;
+   double        psum = 0., wsum = 0.;
+   int           pmax = 0, wmax = 0, np = 0, nw = 0;
+   int           s = sound_disabled;
+
+   if ( cur_system == NULL )
+      return NLUA_ERROR( L, _( "No system entered, use bench.space first!" ) );
+   if ( dt <= 0. )
+      return NLUA_ERROR( L, _( "Time step must be positive!" ) );
+
+   memset( &prof, 0, sizeof( prof ) );
+   sound_disabled = 1;
+   update_prof    = &prof;
+   start          = SDL_GetPerformanceCounter();
+   for ( int i = 0; i < ticks; i++ ) {
+      update_routine( dt, 0 );
+      np = array_size( pilot_getAll() );
+      nw = bench_countWeapons();
+      psum += np;
+      wsum += nw;
+      pmax = MAX( pmax, np );
+      wmax = MAX( wmax, nw );
+   }
+   elapsed        = SDL_GetPerformanceCounter() - start;
+   update_prof    = NULL;
+   sound_disabled = s;
+
+   lua_newtable( L );
+   lua_pushinteger( L, ticks );
+   lua_setfield( L, -2, "ticks" );
+   lua_pushnumber( L, dt );
+   lua_setfield( L, -2, "dt" );
+   lua_pushnumber( L, (double)elapsed / freq );
+   lua_setfield( L, -2, "elapsed" );
+   lua_newtable( L );
+   for ( int i = 0; i < UPDATE_PHASE_MAX; i++ ) {
+      lua_pushnumber( L, (double)prof.time[i] / freq );
+      lua_setfield( L, -2, bench_phases[i] );
+   }
+   lua_setfield( L, -2, "phases" );
+   lua_newtable( L );
+   lua_pushnumber( L, ( ticks > 0 ) ? psum / ticks : 0. );
+   lua_setfield( L, -2, "mean" );
+   lua_pushinteger( L, pmax );
+   lua_setfield( L, -2, "max" );
+   lua_pushinteger( L, np );
+   lua_setfield( L, -2, "last" );
+   lua_setfield( L, -2, "pilots" );
+   lua_newtable( L );
+   lua_pushnumber( L, ( ticks > 0 ) ? wsum / ticks : 0. );
+   lua_setfield( L, -2, "mean" );
+   lua_pushinteger( L, wmax );
+   lua_setfield( L, -2, "max" );
+   lua_pushinteger( L, nw );
+   lua_setfield( L, -2, "last" );
+   lua_setfield( L, -2, "weapons" );
+   return 1;
+}
+
+/**
+ * @brief Mixes some bytes into a FNV-1a hash.
+ */
+static uint64_t bench_hashBytes( uint64_t h, const void *data, size_t len )
+{
+   const unsigned char *c = data;
+   for ( size_t i = 0; i < len; i++ ) {
+      h ^= c[i];
+      h *= UINT64_C( 1099511628211 );
+   }
+   return h;
+}
+
+/**
+ * @brief Mixes the state of a solid into a hash.
+ */
+static uint64_t bench_hashSolid( uint64_t h, const Solid *solid )
+{
+   const double v[] = { solid->pos.x, solid->pos.y, solid->vel.x,
+                        solid->vel.y, solid->dir };
+   return bench_hashBytes( h, v, sizeof( v ) );
+}
+
+/**
+ * @brief Hashes the state of all the pilots and weapons.
+ *
+ * Two runs with the same seed and scenario should give the same hash.
+ *
+ *    @luatreturn string Hash as a hexadecimal string.
+ * @luafunc hash
+ */
+static int benchL_hash( lua_State *L )
+{
+   char          buf[32];
+   uint64_t      h           = UINT64_C( 14695981039346656037 );
+   Pilot *const *pilot_stack = pilot_getAll();
+   const Weapon *weapon_stack = weapon_getStack();
+
+   for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
+      const Pilot *p   = pilot_stack[i];
+      const double v[] = { p->armour, p->shield, p->energy };
+      h                = bench_hashBytes( h, &p->id, sizeof( p->id ) );
+      h                = bench_hashSolid( h, &p->solid );
+      h                = bench_hashBytes( h, v, sizeof( v ) );
+   }
+   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
+      /* Free slots are marked as destroyed too. */
+      if ( weapon_isFlag( &weapon_stack[i], WEAPON_FLAG_DESTROYED ) )
+         continue;
+      h = bench_hashSolid( h, &weapon_stack[i].solid );
+   }
+
+   snprintf( buf, sizeof( buf ), "%016" PRIx64, h );
+   lua_pushstring( L, buf );
+   return 1;
+}
+
 int main( int argc, char **argv )
 {
    char conf_file_path[PATH_MAX], **search_path;
@@ -268,6 +473,7 @@ int main( int argc, char **argv )
    nlua_loadMusic( nenv );
    nlua_loadTk( nenv );
    nlua_loadLinOpt( nenv );
+   nlua_register( nenv, "bench", bench_methods, 0 );
    /* Reload IO library that was sandboxed out. */
    lua_pushcfunction( naevL, luaopen_io );
    nlua_pcall( nenv, 0, 1 );
@@ -300,5 +506,6 @@ int main( int argc, char **argv )
       return -1;
    }
    unload_all();
+   threadpool_exit();
    return 0;
 }
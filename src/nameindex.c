@@ -0,0 +1,190 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file nameindex.c
+ *
+ * @brief Hash table to look things up by name in constant time.
+ *
+ * Uses open addressing with linear probing. Removed names leave a marker
+ * behind so probing goes past them, until the table gets rebuilt when
+ * growing.
+ */
+/** @cond */
+#include <stdlib.h>
+#include <string.h>
+/** @endcond */
+
+#include "nameindex.h"
+
+#define NAMEINDEX_MIN 64 /**< Minimum number of slots. */
+
+static const char nameindex_removed[] = ""; /**< Marks removed slots. */
+
+/**
+ * @brief Hashes a name.
+ */
+static uint32_t nameindex_hash( const char *name )
+{
+   /* FNV-1a. */
+   uint32_t h = 2166136261u;
+   for ( const unsigned char *c = (const unsigned char *)name; *c != '\0';
+         c++ )
+      h = ( h ^ *c ) * 16777619u;
+   return h;
+}
+
+/**
+ * @brief Finds the slot of a name.
+ *
+ *    @param ni Index to search.
+ *    @param name Name to find.
+ *    @param h Hash of the name.
+ *    @return Position of the slot or -1 if not found.
+ */
+static int nameindex_find( const NameIndex *ni, const char *name, uint32_t h )
+{
+   int mask;
+
+   if ( ni->size == 0 )
+      return -1;
+
+   /* There is always an empty slot to stop at. */
+   mask = ni->size - 1;
+   for ( int i = h & mask;; i = ( i + 1 ) & mask ) {
+      const NameIndexSlot *s = &ni->slots[i];
+      if ( s->name == NULL )
+         return -1;
+      if ( ( s->name != nameindex_removed ) && ( s->hash == h ) &&
+           ( strcmp( s->name, name ) == 0 ) )
+         return i;
+   }
+}
+
+/**
+ * @brief Inserts a name that is not in the index, there must be room.
+ */
+static void nameindex_insert( NameIndex *ni, const char *name, uint32_t h,
+                              int id )
+{
+   int            mask = ni->size - 1;
+   int            i    = h & mask;
+   NameIndexSlot *s;
+
+   while ( ( ni->slots[i].name != NULL ) &&
+           ( ni->slots[i].name != nameindex_removed ) )
+      i = ( i + 1 ) & mask;
+
+   s = &ni->slots[i];
+   if ( s->name == NULL )
+      ni->used++;
+   s->name = name;
+   s->hash = h;
+   s->id   = id;
+   ni->n++;
+}
+
+/**
+ * @brief Rebuilds the index with a new number of slots, dropping the removed
+ * names.
+ */
+static void nameindex_resize( NameIndex *ni, int size )
+{
+   NameIndexSlot *old     = ni->slots;
+   int            oldsize = ni->size;
+
+   ni->slots = calloc( size, sizeof( NameIndexSlot ) );
+   ni->size  = size;
+   ni->used  = 0;
+   ni->n     = 0;
+   for ( int i = 0; i < oldsize; i++ )
+      if ( ( old[i].name != NULL ) && ( old[i].name != nameindex_removed ) )
+         nameindex_insert( ni, old[i].name, old[i].hash, old[i].id );
+   free( old );
+}
+
+/**
+ * @brief Initializes an empty name index.
+ */
+void nameindex_init( NameIndex *ni )
+{
+   memset( ni, 0, sizeof( NameIndex ) );
+}
+
+/**
+ * @brief Frees a name index.
+ */
+void nameindex_free( NameIndex *ni )
+{
+   free( ni->slots );
+   memset( ni, 0, sizeof( NameIndex ) );
+}
+
+/**
+ * @brief Removes all the names from an index, keeping the memory around.
+ */
+void nameindex_clear( NameIndex *ni )
+{
+   if ( ni->slots != NULL )
+      memset( ni->slots, 0, sizeof( NameIndexSlot ) * ni->size );
+   ni->used = 0;
+   ni->n    = 0;
+}
+
+/**
+ * @brief Adds a name to an index.
+ *
+ *    @param ni Index to add to.
+ *    @param name Name to add, has to stay valid until removed.
+ *    @param id ID to map the name to.
+ *    @return The ID the name maps to, which is the old one if the name was
+ *            already in the index.
+ */
+int nameindex_add( NameIndex *ni, const char *name, int id )
+{
+   uint32_t h = nameindex_hash( name );
+   int      i = nameindex_find( ni, name, h );
+   if ( i >= 0 )
+      return ni->slots[i].id;
+
+   /* Keep at most three quarters of the slots used so probing stays short. */
+   if ( 4 * ( ni->used + 1 ) > 3 * ni->size ) {
+      int size = ( ni->size > 0 ) ? ni->size : NAMEINDEX_MIN;
+      while ( 2 * ( ni->n + 1 ) > size )
+         size *= 2;
+      nameindex_resize( ni, size );
+   }
+
+   nameindex_insert( ni, name, h, id );
+   return id;
+}
+
+/**
+ * @brief Removes a name from an index.
+ *
+ *    @param ni Index to remove from.
+ *    @param name Name to remove.
+ *    @return The ID the name mapped to or -1 if not found.
+ */
+int nameindex_remove( NameIndex *ni, const char *name )
+{
+   int i = nameindex_find( ni, name, nameindex_hash( name ) );
+   if ( i < 0 )
+      return -1;
+   ni->slots[i].name = nameindex_removed;
+   ni->n--;
+   return ni->slots[i].id;
+}
+
+/**
+ * @brief Looks up a name in an index.
+ *
+ *    @param ni Index to look up in.
+ *    @param name Name to look up.
+ *    @return The ID the name maps to or -1 if not found.
+ */
+int nameindex_get( const NameIndex *ni, const char *name )
+{
+   int i = nameindex_find( ni, name, nameindex_hash( name ) );
+   return ( i < 0 ) ? -1 : ni->slots[i].id;
+}
@@ -0,0 +1,38 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/** @cond */
+#include <stdint.h>
+/** @endcond */
+
+/**
+ * @brief Slot of a name index.
+ */
+typedef struct NameIndexSlot_ {
+   const char *name; /**< Name, NULL if empty. Not owned by the index. */
+   uint32_t    hash; /**< Hash of the name. */
+   int         id;   /**< ID the name maps to. */
+} NameIndexSlot;
+
+/**
+ * @brief Open addressing hash table mapping names to IDs, usually indices
+ * into a stack.
+ *
+ * Names are not copied, so they have to be removed from the index before
+ * being freed.
+ */
+typedef struct NameIndex_ {
+   NameIndexSlot *slots; /**< Slots, size is a power of two. */
+   int            size;  /**< Number of slots. */
+   int            used;  /**< Slots that are not empty, including removed. */
+   int            n;     /**< Names in the index. */
+} NameIndex;
+
+void nameindex_init( NameIndex *ni );
+void nameindex_free( NameIndex *ni );
+void nameindex_clear( NameIndex *ni );
+int  nameindex_add( NameIndex *ni, const char *name, int id );
+int  nameindex_remove( NameIndex *ni, const char *name );
+int  nameindex_get( const NameIndex *ni, const char *name );
@@ -9,6 +9,7 @@
 
 #include "nebula.h"
 
+#include "array.h"
 #include "camera.h"
 #include "conf.h"
 #include "gui.h"
@@ -20,6 +21,9 @@
 #include "vec2.h"
 
 #define NEBULA_PUFF_BUFFER 300 /**< Nebula buffer */
+#define NEBULA_PUFF_VERTEX                                                     \
+   ( 2 + 2 + 2 ) /**< Floats per puff vertex: position, position in the puff \
+                    and random seed. */
 
 /* Nebula properties */
 static double nebu_hue     = 0.; /**< The hue. */
@@ -51,10 +55,13 @@ typedef struct NebulaPuff_ {
    double rx;     /**< Random seed. */
    double ry;     /**< Random seed. */
 } NebulaPuff;
-static NebulaPuff *nebu_puffs  = NULL; /**< Stack of puffs. */
-static int         nebu_npuffs = 0;    /**< Number of puffs. */
-static double      puff_x      = 0.;
-static double      puff_y      = 0.;
+static NebulaPuff *nebu_puffs    = NULL; /**< Stack of puffs. */
+static int         nebu_npuffs   = 0;    /**< Number of puffs. */
+static double      puff_x        = 0.;
+static double      puff_y        = 0.;
+static GLfloat    *nebu_puffData = NULL; /**< Vertex data of visible puffs. */
+static gl_vbo     *nebu_puffVBO  = NULL; /**< VBO to draw puffs with. */
+static GLsizei     nebu_puffSize = 0;    /**< Size of the puff VBO. */
 
 /*
  * prototypes
@@ -135,6 +142,11 @@ void nebu_exit( void )
       glDeleteFramebuffers( 1, &nebu_fbo );
       glDeleteTextures( 1, &nebu_tex );
    }
+   gl_vboDestroy( nebu_puffVBO );
+   nebu_puffVBO  = NULL;
+   nebu_puffSize = 0;
+   array_free( nebu_puffData );
+   nebu_puffData = NULL;
 }
 
 /**
@@ -313,13 +325,24 @@ void nebu_renderOverlay( const double dt )
  */
 static void nebu_renderPuffs( int below_player )
 {
+   const GLsizei stride = sizeof( GLfloat ) * NEBULA_PUFF_VERTEX;
+   /* Corners of the puff, as two triangles. */
+   const GLfloat corners[6][2] = { { -1., -1. }, { 1., -1. }, { -1., 1. },
+                                   { 1., -1. },  { 1., 1. },  { -1., 1. } };
+   GLsizei       size;
+
    /* Main menu shouldn't have puffs */
    if ( menu_isOpen( MENU_MAIN ) )
       return;
 
+   /* Gather all the visible puffs so they can be drawn at once. */
+   if ( nebu_puffData == NULL )
+      nebu_puffData = array_create( GLfloat );
+   array_erase( &nebu_puffData, array_begin( nebu_puffData ),
+                array_end( nebu_puffData ) );
    for ( int i = 0; i < nebu_npuffs; i++ ) {
       double      x, y, s;
-      mat4        projection;
+      GLfloat    *v;
       NebulaPuff *puff = &nebu_puffs[i];
 
       /* Separate by layers */
@@ -337,26 +360,57 @@ static void nebu_renderPuffs( int below_player )
            ( y > SCREEN_H + s ) )
          continue;
 
-      /* Render */
-      glUseProgram( shaders.nebula_puff.program );
-
-      projection = gl_view_matrix;
-      mat4_translate_scale_xy( &projection, x, y, s, s );
-      glEnableVertexAttribArray( shaders.nebula_puff.vertex );
-      gl_vboActivateAttribOffset( gl_circleVBO, shaders.nebula_puff.vertex, 0,
-                                  2, GL_FLOAT, 0 );
-
-      /* Uniforms. */
-      gl_uniformMat4( shaders.nebula_puff.projection, &projection );
-      glUniform1f( shaders.nebula_puff.time, nebu_time / 1.5 );
-      glUniform2f( shaders.nebula_puff.r, puff->rx, puff->ry );
+      array_resize( &nebu_puffData,
+                    array_size( nebu_puffData ) + 6 * NEBULA_PUFF_VERTEX );
+      v = &nebu_puffData[array_size( nebu_puffData ) - 6 * NEBULA_PUFF_VERTEX];
+      for ( int j = 0; j < 6; j++ ) {
+         v[0] = x + corners[j][0] * s;
+         v[1] = y + corners[j][1] * s;
+         v[2] = corners[j][0];
+         v[3] = corners[j][1];
+         v[4] = puff->rx;
+         v[5] = puff->ry;
+         v += NEBULA_PUFF_VERTEX;
+      }
+   }
+   if ( array_size( nebu_puffData ) <= 0 )
+      return;
 
-      glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+   /* Upload, growing the VBO if necessary. */
+   size = sizeof( GLfloat ) * array_size( nebu_puffData );
+   if ( nebu_puffVBO == NULL )
+      nebu_puffVBO = gl_vboCreateStream( 0, NULL );
+   if ( size > nebu_puffSize ) {
+      gl_vboData( nebu_puffVBO, size, nebu_puffData );
+      nebu_puffSize = size;
+   } else
+      gl_vboSubData( nebu_puffVBO, 0, size, nebu_puffData );
+
+   /* Render */
+   glUseProgram( shaders.nebula_puff.program );
 
-      glDisableVertexAttribArray( shaders.nebula_puff.vertex );
-      glUseProgram( 0 );
-      gl_checkErr();
-   }
+   glEnableVertexAttribArray( shaders.nebula_puff.vertex );
+   glEnableVertexAttribArray( shaders.nebula_puff.vertex_pos );
+   glEnableVertexAttribArray( shaders.nebula_puff.vertex_r );
+   gl_vboActivateAttribOffset( nebu_puffVBO, shaders.nebula_puff.vertex, 0, 2,
+                               GL_FLOAT, stride );
+   gl_vboActivateAttribOffset( nebu_puffVBO, shaders.nebula_puff.vertex_pos,
+                               sizeof( GLfloat ) * 2, 2, GL_FLOAT, stride );
+   gl_vboActivateAttribOffset( nebu_puffVBO, shaders.nebula_puff.vertex_r,
+                               sizeof( GLfloat ) * 4, 2, GL_FLOAT, stride );
+
+   /* Uniforms. */
+   gl_uniformMat4( shaders.nebula_puff.projection, &gl_view_matrix );
+   glUniform1f( shaders.nebula_puff.time, nebu_time / 1.5 );
+
+   glDrawArrays( GL_TRIANGLES, 0,
+                 array_size( nebu_puffData ) / NEBULA_PUFF_VERTEX );
+
+   glDisableVertexAttribArray( shaders.nebula_puff.vertex );
+   glDisableVertexAttribArray( shaders.nebula_puff.vertex_pos );
+   glDisableVertexAttribArray( shaders.nebula_puff.vertex_r );
+   glUseProgram( 0 );
+   gl_checkErr();
 }
 
 /**
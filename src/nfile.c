@@ -596,6 +596,54 @@ int nfile_writeFile( const char *data, size_t len, const char *path )
    return 0;
 }
 
+/**
+ * @brief Writes a file so that it is either fully written or not at all.
+ *
+ * The data is written to a temporary file which is then renamed into place,
+ * so readers never see partial files, even with several instances writing.
+ *
+ *    @param data Pointer to the data to write.
+ *    @param len The size of data.
+ *    @param path Path of the file.
+ *    @return 0 on success, -1 on error.
+ */
+int nfile_writeFileAtomic( const char *data, size_t len, const char *path )
+{
+   char tmp[PATH_MAX];
+
+   if ( path == NULL )
+      return -1;
+
+   /* Unique per process so instances don't write to the same file. */
+#if HAS_POSIX
+   snprintf( tmp, sizeof( tmp ), "%s.%ld.tmp", path, (long)getpid() );
+#elif __WIN32__
+   snprintf( tmp, sizeof( tmp ), "%s.%lu.tmp", path,
+             (unsigned long)GetCurrentProcessId() );
+#else
+   snprintf( tmp, sizeof( tmp ), "%s.tmp", path );
+#endif
+
+   if ( nfile_writeFile( data, len, tmp ) != 0 ) {
+      remove( tmp );
+      return -1;
+   }
+
+#if __WIN32__
+   if ( !MoveFileEx( tmp, path, MOVEFILE_REPLACE_EXISTING ) ) {
+      WARN( _( "Error occurred while renaming '%s' to '%s'" ), tmp, path );
+#else
+   if ( rename( tmp, path ) != 0 ) {
+      WARN( _( "Error occurred while renaming '%s' to '%s': %s" ), tmp, path,
+            strerror( errno ) );
+#endif
+      remove( tmp );
+      return -1;
+   }
+
+   return 0;
+}
+
 /**
  * @brief Checks to see if a character is used to separate files in a path.
  *
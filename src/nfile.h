@@ -39,6 +39,7 @@ int   nfile_copyIfExists( const char *path1, const char *path2 );
 char *nfile_readFile( size_t *filesize, const char *path );
 int   nfile_touch( const char *path );
 int   nfile_writeFile( const char *data, size_t len, const char *path );
+int   nfile_writeFileAtomic( const char *data, size_t len, const char *path );
 int   nfile_isSeparator( uint32_t c );
 int   nfile_simplifyPath( char path[static 1] );
 
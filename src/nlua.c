@@ -11,6 +11,10 @@
 #include "physfs.h"
 
 #include "naev.h"
+
+#if HAVE_LUAJIT
+#include <luajit.h>
+#endif /* HAVE_LUAJIT */
 /** @endcond */
 
 #include "nlua.h"
@@ -23,7 +27,9 @@
 #include "lua_enet.h"
 #include "lutf8lib.h"
 #include "lyaml.h"
+#include "md5.h"
 #include "ndata.h"
+#include "nfile.h"
 #include "nlua_audio.h"
 #include "nlua_cli.h"
 #include "nlua_commodity.h"
@@ -50,12 +56,20 @@
 #include "nluadef.h"
 #include "nstring.h"
 
+#define NLUA_CACHE_DIR "lua/" /**< Bytecode cache directory in the cache path. */
+#define NLUA_CACHE_MINSIZE                                                     \
+   512 /**< Chunks smaller than this are faster to parse than to read. */
+#if HAVE_LUAJIT
+#define NLUA_CACHE_VERSION LUAJIT_VERSION /**< Bytecode format version. */
+#else /* HAVE_LUAJIT */
+#define NLUA_CACHE_VERSION LUA_RELEASE /**< Bytecode format version. */
+#endif /* HAVE_LUAJIT */
+
 lua_State *naevL         = NULL;      /**< Global Naev Lua state. */
 nlua_env   __NLUA_CURENV = LUA_NOREF; /**< Current environment. */
-static char
-   *common_script; /**< Common script to run when creating environments. */
-static size_t common_sz; /**< Common script size. */
-static int    nlua_envs = LUA_NOREF;
+static int nlua_envs    = LUA_NOREF;
+static int nlua_common  = LUA_NOREF; /**< Base table with the common script. */
+static int nlua_envmeta = LUA_NOREF; /**< Metatable shared by environments. */
 
 /**
  * @brief Cache structure for loading chunks.
@@ -65,6 +79,7 @@ typedef struct LuaCache_ {
    int   idx;  /**< Index of the loaded cache. */
 } LuaCache_t;
 static LuaCache_t *lua_cache = NULL;
+static int nlua_cache_dir = 0; /**< Whether the bytecode directory exists. */
 
 /*
  * prototypes
@@ -74,10 +89,17 @@ static int        nlua_package_loader_lua( lua_State *L );
 static int        nlua_package_loader_c( lua_State *L );
 static int        nlua_package_loader_croot( lua_State *L );
 static int        nlua_require( lua_State *L );
+static int        nlua_commonReadOnly( lua_State *L );
+static void       nlua_pushEnvMeta( void );
 static lua_State *nlua_newState( void ); /* creates a new state */
 static int        nlua_loadBasic( lua_State *L );
 static int        luaB_loadstring( lua_State *L );
+static int        nlua_setfenv( lua_State *L );
 static int        lua_cache_cmp( const void *p1, const void *p2 );
+static void       nlua_cachePath( char *path, size_t len, const char *buff,
+                                  size_t sz, const char *name );
+static int        nlua_cacheWriter( lua_State *L, const void *p, size_t sz,
+                                    void *ud );
 /* gettext */
 static int            nlua_gettext( lua_State *L );
 static int            nlua_ngettext( lua_State *L );
@@ -231,6 +253,54 @@ static int luaB_loadstring( lua_State *L )
    }
 }
 
+/**
+ * @brief Wrapper around the Lua setfenv() that keeps the common environment.
+ *
+ * The functions set up by the common script are shared between all the
+ * environments, so changing their environment would change it for all of
+ * them. The original setfenv is the first upvalue.
+ */
+static int nlua_setfenv( lua_State *L )
+{
+   lua_Debug ar;
+   int       common;
+
+   luaL_checktype( L, 2, LUA_TTABLE );
+   if ( !lua_isfunction( L, 1 ) ) {
+      int level = luaL_optint( L, 1, 1 );
+      /* Level 0 is the thread environment, not a function. */
+      if ( level == 0 ) {
+         lua_pushvalue( L, lua_upvalueindex( 1 ) );
+         lua_insert( L, 1 );
+         lua_call( L, lua_gettop( L ) - 1, LUA_MULTRET );
+         return lua_gettop( L );
+      }
+      /* Levels match the original as we are also called from the script. */
+      if ( ( level < 0 ) || ( lua_getstack( L, level, &ar ) == 0 ) )
+         return luaL_argerror( L, 1, "invalid level" );
+      lua_getinfo( L, "f", &ar ); /* f */
+      if ( lua_isnil( L, -1 ) )
+         return NLUA_ERROR( L, _( "no function environment for tail call at "
+                                  "level %d" ),
+                            level );
+      lua_replace( L, 1 );
+   }
+
+   /* Don't touch the functions from the common script. */
+   lua_getfenv( L, 1 );                              /* e */
+   lua_rawgeti( L, LUA_REGISTRYINDEX, nlua_common ); /* e, c */
+   common = !lua_isnil( L, -1 ) && lua_rawequal( L, -1, -2 );
+   lua_pop( L, 2 );
+   if ( common )
+      return NLUA_ERROR(
+         L, _( "Can not change the environment of common functions!" ) );
+
+   lua_pushvalue( L, lua_upvalueindex( 1 ) );
+   lua_insert( L, 1 );
+   lua_call( L, lua_gettop( L ) - 1, LUA_MULTRET );
+   return lua_gettop( L );
+}
+
 /*
  * @brief Closes the global Lua state.
  */
@@ -240,9 +310,10 @@ void lua_exit( void )
    array_free( lua_cache );
    lua_cache = NULL;
 
-   free( common_script );
    lua_close( naevL );
-   naevL = NULL;
+   naevL        = NULL;
+   nlua_common  = LUA_NOREF;
+   nlua_envmeta = LUA_NOREF;
 }
 
 /**
@@ -259,6 +330,106 @@ void lua_clearCache( void )
    array_erase( &lua_cache, array_begin( lua_cache ), array_end( lua_cache ) );
 }
 
+/**
+ * @brief Gets the path of the bytecode cache file of a chunk.
+ *
+ * The key covers the bytecode format, the chunk name (which gets embedded in
+ * the bytecode) and the source itself, so stale entries are never used.
+ */
+static void nlua_cachePath( char *path, size_t len, const char *buff,
+                            size_t sz, const char *name )
+{
+   md5_state_t md5;
+   md5_byte_t  digest[16];
+   char        hex[33];
+   const char *version = NLUA_CACHE_VERSION;
+   const int   ptrsize = sizeof( void * );
+
+   md5_init( &md5 );
+   md5_append( &md5, (const md5_byte_t *)version, strlen( version ) );
+   md5_append( &md5, (const md5_byte_t *)&ptrsize, sizeof( ptrsize ) );
+   md5_append( &md5, (const md5_byte_t *)name, strlen( name ) + 1 );
+   md5_append( &md5, (const md5_byte_t *)buff, sz );
+   md5_finish( &md5, digest );
+   for ( int i = 0; i < 16; i++ )
+      snprintf( &hex[i * 2], 3, "%02x", digest[i] );
+
+   snprintf( path, len, "%s" NLUA_CACHE_DIR "%s", nfile_cachePath(), hex );
+}
+
+/**
+ * @brief lua_dump writer that appends to an array (array.h) of chars.
+ */
+static int nlua_cacheWriter( lua_State *L, const void *p, size_t sz, void *ud )
+{
+   char **data = ud;
+   int    n    = array_size( *data );
+   (void)L;
+   array_resize( data, n + sz );
+   memcpy( &( *data )[n], p, sz );
+   return 0;
+}
+
+/**
+ * @brief Loads a chunk like luaL_loadbuffer, going through the bytecode cache.
+ *
+ * The first time a chunk is seen it gets parsed and its bytecode is written
+ * to the cache path, later runs load the bytecode and skip parsing. Small
+ * chunks are just parsed as that is faster than hitting the disk.
+ *
+ *    @param L Lua state to load into.
+ *    @param buff Source of the chunk.
+ *    @param sz Size of the source.
+ *    @param name Name of the chunk.
+ *    @return 0 on success, a luaL_loadbuffer error code otherwise.
+ */
+int nlua_loadbuffer( lua_State *L, const char *buff, size_t sz,
+                     const char *name )
+{
+   char  path[PATH_MAX];
+   char *data;
+   int   ret;
+
+   /* Not worth it, or already bytecode. */
+   if ( ( sz < NLUA_CACHE_MINSIZE ) || ( buff[0] == LUA_SIGNATURE[0] ) )
+      return luaL_loadbuffer( L, buff, sz, name );
+
+   /* Try to use the cached bytecode. */
+   nlua_cachePath( path, sizeof( path ), buff, sz, name );
+   if ( nfile_fileExists( path ) ) {
+      size_t datasz;
+      data = nfile_readFile( &datasz, path );
+      if ( data != NULL ) {
+         ret = luaL_loadbuffer( L, data, datasz, name );
+         free( data );
+         if ( ret == 0 )
+            return 0;
+         /* Corrupt or from an incompatible build, just overwrite it. */
+         lua_pop( L, 1 );
+      }
+   }
+
+   /* Parse it. */
+   ret = luaL_loadbuffer( L, buff, sz, name );
+   if ( ret != 0 )
+      return ret;
+
+   /* Save for next time. */
+   data = array_create( char );
+   if ( lua_dump( L, nlua_cacheWriter, &data ) == 0 ) {
+      if ( !nlua_cache_dir ) {
+         char dirpath[PATH_MAX];
+         snprintf( dirpath, sizeof( dirpath ), "%s" NLUA_CACHE_DIR,
+                   nfile_cachePath() );
+         nlua_cache_dir = ( nfile_dirMakeExist( dirpath ) == 0 );
+      }
+      if ( nlua_cache_dir )
+         nfile_writeFileAtomic( data, array_size( data ), path );
+   }
+   array_free( data );
+   return 0;
+}
+
 /*
  * @brief Run code from buffer in Lua environment.
  *
@@ -278,7 +449,7 @@ int nlua_dobufenv( nlua_env env, const char *buff, size_t sz, const char *name )
    if ( conf.fpu_except )
       debug_disableFPUExcept();
 #endif /* DEBUGGING */
-   ret = luaL_loadbuffer( naevL, buff, sz, name );
+   ret = nlua_loadbuffer( naevL, buff, sz, name );
    if ( ret != 0 )
       return ret;
 #if DEBUGGING
@@ -336,6 +507,84 @@ void nlua_pushEnvTable( lua_State *L )
 }
 #endif /* DEBUGGING */
 
+/**
+ * @brief Errors when trying to set variables in the common base table.
+ */
+static int nlua_commonReadOnly( lua_State *L )
+{
+   return NLUA_ERROR( L, _( "Common environment is read-only!" ) );
+}
+
+/**
+ * @brief Pushes the metatable shared by all the environments.
+ *
+ * The common script is only run once into a base table that falls back to the
+ * globals, and environments look up what they don't have in the base table.
+ * The base table is read-only and setfenv() refuses the functions using it, so
+ * scripts can't change what other environments see through them.
+ */
+static void nlua_pushEnvMeta( void )
+{
+   char  *buf;
+   size_t bufsz;
+
+   if ( nlua_envmeta != LUA_NOREF ) {
+      lua_rawgeti( naevL, LUA_REGISTRYINDEX, nlua_envmeta ); /* m */
+      return;
+   }
+
+   /* Data isn't available yet, so just fall back to the globals. */
+   if ( !conf.loaded ) {
+      lua_newtable( naevL );                    /* m */
+      lua_pushvalue( naevL, LUA_GLOBALSINDEX ); /* m, g */
+      lua_setfield( naevL, -2, "__index" );     /* m */
+      return;
+   }
+
+   /* Set up the base table. */
+   lua_newtable( naevL );                    /* c */
+   lua_newtable( naevL );                    /* c, m */
+   lua_pushvalue( naevL, LUA_GLOBALSINDEX ); /* c, m, g */
+   lua_setfield( naevL, -2, "__index" );     /* c, m */
+   lua_pushboolean( naevL, 0 );              /* c, m, b */
+   lua_setfield( naevL, -2, "__metatable" ); /* c, m */
+   lua_setmetatable( naevL, -2 );            /* c */
+   nlua_common = luaL_ref( naevL, LUA_REGISTRYINDEX );
+
+   /* Run common script. */
+   buf = ndata_read( LUA_COMMON_PATH, &bufsz );
+   if ( buf == NULL )
+      WARN( _( "Unable to load common script '%s'!" ), LUA_COMMON_PATH );
+   else if ( luaL_loadbuffer( naevL, buf, bufsz, LUA_COMMON_PATH ) == 0 ) {
+      if ( nlua_pcall( nlua_common, 0, 0 ) != 0 ) {
+         WARN( _( "Failed to run '%s':\n%s" ), LUA_COMMON_PATH,
+               lua_tostring( naevL, -1 ) );
+         lua_pop( naevL, 1 );
+      }
+   } else {
+      WARN( _( "Failed to load '%s':\n%s" ), LUA_COMMON_PATH,
+            lua_tostring( naevL, -1 ) );
+      lua_pop( naevL, 1 );
+   }
+   free( buf );
+
+   /* Freeze the base table now that it is set up. */
+   lua_rawgeti( naevL, LUA_REGISTRYINDEX, nlua_common ); /* c */
+   lua_getmetatable( naevL, -1 );                        /* c, m */
+   lua_pushcfunction( naevL, nlua_commonReadOnly );      /* c, m, f */
+   lua_setfield( naevL, -2, "__newindex" );              /* c, m */
+   lua_pop( naevL, 1 );                                  /* c */
+
+   /* Metatable for the environments. */
+   lua_newtable( naevL );                    /* c, m */
+   lua_insert( naevL, -2 );                  /* m, c */
+   lua_setfield( naevL, -2, "__index" );     /* m */
+   lua_pushboolean( naevL, 0 );              /* m, b */
+   lua_setfield( naevL, -2, "__metatable" ); /* m */
+   lua_pushvalue( naevL, -1 );               /* m, m */
+   nlua_envmeta = luaL_ref( naevL, LUA_REGISTRYINDEX );
+}
+
 /*
  * @brief Create an new environment in global Lua state.
  *
@@ -363,11 +612,9 @@ nlua_env nlua_newEnv( const char *name )
    }
 #endif /* DEBUGGING */
 
-   /* Metatable */
-   lua_newtable( naevL );                    /* t, m */
-   lua_pushvalue( naevL, LUA_GLOBALSINDEX ); /* t, m, g */
-   lua_setfield( naevL, -2, "__index" );     /* t, m */
-   lua_setmetatable( naevL, -2 );            /* t */
+   /* Metatable, shared with the common stuff already set up. */
+   nlua_pushEnvMeta();            /* t, m */
+   lua_setmetatable( naevL, -2 ); /* t */
 
    /* Replace require() function with one that considers fenv */
    lua_pushvalue( naevL, -1 );                 /* t, t, */
@@ -409,27 +656,6 @@ nlua_env nlua_newEnv( const char *name )
    lua_newtable( naevL );             /* t, t, n */
    lua_setfield( naevL, -2, "naev" ); /* t, t */
 
-   /* Run common script. */
-   if ( conf.loaded && common_script == NULL ) {
-      common_script = ndata_read( LUA_COMMON_PATH, &common_sz );
-      if ( common_script == NULL )
-         WARN( _( "Unable to load common script '%s'!" ), LUA_COMMON_PATH );
-   }
-   if ( common_script != NULL ) {
-      if ( luaL_loadbuffer( naevL, common_script, common_sz,
-                            LUA_COMMON_PATH ) == 0 ) {
-         if ( nlua_pcall( ref, 0, 0 ) != 0 ) {
-            WARN( _( "Failed to run '%s':\n%s" ), LUA_COMMON_PATH,
-                  lua_tostring( naevL, -1 ) );
-            lua_pop( naevL, 1 );
-         }
-      } else {
-         WARN( _( "Failed to load '%s':\n%s" ), LUA_COMMON_PATH,
-               lua_tostring( naevL, -1 ) );
-         lua_pop( naevL, 1 );
-      }
-   }
-
    lua_pop( naevL, 1 ); /* t */
    return ref;
 }
@@ -572,6 +798,9 @@ static int nlua_loadBasic( lua_State *L )
 
    /* Override built-ins to use Naev for I/O. */
    lua_register( L, "loadstring", luaB_loadstring );
+   lua_getglobal( L, "setfenv" );
+   lua_pushcclosure( L, nlua_setfenv, 1 );
+   lua_setglobal( L, "setfenv" );
    lua_register( L, "print", cli_print );
    lua_register( L, "printRaw", cli_printRaw );
    lua_register( L, "warn", cli_warn );
@@ -727,17 +956,27 @@ static int nlua_package_loader_lua( lua_State *L )
 
    /* Try to process the Lua. It will leave a function or message on the stack,
     * as required. */
-   luaL_loadbuffer( L, buf, bufsize, path_filename );
+   nlua_loadbuffer( L, buf, bufsize, path_filename );
    free( buf );
 
-   /* Cache the result. */
+   /* Cache the result, inserting in place to keep it sorted. */
    if ( L == naevL ) {
-      lc       = &array_grow( &lua_cache );
+      int lo = 0;
+      int hi = array_size( lua_cache );
+      while ( lo < hi ) {
+         int mid = ( lo + hi ) / 2;
+         if ( strcmp( lua_cache[mid].path, path_filename ) < 0 )
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+      array_resize( &lua_cache, array_size( lua_cache ) + 1 );
+      memmove( &lua_cache[lo + 1], &lua_cache[lo],
+               ( array_size( lua_cache ) - lo - 1 ) * sizeof( LuaCache_t ) );
+      lc       = &lua_cache[lo];
       lc->path = strdup( path_filename );
       lua_pushvalue( L, -1 );
       lc->idx = luaL_ref( naevL, LUA_REGISTRYINDEX ); /* pops 1 */
-      qsort( lua_cache, array_size( lua_cache ), sizeof( LuaCache_t ),
-             lua_cache_cmp );
    }
    return 1;
 }
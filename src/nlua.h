@@ -33,6 +33,8 @@ void     nlua_setenv( lua_State *L, nlua_env env, const char *name );
 void     nlua_getenv( lua_State *L, nlua_env env, const char *name );
 void     nlua_register( nlua_env env, const char *libname, const luaL_Reg *l,
                         int metatable );
+int      nlua_loadbuffer( lua_State *L, const char *buff, size_t sz,
+                          const char *name );
 int      nlua_dobufenv( nlua_env env, const char *buff, size_t sz,
                         const char *name );
 int      nlua_dofileenv( nlua_env env, const char *filename );
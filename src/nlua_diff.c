@@ -19,11 +19,13 @@
 static int diffL_apply( lua_State *L );
 static int diffL_remove( lua_State *L );
 static int diffL_isapplied( lua_State *L );
+static int diffL_generation( lua_State *L );
 
 static const luaL_Reg diffL_methods[] = {
    { "apply", diffL_apply },
    { "remove", diffL_remove },
    { "isApplied", diffL_isapplied },
+   { "generation", diffL_generation },
    { 0, 0 } }; /**< Unidiff Lua methods. */
 
 /**
@@ -93,3 +95,18 @@ static int diffL_isapplied( lua_State *L )
    lua_pushboolean( L, diff_isApplied( name ) );
    return 1;
 }
+
+/**
+ * @brief Gets the current diff generation.
+ *
+ * The value changes every time a diff is applied or removed, which makes it
+ * useful to know when data cached from the universe is stale.
+ *
+ *    @luatreturn number Current diff generation.
+ * @luafunc generation
+ */
+static int diffL_generation( lua_State *L )
+{
+   lua_pushinteger( L, diff_generation() );
+   return 1;
+}
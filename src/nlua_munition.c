@@ -138,10 +138,8 @@ Weapon *luaL_validmunition( lua_State *L, int ind )
  */
 LuaMunition *lua_pushmunition( lua_State *L, const Weapon *w )
 {
-   const Weapon *weapon_stack = weapon_getStack();
    LuaMunition *lm = (LuaMunition *)lua_newuserdata( L, sizeof( LuaMunition ) );
    lm->id          = w->id;
-   lm->idx         = w - weapon_stack;
    luaL_getmetatable( L, MUNITION_METATABLE );
    lua_setmetatable( L, -2 );
    return lm;
@@ -189,18 +187,7 @@ static int munitionL_eq( lua_State *L )
 
 static Weapon *munition_get( LuaMunition *lm )
 {
-   Weapon *weapon_stack = weapon_getStack();
-   Weapon *w;
-
-   if ( ( lm->idx < (size_t)array_size( weapon_stack ) ) &&
-        ( weapon_stack[lm->idx].id == lm->id ) )
-      return &weapon_stack[lm->idx];
-
-   w = weapon_getID( lm->id );
-   if ( w == NULL )
-      return NULL;
-   lm->idx = w - weapon_stack; /* For next look ups. */
-   return w;
+   return weapon_getID( lm->id );
 }
 
 /**
@@ -15,8 +15,7 @@
  * @brief Lua Munition wrapper.
  */
 typedef struct LuaMunition_ {
-   unsigned int id;  /**< Munition ID. */
-   size_t       idx; /**< Munition location in stack. */
+   unsigned int id; /**< Munition ID. */
 } LuaMunition;
 
 /*
@@ -948,17 +948,16 @@ static int outfitL_known( lua_State *L )
          }
       }
    }
-   const Spob *ss = spob_getAll();
-   for ( int i = 0; i < array_size( ss ); i++ ) {
-      const Spob *spb = &ss[i];
+   int        n;
+   const int *ids = tech_getSpobsOutfit( o, &n );
+   for ( int i = 0; i < n; i++ ) {
+      const Spob *spb = spob_getIndex( ids[i] );
       if ( !spob_hasService( spb, SPOB_SERVICE_SHIPYARD ) )
          continue;
       if ( !spob_isKnown( spb ) )
          continue;
-      if ( tech_hasOutfit( spb->tech, o ) ) {
-         lua_pushboolean( L, 1 );
-         return 1;
-      }
+      lua_pushboolean( L, 1 );
+      return 1;
    }
    lua_pushboolean( L, 0 );
    return 1;
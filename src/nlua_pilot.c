@@ -46,11 +46,17 @@
 #include "space.h"
 #include "weapon.h"
 
+#define PILOT_INTERN                                                           \
+   "pilot_intern" /**< Registry key of the table of live pilot handles. */
+
 /*
  * From ai.c
  */
 extern Pilot *cur_pilot;
 
+static Pilot **pilotL_within =
+   NULL; /**< Pilots found by the last radius search. */
+
 /*
  * Prototypes.
  */
@@ -500,6 +506,10 @@ static int pilotL_setFlagWrapper( lua_State *L, int flag )
    else
       pilot_rmFlag( p, flag );
 
+   /* Radius searches have to know it can be seen from anywhere now. */
+   if ( state && ( ( flag == PILOT_VISIBLE ) || ( flag == PILOT_VISPLAYER ) ) )
+      pilot_quadtreeAlways( p );
+
    return 0;
 }
 
@@ -560,16 +570,45 @@ Pilot *luaL_validpilot( lua_State *L, int ind )
 /**
  * @brief Pushes a pilot on the stack.
  *
+ * Handles are interned in a weak-valued table keyed by ID, so pushing a pilot
+ * that already has a live handle reuses it instead of allocating a new
+ * userdata. The returned handle may be shared and must not be modified.
+ *
  *    @param L Lua state to push pilot into.
  *    @param pilot Pilot to push.
- *    @return Newly pushed pilot.
+ *    @return Pushed pilot.
  */
 LuaPilot *lua_pushpilot( lua_State *L, LuaPilot pilot )
 {
-   LuaPilot *p = (LuaPilot *)lua_newuserdata( L, sizeof( LuaPilot ) );
-   *p          = pilot;
+   LuaPilot *p;
+
+   lua_getfield( L, LUA_REGISTRYINDEX, PILOT_INTERN ); /* t */
+   if ( lua_isnil( L, -1 ) ) {
+      lua_pop( L, 1 );
+      lua_newtable( L );                                  /* t */
+      lua_newtable( L );                                  /* t, m */
+      lua_pushstring( L, "v" );                           /* t, m, s */
+      lua_setfield( L, -2, "__mode" );                    /* t, m */
+      lua_setmetatable( L, -2 );                          /* t */
+      lua_pushvalue( L, -1 );                             /* t, t */
+      lua_setfield( L, LUA_REGISTRYINDEX, PILOT_INTERN ); /* t */
+   }
+
+   /* Reuse the live handle if there is one. */
+   lua_rawgeti( L, -1, (int)pilot ); /* t, p */
+   if ( !lua_isnil( L, -1 ) ) {
+      lua_remove( L, -2 ); /* p */
+      return (LuaPilot *)lua_touserdata( L, -1 );
+   }
+   lua_pop( L, 1 ); /* t */
+
+   p  = (LuaPilot *)lua_newuserdata( L, sizeof( LuaPilot ) ); /* t, p */
+   *p = pilot;
    luaL_getmetatable( L, PILOT_METATABLE );
    lua_setmetatable( L, -2 );
+   lua_pushvalue( L, -1 );           /* t, p, p */
+   lua_rawseti( L, -3, (int)pilot ); /* t, p */
+   lua_remove( L, -2 );              /* p */
    return p;
 }
 /**
@@ -797,6 +836,8 @@ static int pilotL_add( lua_State *L )
 
    /* Create the pilot. */
    p = pilot_create( ship, pilotname, lf, ai, a, &vp, &vv, flags, 0, 0 );
+   if ( p == NULL )
+      return NLUA_ERROR( L, _( "Unable to create pilot!" ) );
    lua_pushpilot( L, p->id );
    if ( jump == NULL ) {
       ai_newtask( L, p, "idle_wait", 0, 1 );
@@ -822,6 +863,8 @@ static int pilotL_clone( lua_State *L )
 {
    const Pilot *p  = luaL_validpilot( L, 1 );
    LuaPilot     lp = pilot_clone( p );
+   if ( lp == 0 )
+      return NLUA_ERROR( L, _( "Unable to clone pilot!" ) );
    lua_pushpilot( L, lp );
    return 1;
 }
@@ -1087,8 +1130,8 @@ static int pilotL_getPilots( lua_State *L )
 }
 
 static int getFriendOrFoeTest( const Pilot *p, const Pilot *plt, int friend,
-                               double dd, int inrange, int dis, int fighters,
-                               const vec2 *v, LuaFaction lf )
+                               int inrange, int dis, int fighters,
+                               LuaFaction lf )
 {
    /* Check if dead. */
    if ( pilot_isFlag( plt, PILOT_DELETE ) )
@@ -1102,10 +1145,6 @@ static int getFriendOrFoeTest( const Pilot *p, const Pilot *plt, int friend,
    if ( !fighters && pilot_isFlag( plt, PILOT_CARRIED ) )
       return 0;
 
-   /* Check distance if necessary. */
-   if ( ( dd >= 0. ) && vec2_dist2( &plt->solid.pos, v ) > dd )
-      return 0;
-
    /* Check if disabled. */
    if ( dis && pilot_isDisabled( plt ) )
       return 0;
@@ -1143,19 +1182,39 @@ static int getFriendOrFoeTest( const Pilot *p, const Pilot *plt, int friend,
    return 1;
 }
 
+/**
+ * @brief Arguments of getFriendOrFoeTest() for getFriendOrFoeFilter().
+ */
+typedef struct FriendOrFoe_ {
+   const Pilot *p;        /**< Pilot to check from or NULL. */
+   int          friend;   /**< Whether to get friends or foes. */
+   int          inrange;  /**< Whether to check range. */
+   int          dis;      /**< Whether to skip disabled pilots. */
+   int          fighters; /**< Whether to include fighters. */
+   LuaFaction   lf;       /**< Faction to check from if p is NULL. */
+} FriendOrFoe;
+
+/**
+ * @brief Wraps getFriendOrFoeTest() for pilot_getWithin().
+ */
+static int getFriendOrFoeFilter( const Pilot *plt, const void *data )
+{
+   const FriendOrFoe *f = data;
+   return getFriendOrFoeTest( f->p, plt, f->friend, f->inrange, f->dis,
+                              f->fighters, f->lf );
+}
+
 /*
  * Helper to get nearby friends or foes.
  */
 static int pilotL_getFriendOrFoe( lua_State *L, int friend )
 {
-   int           k;
-   double        dd;
-   const Pilot  *p;
-   double        dist;
-   int           inrange, dis, fighters;
-   const vec2   *v;
-   Pilot *const *pilot_stack;
-   LuaFaction    lf;
+   const Pilot *p;
+   double       dist;
+   int          inrange, dis, fighters;
+   const vec2  *v;
+   LuaFaction   lf;
+   FriendOrFoe  f;
 
    /* Check if using faction. */
    lf = -1;
@@ -1182,41 +1241,20 @@ static int pilotL_getFriendOrFoe( lua_State *L, int friend )
       fighters = lua_toboolean( L, 6 );
    }
 
-   if ( dist > 0. )
-      dd = pow2( dist );
-   else
-      dd = -1.;
+   f.p        = p;
+   f.friend   = friend;
+   f.inrange  = inrange;
+   f.dis      = dis;
+   f.fighters = fighters;
+   f.lf       = lf;
+   pilot_getWithin( &pilotL_within, v, ( dist >= 0. ) ? dist : INFINITY, 0,
+                    getFriendOrFoeFilter, &f );
 
    /* Now put all the matching pilots in a table. */
-   pilot_stack = pilot_getAll();
    lua_newtable( L );
-   k = 1;
-   if ( dist >= 0. && dist < INFINITY ) {
-      int            x, y, r;
-      const IntList *qt;
-      x  = round( v->x );
-      y  = round( v->y );
-      r  = ceil( dist );
-      qt = pilot_collideQuery( x - r, y - r, x + r, y + r );
-      for ( int i = 0; i < il_size( qt ); i++ ) {
-         const Pilot *plt = pilot_stack[il_get( qt, i, 0 )];
-
-         if ( getFriendOrFoeTest( p, plt, friend, dd, inrange, dis, fighters, v,
-                                  lf ) ) {
-            lua_pushpilot( L, plt->id ); /* value */
-            lua_rawseti( L, -2, k++ );   /* table[key] = value */
-         }
-      }
-   } else {
-      for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
-         const Pilot *plt = pilot_stack[i];
-
-         if ( getFriendOrFoeTest( p, plt, friend, dd, inrange, dis, fighters, v,
-                                  lf ) ) {
-            lua_pushpilot( L, plt->id ); /* value */
-            lua_rawseti( L, -2, k++ );   /* table[key] = value */
-         }
-      }
+   for ( int i = 0; i < array_size( pilotL_within ); i++ ) {
+      lua_pushpilot( L, pilotL_within[i]->id ); /* value */
+      lua_rawseti( L, -2, i + 1 );              /* table[key] = value */
    }
    return 1;
 }
@@ -1274,12 +1312,33 @@ static int pilotL_getEnemies( lua_State *L )
    return pilotL_getFriendOrFoe( L, 0 );
 }
 
+/**
+ * @brief Arguments of getVisibleFilter().
+ */
+typedef struct VisibleFilter_ {
+   const Pilot *p;   /**< Pilot to get visible pilots of. */
+   int          dis; /**< Whether to skip disabled pilots. */
+} VisibleFilter;
+
+/**
+ * @brief Checks to see if a pilot is visible for pilotL_getVisible().
+ */
+static int getVisibleFilter( const Pilot *plt, const void *data )
+{
+   const VisibleFilter *f = data;
+   /* Check if dead. */
+   if ( pilot_isFlag( plt, PILOT_DELETE ) )
+      return 0;
+   /* Check if disabled. */
+   if ( f->dis && pilot_isDisabled( plt ) )
+      return 0;
+   /* Check visibilitiy. */
+   return pilot_validTarget( f->p, plt );
+}
+
 /**
  * @brief Gets visible pilots to a pilot.
  *
- * @note This function can not use quadtrees and is much slower than getEnemies,
- * getAllies, or getInrange.
- *
  *    @luatparam Pilot pilot Pilot to get visible pilots of.
  *    @luatparam[opt=false] boolean disabled Whether or not to count disabled
  * pilots.
@@ -1291,28 +1350,25 @@ static int pilotL_getEnemies( lua_State *L )
  */
 static int pilotL_getVisible( lua_State *L )
 {
-   int           k;
-   const Pilot  *p   = luaL_validpilot( L, 1 );
-   int           dis = lua_toboolean( L, 2 );
-   Pilot *const *pilot_stack;
+   VisibleFilter       f;
+   double              r;
+   const PilotEWBound *b = pilot_ewBound();
+
+   f.p   = luaL_validpilot( L, 1 );
+   f.dis = lua_toboolean( L, 2 );
+
+   /* Nobody further away than this can be detected, see
+    * pilot_inRangePilot(). */
+   r = FABS( f.p->stats.ew_detect ) *
+       MAX( FABS( f.p->stats.ew_track ) * b->signature, b->detection );
+   pilot_getWithin( &pilotL_within, &f.p->solid.pos, r, 1, getVisibleFilter,
+                    &f );
 
    /* Now put all the matching pilots in a table. */
-   pilot_stack = pilot_getAll();
    lua_newtable( L );
-   k = 1;
-   for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
-      /* Check if dead. */
-      if ( pilot_isFlag( pilot_stack[i], PILOT_DELETE ) )
-         continue;
-      /* Check if disabled. */
-      if ( dis && pilot_isDisabled( pilot_stack[i] ) )
-         continue;
-      /* Check visibilitiy. */
-      if ( !pilot_validTarget( p, pilot_stack[i] ) )
-         continue;
-
-      lua_pushpilot( L, pilot_stack[i]->id ); /* value */
-      lua_rawseti( L, -2, k++ );              /* table[key] = value */
+   for ( int i = 0; i < array_size( pilotL_within ); i++ ) {
+      lua_pushpilot( L, pilotL_within[i]->id ); /* value */
+      lua_rawseti( L, -2, i + 1 );              /* table[key] = value */
    }
 
    return 1;
@@ -3089,6 +3145,7 @@ static int pilotL_setPosition( lua_State *L )
 
    /* Warp pilot to new position. */
    p->solid.pos = *vec;
+   pilot_quadtreeInvalidate();
 
    /* Update if necessary. */
    if ( pilot_isPlayer( p ) )
@@ -6460,6 +6517,7 @@ static int pilotL_setLeader( lua_State *L )
       }
 
       p->parent = leader->id;
+      pilot_quadtreeAlways( p );
 
       /* Reset dock slot */
       dockslot = pilot_getDockSlot( p );
@@ -6495,6 +6553,7 @@ static int pilotL_setLeader( lua_State *L )
          }
 
          pe->parent = p->parent;
+         pilot_quadtreeAlways( pe );
 
          /* Add escort to parent. */
          escort_addList( leader, pe->ship, e->type, pe->id, 0 );
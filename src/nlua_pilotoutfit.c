@@ -363,6 +363,8 @@ static int poL_munition( lua_State *L )
    const vec2      *vv    = luaL_optvector( L, 7, &p->solid.vel );
    int              noaim = lua_toboolean( L, 8 );
    const Weapon    *w     = weapon_add( po, o, dir, vp, vv, p, &t, 0., !noaim );
+   if ( w == NULL )
+      return 0;
    lua_pushmunition( L, w );
    return 1;
 }
@@ -1144,6 +1144,7 @@ static int playerL_land( lua_State *L )
       ovr_initAlpha();
    }
    player.p->solid.pos = spob->pos; /* Set position to target. */
+   pilot_quadtreeInvalidate();
 
    /* End autonav. */
    player_autonavEnd();
@@ -2398,6 +2399,7 @@ static int playerL_teleport( lua_State *L )
          pilot_clearTrails( p );
       }
    }
+   pilot_quadtreeInvalidate();
 
    return 0;
 }
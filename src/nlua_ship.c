@@ -856,17 +856,16 @@ static int shipL_known( lua_State *L )
          return 1;
       }
    }
-   const Spob *ss = spob_getAll();
-   for ( int i = 0; i < array_size( ss ); i++ ) {
-      const Spob *spb = &ss[i];
+   int        n;
+   const int *ids = tech_getSpobsShip( s, &n );
+   for ( int i = 0; i < n; i++ ) {
+      const Spob *spb = spob_getIndex( ids[i] );
       if ( !spob_hasService( spb, SPOB_SERVICE_SHIPYARD ) )
          continue;
       if ( !spob_isKnown( spb ) )
          continue;
-      if ( tech_hasShip( spb->tech, s ) ) {
-         lua_pushboolean( L, 1 );
-         return 1;
-      }
+      lua_pushboolean( L, 1 );
+      return 1;
    }
    lua_pushboolean( L, 0 );
    return 1;
@@ -469,6 +469,13 @@ static int systemL_jumpdistance( lua_State *L )
       return 1;
    }
 
+   /* Jump counts not depending on the player's knowledge are cached. */
+   if ( k ) {
+      int d = map_jumpDist( start, goal, h );
+      lua_pushnumber( L, ( d < 0 ) ? HUGE_VAL : d );
+      return 1;
+   }
+
    s = map_getJumpPath( start, NULL, goal, k, h, NULL, NULL );
    if ( s == NULL ) {
       lua_pushnumber( L, HUGE_VAL );
@@ -468,6 +468,13 @@ static int gl_getGLInfo( void )
    if ( GLAD_GL_ARB_shader_subroutine && glGetSubroutineIndex &&
         glGetSubroutineUniformLocation && glUniformSubroutinesuiv )
       gl_screen.flags |= OPENGL_SUBROUTINES;
+   if ( GLAD_GL_ARB_get_program_binary && glGetProgramBinary &&
+        glProgramBinary && glProgramParameteri ) {
+      GLint nformats = 0;
+      glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &nformats );
+      if ( nformats > 0 )
+         gl_screen.flags |= OPENGL_PROGRAM_BINARY;
+   }
    /* Calculate real depth. */
    gl_screen.depth = gl_screen.r + gl_screen.g + gl_screen.b + gl_screen.a;
 
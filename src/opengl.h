@@ -30,6 +30,8 @@
 #define OPENGL_SUBROUTINES                                                     \
    ( 1 << 3 ) /**< Ability to use shader subroutines.                          \
                */
+#define OPENGL_PROGRAM_BINARY                                                  \
+   ( 1 << 4 ) /**< Ability to save and load linked programs. */
 #define gl_has( f ) ( gl_screen.flags & ( f ) ) /**< Check for the flag */
 /**
  * @brief Stores data about the current opengl environment.
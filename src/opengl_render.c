@@ -29,11 +29,23 @@
 
 #include "opengl_render.h"
 
+#include "array.h"
 #include "camera.h"
 #include "gui.h"
 #include "opengl.h"
 
 #define OPENGL_RENDER_VBO_SIZE 256 /**< Size of VBO. */
+#define SPRITE_BATCH_VERTEX                                                    \
+   ( 2 + 2 + 4 ) /**< Floats per batched vertex: position, texture coordinates \
+                    and colour. */
+
+/**
+ * @brief Consecutive sprites queued for drawing that share a texture.
+ */
+typedef struct SpriteBatch_ {
+   GLuint   texture; /**< Texture of the sprites. */
+   GLfloat *data;    /**< Vertex data, 6 vertices per sprite. */
+} SpriteBatch;
 
 static gl_vbo *gl_renderVBO          = 0; /**< VBO for rendering stuff. */
 gl_vbo        *gl_squareVBO          = 0;
@@ -43,6 +55,11 @@ static gl_vbo *gl_lineVBO            = 0;
 static gl_vbo *gl_triangleVBO        = 0;
 static int     gl_renderVBOtexOffset = 0; /**< VBO texture offset. */
 static int     gl_renderVBOcolOffset = 0; /**< VBO colour offset. */
+static SpriteBatch *gl_spriteBatch =
+   NULL; /**< Sprite batches, in the order they were queued. */
+static int     gl_spriteBatchUsed = 0; /**< Batches in use. */
+static gl_vbo *gl_spriteBatchVBO  = NULL; /**< VBO for batched sprites. */
+static GLsizei gl_spriteBatchSize = 0;    /**< Size of the batch VBO. */
 
 void gl_beginSolidProgram( mat4 projection, const glColour *c )
 {
@@ -703,6 +720,148 @@ void gl_renderSprite( const glTexture *sprite, double bx, double by, int sx,
                      0. );
 }
 
+/**
+ * @brief Queues a sprite to be blitted, position is relative to the player.
+ *
+ * Same as gl_renderSprite(), but the sprite is only drawn on the next
+ *  gl_renderSpriteFlush(). Sprites queued one after another with the same
+ *  texture are drawn in a single draw call, and all the sprites are drawn in
+ *  the order they were queued.
+ *
+ *    @param sprite Sprite to blit.
+ *    @param bx X position of the texture relative to the player.
+ *    @param by Y position of the texture relative to the player.
+ *    @param sx X position of the sprite to use.
+ *    @param sy Y position of the sprite to use.
+ *    @param c Colour to use (modifies texture colour).
+ */
+void gl_renderSpriteBatched( const glTexture *sprite, double bx, double by,
+                             int sx, int sy, const glColour *c )
+{
+   double       x, y, w, h, tx, ty, z;
+   SpriteBatch *batch = NULL;
+   GLfloat     *v;
+   /* Corners of the quad, as two triangles. */
+   const GLfloat corners[6][2] = { { 0., 0. }, { 1., 0. }, { 0., 1. },
+                                   { 1., 0. }, { 1., 1. }, { 0., 1. } };
+
+   /* Translate coords. */
+   z = cam_getZoom();
+   gl_gameToScreenCoords( &x, &y, bx - sprite->sw * 0.5,
+                          by - sprite->sh * 0.5 );
+
+   /* Scaled sprite dimensions. */
+   w = sprite->sw * z;
+   h = sprite->sh * z;
+
+   /* check if inbounds */
+   if ( ( x < -w ) || ( x > SCREEN_W + w ) || ( y < -h ) ||
+        ( y > SCREEN_H + h ) )
+      return;
+
+   /* texture coords */
+   tx = sprite->sw * (double)( sx ) / sprite->w;
+   ty = sprite->sh * ( sprite->sy - (double)sy - 1 ) / sprite->h;
+
+   if ( c == NULL )
+      c = &cWhite;
+
+   /* Only join the last batch, so the drawing order is kept. */
+   if ( ( gl_spriteBatchUsed > 0 ) &&
+        ( gl_spriteBatch[gl_spriteBatchUsed - 1].texture == sprite->texture ) )
+      batch = &gl_spriteBatch[gl_spriteBatchUsed - 1];
+   else {
+      if ( gl_spriteBatch == NULL )
+         gl_spriteBatch = array_create( SpriteBatch );
+      if ( gl_spriteBatchUsed >= array_size( gl_spriteBatch ) ) {
+         batch       = &array_grow( &gl_spriteBatch );
+         batch->data = array_create( GLfloat );
+      }
+      batch          = &gl_spriteBatch[gl_spriteBatchUsed++];
+      batch->texture = sprite->texture;
+   }
+
+   /* Add the vertices. */
+   array_resize( &batch->data,
+                 array_size( batch->data ) + 6 * SPRITE_BATCH_VERTEX );
+   v = &batch->data[array_size( batch->data ) - 6 * SPRITE_BATCH_VERTEX];
+   for ( int i = 0; i < 6; i++ ) {
+      GLfloat ty_v = ty + corners[i][1] * sprite->srh;
+      v[0]         = x + corners[i][0] * w;
+      v[1]         = y + corners[i][1] * h;
+      v[2]         = tx + corners[i][0] * sprite->srw;
+      /* Same as the texture matrix of gl_renderTextureRaw(). */
+      v[3] = ( sprite->flags & OPENGL_TEX_VFLIP ) ? 1. - ty_v : ty_v;
+      v[4] = c->r;
+      v[5] = c->g;
+      v[6] = c->b;
+      v[7] = c->a;
+      v += SPRITE_BATCH_VERTEX;
+   }
+}
+
+/**
+ * @brief Draws all the sprites queued with gl_renderSpriteBatched().
+ *
+ * Has to be called before anything that has to be drawn above the queued
+ *  sprites.
+ */
+void gl_renderSpriteFlush( void )
+{
+   const GLsizei stride = sizeof( GLfloat ) * SPRITE_BATCH_VERTEX;
+
+   if ( gl_spriteBatchUsed <= 0 )
+      return;
+
+   if ( gl_spriteBatchVBO == NULL )
+      gl_spriteBatchVBO = gl_vboCreateStream( 0, NULL );
+
+   glUseProgram( shaders.texture_batch.program );
+   gl_uniformMat4( shaders.texture_batch.projection, &gl_view_matrix );
+   glEnableVertexAttribArray( shaders.texture_batch.vertex );
+   glEnableVertexAttribArray( shaders.texture_batch.vertex_tex );
+   glEnableVertexAttribArray( shaders.texture_batch.vertex_colour );
+
+   for ( int i = 0; i < gl_spriteBatchUsed; i++ ) {
+      SpriteBatch *batch = &gl_spriteBatch[i];
+      GLsizei      size  = sizeof( GLfloat ) * array_size( batch->data );
+
+      /* Upload, growing the VBO if necessary. */
+      if ( size > gl_spriteBatchSize ) {
+         gl_vboData( gl_spriteBatchVBO, size, batch->data );
+         gl_spriteBatchSize = size;
+      } else
+         gl_vboSubData( gl_spriteBatchVBO, 0, size, batch->data );
+
+      gl_vboActivateAttribOffset( gl_spriteBatchVBO,
+                                  shaders.texture_batch.vertex, 0, 2, GL_FLOAT,
+                                  stride );
+      gl_vboActivateAttribOffset( gl_spriteBatchVBO,
+                                  shaders.texture_batch.vertex_tex,
+                                  sizeof( GLfloat ) * 2, 2, GL_FLOAT, stride );
+      gl_vboActivateAttribOffset( gl_spriteBatchVBO,
+                                  shaders.texture_batch.vertex_colour,
+                                  sizeof( GLfloat ) * 4, 4, GL_FLOAT, stride );
+
+      glBindTexture( GL_TEXTURE_2D, batch->texture );
+      glDrawArrays( GL_TRIANGLES, 0,
+                    array_size( batch->data ) / SPRITE_BATCH_VERTEX );
+
+      /* Keep the memory around for the next flush. */
+      array_erase( &batch->data, array_begin( batch->data ),
+                   array_end( batch->data ) );
+   }
+   gl_spriteBatchUsed = 0;
+
+   glDisableVertexAttribArray( shaders.texture_batch.vertex );
+   glDisableVertexAttribArray( shaders.texture_batch.vertex_tex );
+   glDisableVertexAttribArray( shaders.texture_batch.vertex_colour );
+   glUseProgram( 0 );
+
+   /* anything failed? */
+   gl_checkErr();
+}
+
 /**
  * @brief Blits a sprite, position is relative to the player.
  *
@@ -1331,5 +1490,13 @@ void gl_exitRender( void )
    gl_vboDestroy( gl_squareEmptyVBO );
    gl_vboDestroy( gl_lineVBO );
    gl_vboDestroy( gl_triangleVBO );
-   gl_renderVBO = NULL;
+   gl_vboDestroy( gl_spriteBatchVBO );
+   gl_renderVBO       = NULL;
+   gl_spriteBatchVBO  = NULL;
+   gl_spriteBatchSize = 0;
+   for ( int i = 0; i < array_size( gl_spriteBatch ); i++ )
+      array_free( gl_spriteBatch[i].data );
+   array_free( gl_spriteBatch );
+   gl_spriteBatch     = NULL;
+   gl_spriteBatchUsed = 0;
 }
@@ -58,6 +58,9 @@ void gl_renderTextureInterpolate( const glTexture *ta, const glTexture *tb,
 /* blits a sprite, relative pos */
 void gl_renderSprite( const glTexture *sprite, double bx, double by, int sx,
                       int sy, const glColour *c );
+void gl_renderSpriteBatched( const glTexture *sprite, double bx, double by,
+                             int sx, int sy, const glColour *c );
+void gl_renderSpriteFlush( void );
 void gl_renderSpriteScale( const glTexture *sprite, double bx, double by,
                            double scalew, double scaleh, int sx, int sy,
                            const glColour *c );
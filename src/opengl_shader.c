@@ -8,10 +8,20 @@
 /** @endcond */
 
 #include "log.h"
+#include "md5.h"
 #include "ndata.h"
+#include "nfile.h"
 #include "nstring.h"
 #include "opengl.h"
 
+#define GL_PROGRAM_CACHE_DIR                                                   \
+   "glsl/" /**< Subdirectory of the cache path with program binaries. */
+
+static int gl_program_cache_dir =
+   0; /**< Whether the program binary directory exists. */
+static int gl_program_cache_hits =
+   0; /**< Number of programs loaded from the binary cache. */
+
 /*
  * Prototypes.
  */
@@ -26,6 +36,10 @@ static int    gl_program_link( GLuint program );
 static GLuint gl_program_make( GLuint vertex_shader, GLuint fragment_shader,
                                GLuint geometry_shader );
 static int    gl_log_says_anything( const char *log );
+static void   gl_program_cachePath( char *path, size_t len, const char **src,
+                                    const size_t *size, int n );
+static GLuint gl_program_cacheLoad( const char *path );
+static void   gl_program_cacheSave( GLuint program, const char *path );
 
 /**
  * @brief Loads a GLSL file with some simple preprocessing like adding #version
@@ -229,6 +243,130 @@ static int gl_program_link( GLuint program )
    return 0;
 }
 
+/**
+ * @brief Gets the path of the binary cache file of a program.
+ *
+ * The key covers the driver and all the preprocessed sources, which include
+ * the defines, so a changed shader or driver never loads a stale binary.
+ *
+ *    @param[out] path Path of the cache file.
+ *    @param len Length of path.
+ *    @param src Preprocessed sources of the stages.
+ *    @param size Sizes of the sources.
+ *    @param n Number of stages.
+ */
+static void gl_program_cachePath( char *path, size_t len, const char **src,
+                                  const size_t *size, int n )
+{
+   md5_state_t  md5;
+   md5_byte_t   digest[16];
+   char         hex[33];
+   const GLenum info[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+
+   md5_init( &md5 );
+   for ( size_t i = 0; i < sizeof( info ) / sizeof( info[0] ); i++ ) {
+      const char *str = (const char *)glGetString( info[i] );
+      if ( str != NULL )
+         md5_append( &md5, (const md5_byte_t *)str, strlen( str ) + 1 );
+   }
+   for ( int i = 0; i < n; i++ ) {
+      md5_append( &md5, (const md5_byte_t *)&size[i], sizeof( size[i] ) );
+      md5_append( &md5, (const md5_byte_t *)src[i], size[i] );
+   }
+   md5_finish( &md5, digest );
+   for ( int i = 0; i < 16; i++ )
+      snprintf( &hex[i * 2], 3, "%02x", digest[i] );
+
+   snprintf( path, len, "%s" GL_PROGRAM_CACHE_DIR "%s", nfile_cachePath(),
+             hex );
+}
+
+/**
+ * @brief Tries to load a linked program from the binary cache.
+ *
+ *    @param path Path of the cache file.
+ *    @return The program or 0 if not cached or rejected by the driver.
+ */
+static GLuint gl_program_cacheLoad( const char *path )
+{
+   GLuint program;
+   GLenum format;
+   GLint  link_status;
+   size_t size;
+   char  *data;
+
+   if ( !nfile_fileExists( path ) )
+      return 0;
+   data = nfile_readFile( &size, path );
+   if ( data == NULL )
+      return 0;
+   if ( size <= sizeof( GLenum ) ) {
+      free( data );
+      return 0;
+   }
+
+   /* The binary format is stored first, then the binary itself. */
+   memcpy( &format, data, sizeof( GLenum ) );
+   program = glCreateProgram();
+   glProgramBinary( program, format, &data[sizeof( GLenum )],
+                    size - sizeof( GLenum ) );
+   free( data );
+
+   /* Drivers may reject binaries at any time, in which case we recompile and
+    * overwrite them. Unknown formats raise an error we don't care about. */
+   glGetError();
+   glGetProgramiv( program, GL_LINK_STATUS, &link_status );
+   if ( link_status == GL_FALSE ) {
+      glDeleteProgram( program );
+      return 0;
+   }
+   return program;
+}
+
+/**
+ * @brief Saves a linked program to the binary cache.
+ *
+ *    @param program Program to save.
+ *    @param path Path of the cache file.
+ */
+static void gl_program_cacheSave( GLuint program, const char *path )
+{
+   GLint   length = 0;
+   GLsizei written;
+   GLenum  format;
+   char   *data;
+
+   glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length );
+   if ( length <= 0 )
+      return;
+
+   data    = malloc( sizeof( GLenum ) + length );
+   written = 0;
+   glGetProgramBinary( program, length, &written, &format,
+                       &data[sizeof( GLenum )] );
+   if ( written > 0 ) {
+      memcpy( data, &format, sizeof( GLenum ) );
+      if ( !gl_program_cache_dir ) {
+         char dirpath[PATH_MAX];
+         snprintf( dirpath, sizeof( dirpath ), "%s" GL_PROGRAM_CACHE_DIR,
+                   nfile_cachePath() );
+         gl_program_cache_dir = ( nfile_dirMakeExist( dirpath ) == 0 );
+      }
+      if ( gl_program_cache_dir )
+         nfile_writeFileAtomic( data, sizeof( GLenum ) + written, path );
+   }
+   free( data );
+   gl_checkErr();
+}
+
+/**
+ * @brief Gets the number of programs that were loaded from the binary cache.
+ */
+int gl_program_cacheHits( void )
+{
+   return gl_program_cache_hits;
+}
+
 GLuint gl_program_vert_frag_geom( const char *vert, const char *frag,
                                   const char *geom )
 {
@@ -251,9 +389,13 @@ GLuint gl_program_vert_frag( const char *vert, const char *frag )
 GLuint gl_program_backend( const char *vertfile, const char *fragfile,
                            const char *geomfile, const char *prependtext )
 {
-   char  *vert_str, *frag_str, prepend[STRMAX];
-   size_t vert_size, frag_size;
-   GLuint vertex_shader, fragment_shader, geometry_shader, program;
+   char       *vert_str, *frag_str, *geom_str, prepend[STRMAX];
+   size_t      vert_size, frag_size, geom_size = 0;
+   GLuint      vertex_shader, fragment_shader, geometry_shader, program;
+   char        cachepath[PATH_MAX];
+   const char *src[3];
+   size_t      srcsize[3];
+   int         cache;
 
    snprintf( prepend, sizeof( prepend ) - 1,
              "#version %d\n\n#define GLSL_VERSION %d\n", gl_screen.glsl,
@@ -267,28 +409,53 @@ GLuint gl_program_backend( const char *vertfile, const char *fragfile,
 
    vert_str = gl_shader_loadfile( vertfile, &vert_size, prepend );
    frag_str = gl_shader_loadfile( fragfile, &frag_size, prepend );
+   geom_str = NULL;
+   if ( geomfile != NULL )
+      geom_str = gl_shader_loadfile( geomfile, &geom_size, prepend );
+
+   /* Try to skip compiling and linking altogether. */
+   cache = gl_has( OPENGL_PROGRAM_BINARY ) && ( vert_str != NULL ) &&
+           ( frag_str != NULL ) &&
+           ( ( geomfile == NULL ) || ( geom_str != NULL ) );
+   if ( cache ) {
+      src[0]     = vert_str;
+      srcsize[0] = vert_size;
+      src[1]     = frag_str;
+      srcsize[1] = frag_size;
+      src[2]     = geom_str;
+      srcsize[2] = geom_size;
+      gl_program_cachePath( cachepath, sizeof( cachepath ), src, srcsize,
+                            ( geom_str != NULL ) ? 3 : 2 );
+      program = gl_program_cacheLoad( cachepath );
+      if ( program != 0 ) {
+         gl_program_cache_hits++;
+         free( vert_str );
+         free( frag_str );
+         free( geom_str );
+         return program;
+      }
+   }
 
    vertex_shader =
       gl_shader_compile( GL_VERTEX_SHADER, vert_str, vert_size, vertfile );
    fragment_shader =
       gl_shader_compile( GL_FRAGMENT_SHADER, frag_str, frag_size, fragfile );
-
-   free( vert_str );
-   free( frag_str );
-
-   if ( geomfile != NULL ) {
-      size_t geom_size;
-      char  *geom_str = gl_shader_loadfile( geomfile, &geom_size, prepend );
+   if ( geom_str != NULL )
       geometry_shader =
          gl_shader_compile( GL_GEOMETRY_SHADER, geom_str, geom_size, geomfile );
-      free( geom_str );
-   } else
+   else
       geometry_shader = 0;
 
+   free( vert_str );
+   free( frag_str );
+   free( geom_str );
+
    program = gl_program_make( vertex_shader, fragment_shader, geometry_shader );
    if ( program == 0 )
       WARN( _( "Failed to link vertex shader '%s' and fragment shader '%s'!" ),
             vertfile, fragfile );
+   else if ( cache )
+      gl_program_cacheSave( program, cachepath );
 
    return program;
 }
@@ -342,6 +509,9 @@ static GLuint gl_program_make( GLuint vertex_shader, GLuint fragment_shader,
       glAttachShader( program, fragment_shader );
       if ( geometry_shader != 0 )
          glAttachShader( program, geometry_shader );
+      if ( gl_has( OPENGL_PROGRAM_BINARY ) )
+         glProgramParameteri( program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                              GL_TRUE );
 
       if ( gl_program_link( program ) == -1 ) {
          /* Spec specifies 0 as failure value for glCreateProgram() */
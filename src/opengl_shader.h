@@ -16,6 +16,7 @@ GLuint gl_program_vert_frag_geom( const char *vert, const char *frag,
 GLuint gl_program_vert_frag( const char *vert, const char *frag );
 GLuint gl_program_vert_frag_string( const char *vert, size_t vert_size,
                                     const char *frag, size_t frag_size );
+int    gl_program_cacheHits( void );
 void   gl_uniformColour( GLint location, const glColour *c );
 void   gl_uniformAColour( GLint location, const glColour *c, GLfloat a );
 void   gl_uniformMat4( GLint location, const mat4 *m );
@@ -25,12 +25,18 @@
 /*
  * graphic list
  */
+#define TEX_CACHE_FLAGS                                                        \
+   ( OPENGL_TEX_SDF | OPENGL_TEX_VFLIP | OPENGL_TEX_MAPTRANS |                 \
+     OPENGL_TEX_NOTSRGB ) /**< Flags that make textures different. */
+#define TEX_HASH_MIN 256  /**< Minimum number of slots in the hash tables. */
+
 /**
  * @brief Represents a node in the texture list.
  */
 typedef struct glTexList_ {
    glTexture  *tex;  /**< associated texture */
    const char *path; /**< Path pointer, stored in tex. */
+   uint32_t    hash; /**< Hash of the path, sprites and flags. */
    int         used; /**< counts how many times texture is being used */
    /* TODO We currently treat images with different number of sprites as
     * different images, i.e., they get reloaded and use more memory. However,
@@ -40,7 +46,14 @@ typedef struct glTexList_ {
    int          sy;    /**< Y sprites */
    unsigned int flags; /**< Flags being used. */
 } glTexList;
-static glTexList   *texture_list = NULL; /**< Texture list. */
+static glTexList *texture_list =
+   NULL; /**< Texture list (array.h), unsorted, indexed by the tables. */
+static int *tex_hkey =
+   NULL; /**< Open addressing table of texture_list indices by key, only has
+            the textures with a path. */
+static int *tex_hptr =
+   NULL; /**< Open addressing table of texture_list indices by texture. */
+static int          tex_hmask = 0; /**< Number of slots in the tables - 1. */
 static SDL_threadID tex_mainthread;
 static SDL_mutex   *gl_lock  = NULL; /**< Lock for OpenGL functions. */
 static SDL_mutex   *tex_lock = NULL; /**< Lock for texture list manipulation. */
@@ -51,8 +64,10 @@ static SDL_mutex   *tex_lock = NULL; /**< Lock for texture list manipulation. */
 /* misc */
 static uint8_t             SDL_GetAlpha( SDL_Surface *s, int x, int y );
 static int                 SDL_IsTrans( SDL_Surface *s, int x, int y );
-static USE_RESULT uint8_t *SDL_MapAlpha( SDL_Surface *s, int tight );
-static size_t              gl_transSize( const int w, const int h );
+static USE_RESULT uint8_t  *SDL_MapAlpha( SDL_Surface *s );
+static USE_RESULT uint64_t *SDL_MapTrans( SDL_Surface *s );
+static int                  gl_transStride( const int w );
+static size_t               gl_transSize( const int w, const int h );
 /* glTexture */
 static USE_RESULT GLuint gl_texParameters( unsigned int flags );
 static USE_RESULT GLuint gl_loadSurface( SDL_Surface *surface,
@@ -67,7 +82,19 @@ static int gl_loadNewImageRWops( glTexture *tex, const char *path,
 static glTexture *gl_texCreate( const char *path, int sx, int sy,
                                 unsigned int flags );
 static int gl_texAdd( glTexture *tex, int sx, int sy, unsigned int flags );
-static int tex_cmp( const void *p1, const void *p2 );
+static void gl_texRemove( int idx );
+/* Hash tables. */
+static uint32_t   tex_hashKey( const char *path, int sx, int sy,
+                               unsigned int flags );
+static uint32_t   tex_hashPtr( const glTexture *tex );
+static uint32_t   tex_hashEntry( int idx, int byptr );
+static void       tex_hashInsert( int *table, int idx, int byptr );
+static int        tex_hashSlot( const int *table, int idx, int byptr );
+static void       tex_hashRemove( int *table, int idx, int byptr );
+static void       tex_hashRebuild( int size );
+static glTexList *tex_find( const char *path, int sx, int sy,
+                            unsigned int flags );
+static int        tex_findPtr( const glTexture *tex );
 
 static void tex_ctxSet( void )
 {
@@ -93,22 +120,161 @@ void gl_contextUnset( void )
    SDL_mutexV( gl_lock );
 }
 
-static int tex_cmp( const void *p1, const void *p2 )
+/**
+ * @brief Hashes the key textures are cached by.
+ */
+static uint32_t tex_hashKey( const char *path, int sx, int sy,
+                             unsigned int flags )
+{
+   /* FNV-1a. */
+   uint32_t h = 2166136261u;
+   for ( const unsigned char *c = (const unsigned char *)path; *c != '\0';
+         c++ )
+      h = ( h ^ *c ) * 16777619u;
+   h = ( h ^ (uint32_t)sx ) * 16777619u;
+   h = ( h ^ (uint32_t)sy ) * 16777619u;
+   h = ( h ^ ( flags & TEX_CACHE_FLAGS ) ) * 16777619u;
+   return h;
+}
+
+/**
+ * @brief Hashes a texture pointer.
+ */
+static uint32_t tex_hashPtr( const glTexture *tex )
 {
-   const glTexList   *t1        = (const glTexList *)p1;
-   const glTexList   *t2        = (const glTexList *)p2;
-   const unsigned int testflags = OPENGL_TEX_SDF | OPENGL_TEX_VFLIP |
-                                  OPENGL_TEX_MAPTRANS | OPENGL_TEX_NOTSRGB;
-   int ret = strcmp( t1->path, t2->path );
-   if ( ret != 0 )
-      return ret;
-   ret = t1->sx - t2->sx;
-   if ( ret != 0 )
-      return ret;
-   ret = t1->sy - t2->sy;
-   if ( ret != 0 )
-      return ret;
-   return ( t1->flags & testflags ) - ( t2->flags & testflags );
+   /* Finalizer of MurmurHash3, pointers have low entropy in the low bits. */
+   uint64_t h = (uintptr_t)tex;
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   return (uint32_t)h;
+}
+
+/**
+ * @brief Gets the hash of an element of texture_list for one of the tables.
+ */
+static uint32_t tex_hashEntry( int idx, int byptr )
+{
+   const glTexList *t = &texture_list[idx];
+   return ( byptr ) ? tex_hashPtr( t->tex ) : t->hash;
+}
+
+/**
+ * @brief Inserts an element of texture_list into one of the tables.
+ */
+static void tex_hashInsert( int *table, int idx, int byptr )
+{
+   int i = tex_hashEntry( idx, byptr ) & tex_hmask;
+   while ( table[i] >= 0 )
+      i = ( i + 1 ) & tex_hmask;
+   table[i] = idx;
+}
+
+/**
+ * @brief Gets the slot of an element of texture_list in one of the tables.
+ */
+static int tex_hashSlot( const int *table, int idx, int byptr )
+{
+   int i = tex_hashEntry( idx, byptr ) & tex_hmask;
+   while ( table[i] != idx )
+      i = ( i + 1 ) & tex_hmask;
+   return i;
+}
+
+/**
+ * @brief Removes an element of texture_list from one of the tables.
+ *
+ * Uses backward shift deletion so no tombstones are needed.
+ */
+static void tex_hashRemove( int *table, int idx, int byptr )
+{
+   int i = tex_hashSlot( table, idx, byptr );
+   for ( ;; ) {
+      int j    = i;
+      table[i] = -1;
+      for ( ;; ) {
+         int k;
+         j = ( j + 1 ) & tex_hmask;
+         if ( table[j] < 0 )
+            return;
+         /* Can only be moved back if its home slot is not in (i,j]. */
+         k = tex_hashEntry( table[j], byptr ) & tex_hmask;
+         if ( ( i <= j ) ? ( ( i < k ) && ( k <= j ) )
+                         : ( ( i < k ) || ( k <= j ) ) )
+            continue;
+         break;
+      }
+      table[i] = table[j];
+      i        = j;
+   }
+}
+
+/**
+ * @brief Rebuilds the tables with a new size.
+ *
+ *    @param size Number of slots, must be a power of two.
+ */
+static void tex_hashRebuild( int size )
+{
+   free( tex_hkey );
+   free( tex_hptr );
+   tex_hkey  = malloc( size * sizeof( int ) );
+   tex_hptr  = malloc( size * sizeof( int ) );
+   tex_hmask = size - 1;
+   for ( int i = 0; i < size; i++ )
+      tex_hkey[i] = tex_hptr[i] = -1;
+   for ( int i = 0; i < array_size( texture_list ); i++ ) {
+      /* Textures without a path can't be looked up by key. */
+      if ( texture_list[i].path != NULL )
+         tex_hashInsert( tex_hkey, i, 0 );
+      tex_hashInsert( tex_hptr, i, 1 );
+   }
+}
+
+/**
+ * @brief Looks up a cached texture.
+ *
+ * @note Must hold tex_lock.
+ *
+ *    @return The texture list node or NULL if not found.
+ */
+static glTexList *tex_find( const char *path, int sx, int sy,
+                            unsigned int flags )
+{
+   uint32_t h;
+
+   if ( tex_hkey == NULL )
+      return NULL;
+
+   h = tex_hashKey( path, sx, sy, flags );
+   for ( int i = h & tex_hmask; tex_hkey[i] >= 0; i = ( i + 1 ) & tex_hmask ) {
+      glTexList *t = &texture_list[tex_hkey[i]];
+      if ( ( t->hash == h ) && ( t->path != NULL ) && ( t->sx == sx ) &&
+           ( t->sy == sy ) &&
+           ( ( t->flags & TEX_CACHE_FLAGS ) == ( flags & TEX_CACHE_FLAGS ) ) &&
+           ( strcmp( t->path, path ) == 0 ) )
+         return t;
+   }
+   return NULL;
+}
+
+/**
+ * @brief Looks up the texture list node of a texture.
+ *
+ * @note Must hold tex_lock.
+ *
+ *    @return Index in texture_list or -1 if not found.
+ */
+static int tex_findPtr( const glTexture *tex )
+{
+   if ( tex_hptr == NULL )
+      return -1;
+
+   for ( int i = tex_hashPtr( tex ) & tex_hmask; tex_hptr[i] >= 0;
+         i = ( i + 1 ) & tex_hmask )
+      if ( texture_list[tex_hptr[i]].tex == tex )
+         return tex_hptr[i];
+   return -1;
 }
 
 /**
@@ -156,52 +322,72 @@ static int SDL_IsTrans( SDL_Surface *s, int x, int y )
    return a > 127;
 }
 
+/**
+ * @brief Maps the surface alpha.
+ *
+ *    @param s Surface to map the alpha of.
+ *    @return One byte of alpha per pixel.
+ */
+static uint8_t *SDL_MapAlpha( SDL_Surface *s )
+{
+   int      w = s->w;
+   int      h = s->h;
+   uint8_t *t = malloc( w * h );
+   /* Check each pixel individually. */
+   for ( int i = 0; i < h; i++ )
+      for ( int j = 0; j < w; j++ )
+         t[i * w + j] = SDL_GetAlpha( s, j, i );
+   return t;
+}
+
 /**
  * @brief Maps the surface transparency.
  *
  * Basically generates a map of what pixels are transparent.  Good for pixel
- *  perfect collision routines.
+ *  perfect collision routines. Each row starts on a new word and bit x of a
+ *  row is set if the pixel isn't transparent, so rows can be tested 64 pixels
+ *  at a time.
  *
  *    @param s Surface to map its transparency.
- *    @param tight Whether or not to store transparency per bit or
- *    @return 0 on success.
+ *    @return The transparency map, see gl_transSize() for the size.
  */
-static uint8_t *SDL_MapAlpha( SDL_Surface *s, int tight )
+static uint64_t *SDL_MapTrans( SDL_Surface *s )
 {
-   uint8_t *t;
-   int      w = s->w;
-   int      h = s->h;
+   int       w      = s->w;
+   int       h      = s->h;
+   int       stride = gl_transStride( w );
+   uint64_t *t      = calloc( 1, gl_transSize( w, h ) );
+   if ( t == NULL ) {
+      WARN( _( "Out of Memory" ) );
+      return NULL;
+   }
 
-   if ( tight ) {
-      /* alloc memory for just enough bits to hold all the data we need */
-      size_t size = gl_transSize( w, h );
-      t           = malloc( size );
-      if ( t == NULL ) {
-         WARN( _( "Out of Memory" ) );
-         return NULL;
-      }
-      memset( t, 0, size ); /* important, must be set to zero */
-
-      /* Check each pixel individually. */
-      for ( int i = 0; i < h; i++ )
-         for ( int j = 0; j < w;
-               j++ ) /* sets each bit to be 1 if not transparent or 0 if is */
-            t[( i * w + j ) / 8] |=
-               ( SDL_IsTrans( s, j, i ) ) ? 0 : ( 1 << ( ( i * w + j ) % 8 ) );
-   } else {
-      t = malloc( w * h );
-      /* Check each pixel individually. */
-      for ( int i = 0; i < h; i++ )
-         for ( int j = 0; j < w;
-               j++ ) /* sets each bit to be 1 if not transparent or 0 if is */
-            t[i * w + j] = SDL_GetAlpha(
-               s, j, i ); /* Flipped with tight version, this is not good :/ */
+   /* Check each pixel individually. */
+   for ( int i = 0; i < h; i++ ) {
+      uint64_t *row = &t[i * stride];
+      for ( int j = 0; j < w; j++ )
+         if ( !SDL_IsTrans( s, j, i ) )
+            row[j / 64] |= UINT64_C( 1 ) << ( j % 64 );
    }
 
    return t;
 }
 
-/*
+/**
+ * @brief Gets the number of words per row of a transparency map.
+ *
+ * There is always a trailing empty word, so reading 64 pixels starting at any
+ *  pixel of the row stays within the row.
+ *
+ *    @param w Width of the image.
+ *    @return The number of words per row.
+ */
+static int gl_transStride( const int w )
+{
+   return ( w + 63 ) / 64 + 1;
+}
+
+/**
  * @brief Gets the size needed for a transparency map.
  *
  *    @param w Width of the image.
@@ -210,8 +396,7 @@ static uint8_t *SDL_MapAlpha( SDL_Surface *s, int tight )
  */
 static size_t gl_transSize( const int w, const int h )
 {
-   /* One bit per pixel, plus remainder. */
-   return w * h / 8 + ( ( w * h % 8 ) ? 1 : 0 );
+   return (size_t)gl_transStride( w ) * h * sizeof( uint64_t );
 }
 
 /**
@@ -422,7 +607,7 @@ static GLuint gl_loadSurface( SDL_Surface *surface, unsigned int flags,
    SDL_LockSurface( rgba );
    if ( flags & OPENGL_TEX_SDF ) {
       const float border[] = { 0., 0., 0., 0. };
-      uint8_t    *trans    = SDL_MapAlpha( rgba, 0 );
+      uint8_t    *trans    = SDL_MapAlpha( rgba );
       GLfloat    *dataf = make_distance_mapbf( trans, rgba->w, rgba->h, vmax );
       free( trans );
       glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border );
@@ -524,17 +709,7 @@ USE_RESULT glTexture *gl_texExistsOrCreate( const char  *path,
    SDL_mutexP( tex_lock );
 
    /* Check to see if it already exists */
-   if ( texture_list == NULL ) {
-      glTexture *tex = gl_texCreate( buf, sx, sy, flags );
-      *created       = 1;
-      SDL_mutexV( tex_lock );
-      return tex;
-   }
-
-   /* Do some fancy binary search. */
-   const glTexList q = { .path = buf, .sx = sx, .sy = sy, .flags = flags };
-   glTexList      *t = bsearch( &q, texture_list, array_size( texture_list ),
-                                sizeof( glTexList ), tex_cmp );
+   glTexList *t = tex_find( buf, sx, sy, flags );
    if ( t == NULL ) {
       glTexture *tex = gl_texCreate( buf, sx, sy, flags );
       *created       = 1;
@@ -555,12 +730,14 @@ USE_RESULT glTexture *gl_texExistsOrCreate( const char  *path,
 static int gl_texAdd( glTexture *tex, int sx, int sy, unsigned int flags )
 {
    glTexList *new;
+   int        idx;
 
    /* Get the new list element. */
    if ( texture_list == NULL )
       texture_list = array_create( glTexList );
 
    /* Create the new node */
+   idx        = array_size( texture_list );
    new        = &array_grow( &texture_list );
    new->used  = 1;
    new->tex   = tex;
@@ -568,13 +745,46 @@ static int gl_texAdd( glTexture *tex, int sx, int sy, unsigned int flags )
    new->sy    = sy;
    new->flags = flags;
    new->path  = tex->name;
-
-   /* Sort the list. */
-   qsort( texture_list, array_size( texture_list ), sizeof( glTexList ),
-          tex_cmp );
+   new->hash  = ( new->path != NULL )
+                   ? tex_hashKey( new->path, sx, sy, flags )
+                   : 0;
+
+   /* Index it, keeping the tables at most half full. */
+   if ( 2 * array_size( texture_list ) > tex_hmask + 1 )
+      tex_hashRebuild( MAX( TEX_HASH_MIN, 2 * ( tex_hmask + 1 ) ) );
+   else {
+      if ( new->path != NULL )
+         tex_hashInsert( tex_hkey, idx, 0 );
+      tex_hashInsert( tex_hptr, idx, 1 );
+   }
    return 0;
 }
 
+/**
+ * @brief Removes a node from the texture list.
+ *
+ * The last node is moved into its place, so indices are not stable.
+ *
+ * @note Must hold tex_lock.
+ *
+ *    @param idx Index of the node to remove.
+ */
+static void gl_texRemove( int idx )
+{
+   int last = array_size( texture_list ) - 1;
+
+   if ( texture_list[idx].path != NULL )
+      tex_hashRemove( tex_hkey, idx, 0 );
+   tex_hashRemove( tex_hptr, idx, 1 );
+   if ( idx != last ) {
+      if ( texture_list[last].path != NULL )
+         tex_hkey[tex_hashSlot( tex_hkey, last, 0 )] = idx;
+      tex_hptr[tex_hashSlot( tex_hptr, last, 1 )] = idx;
+      texture_list[idx]                           = texture_list[last];
+   }
+   array_erase( &texture_list, &texture_list[last], array_end( texture_list ) );
+}
+
 /**
  * @brief Loads an image as a texture.
  *
@@ -691,12 +901,12 @@ static int gl_loadNewImageRWops( glTexture *tex, const char *path,
       md5_state_t md5;
       char       *data;
       char       *cachefile = NULL;
-      uint8_t    *trans     = NULL;
+      uint64_t   *trans     = NULL;
       md5_byte_t *md5val    = malloc( 16 );
       md5_init( &md5 );
       char digest[33];
 
-      /* Appropriate size for the transparency map, see SDL_MapAlpha */
+      /* Appropriate size for the transparency map, see SDL_MapTrans */
       cachesize = gl_transSize( surface->w, surface->h );
 
       /* Go to the start of the file. */
@@ -721,7 +931,7 @@ static int gl_loadNewImageRWops( glTexture *tex, const char *path,
 
       /* Attempt to find a cached transparency map. */
       if ( nfile_fileExists( cachefile ) ) {
-         trans = (uint8_t *)nfile_readFile( &filesize, cachefile );
+         trans = (uint64_t *)nfile_readFile( &filesize, cachefile );
 
          /* Consider cached data invalid if the length doesn't match. */
          if ( trans != NULL && cachesize != (unsigned int)filesize ) {
@@ -737,7 +947,7 @@ static int gl_loadNewImageRWops( glTexture *tex, const char *path,
 
       if ( trans == NULL ) {
          SDL_LockSurface( surface );
-         trans = SDL_MapAlpha( surface, 1 );
+         trans = SDL_MapTrans( surface );
          SDL_UnlockSurface( surface );
 
          if ( cachefile != NULL ) {
@@ -751,7 +961,8 @@ static int gl_loadNewImageRWops( glTexture *tex, const char *path,
          }
       }
 
-      tex->trans = trans;
+      tex->trans   = trans;
+      tex->tstride = gl_transStride( surface->w );
    }
 
    /* Load image if necessary. */
@@ -840,27 +1051,29 @@ void gl_freeTexture( glTexture *texture )
    SDL_mutexP( gl_lock );
 
    /* see if we can find it in stack */
-   for ( int i = 0; i < array_size( texture_list ); i++ ) {
+   SDL_mutexP( tex_lock );
+   int i = tex_findPtr( texture );
+   if ( i >= 0 ) {
       glTexList *cur = &texture_list[i];
 
-      if ( cur->tex != texture )
-         continue;
-
       /* found it */
       cur->used--;
       if ( cur->used <= 0 ) { /* not used anymore */
+         /* free the list node */
+         gl_texRemove( i );
+         SDL_mutexV( tex_lock );
+
          /* free the texture */
          glDeleteTextures( 1, &texture->texture );
          free( texture->trans );
          free( texture->name );
          free( texture );
-
-         /* free the list node */
-         array_erase( &texture_list, &texture_list[i], &texture_list[i + 1] );
-      }
+      } else
+         SDL_mutexV( tex_lock );
       SDL_mutexV( gl_lock );
       return; /* we already found it so we can exit */
    }
+   SDL_mutexV( tex_lock );
 
    /* Not found */
    if ( texture->name != NULL ) /* Surfaces will have NULL names */
@@ -895,16 +1108,15 @@ glTexture *gl_dupTexture( const glTexture *texture )
       return NULL;
 
    /* check to see if it already exists */
-   SDL_mutexP( gl_lock );
-   for ( int i = 0; i < array_size( texture_list ); i++ ) {
+   SDL_mutexP( tex_lock );
+   int i = tex_findPtr( texture );
+   if ( i >= 0 ) {
       glTexList *cur = &texture_list[i];
-      if ( texture == cur->tex ) {
-         cur->used++;
-         SDL_mutexV( gl_lock );
-         return cur->tex;
-      }
+      cur->used++;
+      SDL_mutexV( tex_lock );
+      return cur->tex;
    }
-   SDL_mutexV( gl_lock );
+   SDL_mutexV( tex_lock );
 
    /* Invalid texture. */
    WARN( _( "Unable to duplicate texture '%s'." ), texture->name );
@@ -946,22 +1158,6 @@ USE_RESULT glTexture *gl_rawTexture( const char *name, GLuint texid, double w,
    return texture;
 }
 
-/**
- * @brief Checks to see if a pixel is transparent in a texture.
- *
- *    @param t Texture to check for transparency.
- *    @param x X position of the pixel.
- *    @param y Y position of the pixel.
- *    @return 1 if the pixel is transparent or 0 if it isn't.
- */
-int gl_isTrans( const glTexture *t, const int x, const int y )
-{
-   /* Get the position in the sheet. */
-   int i = y * (int)( t->w ) + x;
-   /* Now we have to pull out the individual bit. */
-   return !( t->trans[i / 8] & ( 1 << ( i % 8 ) ) );
-}
-
 /**
  * @brief Sets x and y to be the appropriate sprite for glTexture using dir.
  *
@@ -1025,6 +1221,12 @@ void gl_exitTextures( void )
    SDL_DestroyMutex( tex_lock );
    SDL_DestroyMutex( gl_lock );
 
+   free( tex_hkey );
+   free( tex_hptr );
+   tex_hkey  = NULL;
+   tex_hptr  = NULL;
+   tex_hmask = 0;
+
    if ( array_size( texture_list ) <= 0 ) {
       array_free( texture_list );
       return;
@@ -56,9 +56,11 @@ typedef struct glTexture_ {
    double srh; /**< Sprite render height - equivalent to sh/h. */
 
    /* data */
-   GLuint   texture; /**< the opengl texture itself */
-   uint8_t *trans;   /**< maps the transparency */
-   double   vmax;    /**< Maximum value for SDF textures. */
+   GLuint    texture; /**< the opengl texture itself */
+   uint64_t *trans;   /**< maps the transparency, one bit per pixel with each
+                         row starting on a new word */
+   int       tstride; /**< Number of words per row of the transparency map. */
+   double    vmax;    /**< Maximum value for SDF textures. */
 
    /* properties */
    uint8_t flags; /**< flags used for texture properties */
@@ -107,7 +109,22 @@ int gl_fboAddDepth( GLuint fbo, GLuint *tex, GLsizei width, GLsizei height );
  */
 void        gl_contextSet( void );
 void        gl_contextUnset( void );
-int         gl_isTrans( const glTexture *t, const int x, const int y );
 void        gl_getSpriteFromDir( int *x, int *y, int sx, int sy, double dir );
 glTexture **gl_copyTexArray( glTexture **tex );
 glTexture **gl_addTexArray( glTexture **tex, glTexture *t );
+
+/**
+ * @brief Checks to see if a pixel is transparent in a texture.
+ *
+ * Inline as the collisions call it for every pixel they can't skip.
+ *
+ *    @param t Texture to check for transparency.
+ *    @param x X position of the pixel.
+ *    @param y Y position of the pixel.
+ *    @return 1 if the pixel is transparent or 0 if it isn't.
+ */
+static inline int gl_isTrans( const glTexture *t, const int x, const int y )
+{
+   /* Pull out the individual bit of the row. */
+   return !( ( t->trans[y * t->tstride + x / 64] >> ( x % 64 ) ) & 1 );
+}
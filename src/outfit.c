@@ -26,6 +26,7 @@
 #include "damagetype.h"
 #include "log.h"
 #include "mapData.h" // IWYU pragma: keep
+#include "nameindex.h"
 #include "ndata.h"
 #include "nlua.h"
 #include "nlua_camera.h"
@@ -65,6 +66,7 @@ typedef struct OutfitThreadData_ {
  */
 static Outfit *outfit_stack  = NULL; /**< Stack of outfits. */
 static char  **license_stack = NULL; /**< Stack of available licenses. */
+static NameIndex outfit_index; /**< Maps outfit names to stack positions. */
 
 /*
  * Helper stuff for setting up short descriptions for outfits.
@@ -237,9 +239,8 @@ const Outfit *outfit_get( const char *name )
  */
 const Outfit *outfit_getW( const char *name )
 {
-   const Outfit s = { .name = (char *)name };
-   return bsearch( &s, outfit_stack, array_size( outfit_stack ),
-                   sizeof( Outfit ), outfit_cmp );
+   int id = nameindex_get( &outfit_index, name );
+   return ( id < 0 ) ? NULL : &outfit_stack[id];
 }
 
 /**
@@ -2714,6 +2715,7 @@ static int outfit_parse( Outfit *temp, const char *file )
    temp->lua_init         = LUA_NOREF;
    temp->lua_cleanup      = LUA_NOREF;
    temp->lua_update       = LUA_NOREF;
+   temp->lua_update_batch = LUA_NOREF;
    temp->lua_ontoggle     = LUA_NOREF;
    temp->lua_onshoot      = LUA_NOREF;
    temp->lua_onhit        = LUA_NOREF;
@@ -3062,6 +3064,9 @@ int outfit_load( void )
    noutfits = array_size( outfit_stack );
    /* Sort up licenses. */
    qsort( outfit_stack, noutfits, sizeof( Outfit ), outfit_cmp );
+   nameindex_clear( &outfit_index );
+   for ( int i = 0; i < noutfits; i++ )
+      nameindex_add( &outfit_index, outfit_stack[i].name, i );
    if ( license_stack != NULL )
       qsort( license_stack, array_size( license_stack ), sizeof( char * ),
              strsort );
@@ -3116,6 +3121,8 @@ int outfit_load( void )
       o->lua_init        = nlua_refenvtype( env, "init", LUA_TFUNCTION );
       o->lua_cleanup     = nlua_refenvtype( env, "cleanup", LUA_TFUNCTION );
       o->lua_update      = nlua_refenvtype( env, "update", LUA_TFUNCTION );
+      o->lua_update_batch =
+         nlua_refenvtype( env, "update_batch", LUA_TFUNCTION );
       o->lua_ontoggle    = nlua_refenvtype( env, "ontoggle", LUA_TFUNCTION );
       o->lua_onshoot     = nlua_refenvtype( env, "onshoot", LUA_TFUNCTION );
       o->lua_onhit       = nlua_refenvtype( env, "onhit", LUA_TFUNCTION );
@@ -3429,6 +3436,7 @@ void outfit_free( void )
 
    array_free( outfit_stack );
    array_free( license_stack );
+   nameindex_free( &outfit_index );
 }
 
 /**
@@ -7,6 +7,7 @@
  * @brief Handles the pilot stuff.
  */
 /** @cond */
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
 
@@ -39,20 +40,79 @@
 #include "quadtree.h"
 #include "rng.h"
 #include "sound.h"
+#include "threadpool.h"
 
 #define PILOT_SIZE_MIN 128 /**< Minimum chunks to increment pilot_stack by */
+#define PILOT_UPDATE_GRAIN                                                     \
+   32 /**< Minimum amount of pilots updated per thread. */
+#define PILOT_NEAREST_RADIUS                                                   \
+   1024. /**< Initial radius of the nearest pilot searches. */
+
+#define PILOT_SLOT_BITS 14 /**< Bits of a pilot ID used for the slot. */
+#define PILOT_SLOT_MASK                                                        \
+   ( ( 1U << PILOT_SLOT_BITS ) - 1 ) /**< Mask of the slot in an ID. */
+#define PILOT_GEN_MAX                                                          \
+   ( UINT_MAX >> PILOT_SLOT_BITS ) /**< Maximum generation of a slot. */
+#define PILOT_SLOT_FIRST                                                       \
+   ( PLAYER_ID + 1 ) /**< First slot handed out, lower ones are reserved. */
 
 /* ID Generators. */
-static unsigned int pilot_id =
-   PLAYER_ID; /**< Stack of pilot ids to assure uniqueness */
+static Pilot **pilot_slots =
+   NULL; /**< Pilot owning each ID slot, NULL if free. Slot PLAYER_ID is
+            reserved for the player and slot 0 is never used. */
+static unsigned int *pilot_gen =
+   NULL; /**< Generation of each slot, incremented when reused. */
+static int *pilot_freelist =
+   NULL; /**< Slots that can be reused, oldest first so generations grow
+            slowly. */
+static int pilot_freehead = 0; /**< First unused entry of the free list. */
 
 /* stack of pilots */
 static Pilot **pilot_stack =
    NULL; /**< All the pilots in space. (Player may have other Pilot objects,
             e.g. backup ships.) */
-static Quadtree pilot_quadtree; /**< Quadtree for the pilots. */
-static IntList  pilot_qtquery;  /**< Quadtree query. */
-static int      qt_init = 0;
+static Quadtree pilot_quadtree;  /**< Quadtree for the pilots. */
+static IntList  pilot_qtquery;   /**< Quadtree query. */
+static IntList  pilot_qtnearest; /**< Quadtree query for nearest searches. */
+static IntList  pilot_qtwithin;  /**< Quadtree query for radius searches. */
+static int      qt_init   = 0;
+static int      qt_extent = 0; /**< Half size of the quadtree extents. */
+static int      qt_valid =
+   0; /**< Whether the quadtree matches pilot positions and stack indices. */
+static int qt_num =
+   0; /**< Pilots on the stack when the quadtree was built, newer ones are not
+         indexed. */
+static int *qt_extra =
+   NULL; /**< Indexed pilots that can't be found by querying the quadtree. */
+static int qt_moved =
+   0; /**< Whether the quadtree was valid before the pilots moved, in which
+         case it can still be used by growing queries by qt_slack. */
+static double qt_slack =
+   0.; /**< How far any indexed pilot moved since the quadtree was built. */
+static int qt_cur =
+   -1; /**< Indexed pilot being moved, not yet accounted for in qt_slack. */
+static vec2 *qt_pos =
+   NULL; /**< Positions of the indexed pilots when the quadtree was built. */
+static int *qt_always =
+   NULL; /**< Indexed pilots that may be visible at any distance. */
+static int *qt_cand = NULL; /**< Candidates of radius searches. */
+static PilotEWBound qt_ew; /**< Bounds of the pilot electronic warfare. */
+
+/**
+ * @brief Solid integration of a pilot done ahead of its update.
+ */
+typedef struct PilotSolidAhead_ {
+   const Pilot *p;    /**< Pilot it was done for, NULL if not done. */
+   const Ship  *ship; /**< Ship used to get the sprite. */
+   double       dt;   /**< Delta tick used. */
+   Solid        in;   /**< Solid before integrating. */
+   Solid        out;  /**< Solid after integrating. */
+   int          tsx;  /**< Resulting sprite x position. */
+   int          tsy;  /**< Resulting sprite y position. */
+} PilotSolidAhead;
+static PilotSolidAhead *solid_ahead =
+   NULL; /**< Solids integrated ahead of time, by stack position (array.h). */
+static int solid_cur = -1; /**< Stack position of the pilot being updated. */
 /* A simple grid search procedure was used to determine the following
  * parameters. */
 static int qt_max_elem = 2;
@@ -76,15 +136,31 @@ static void pilot_init( Pilot *dest, const Ship *ship, const char *name,
 static void pilot_hyperspace( Pilot *pilot, double dt );
 static void pilot_refuel( Pilot *p, double dt );
 static void pilot_updateSolid( Pilot *p, double dt );
+static void pilots_updateSolidRange( int start, int end, void *data );
 /* Clean up. */
-static void pilot_erase( Pilot *p );
+static void pilot_erase( int i );
 /* Misc. */
 static void pilot_renderFramebufferBase( Pilot *p, GLuint fbo, double fw,
                                          double fh, const Lighting *L );
 static int  pilot_getStackPos( unsigned int id );
+static unsigned int pilot_newID( Pilot *p );
+static void         pilot_freeID( const Pilot *p );
+static Pilot       *pilot_getSlot( unsigned int id );
+static void         pilot_stackFront( const Pilot *p );
+static void         pilot_stackRenumber( int start );
 static void pilot_init_trails( Pilot *p );
 static int  pilot_trail_generated( Pilot *p, int generator );
 static void pilot_addQuadtree( const Pilot *p, int i );
+/* Nearest searches. */
+typedef int ( *PilotNearestFunc )( const Pilot *p, const Pilot *target,
+                                   double x, double y, const void *data,
+                                   double *score );
+static Pilot *pilot_getNearestFunc( const Pilot *p, double x, double y,
+                                    double weight, PilotNearestFunc func,
+                                    const void *data, double *score );
+/* Radius searches. */
+static int  pilot_isVisibleAnywhere( const Pilot *p );
+static void pilot_quadtreeMoved( int i );
 
 /**
  * @brief Gets the pilot stack.
@@ -95,14 +171,77 @@ Pilot *const *pilot_getAll( void )
 }
 
 /**
- * @brief Compare id (for use with bsearch)
+ * @brief Allocates a new unique ID for a pilot.
+ *
+ * IDs are made of a slot in the lookup table and the generation of the slot,
+ * so looking them up is O(1) and IDs of pilots that are gone don't resolve to
+ * the new owner of the slot.
+ *
+ *    @param p Pilot to allocate the ID for.
+ *    @return The new ID, or 0 if out of slots.
  */
-static int pilot_cmp( const void *ptr1, const void *ptr2 )
+static unsigned int pilot_newID( Pilot *p )
 {
-   const Pilot *p1, *p2;
-   p1 = *( (const Pilot **)ptr1 );
-   p2 = *( (const Pilot **)ptr2 );
-   return p1->id - p2->id;
+   int slot;
+
+   if ( pilot_freehead < array_size( pilot_freelist ) ) {
+      slot = pilot_freelist[pilot_freehead++];
+      /* Drop the consumed part once it dominates the list. */
+      if ( pilot_freehead * 2 >= array_size( pilot_freelist ) ) {
+         array_erase( &pilot_freelist, array_begin( pilot_freelist ),
+                      &pilot_freelist[pilot_freehead] );
+         pilot_freehead = 0;
+      }
+   } else {
+      slot = array_size( pilot_slots );
+      if ( (unsigned int)slot > PILOT_SLOT_MASK ) {
+         WARN( _( "Too many pilots, unable to allocate more IDs!" ) );
+         return 0;
+      }
+      array_push_back( &pilot_slots, NULL );
+      array_push_back( &pilot_gen, 0 );
+   }
+
+   /* Generation 0 is skipped so IDs never collide with the reserved ones. */
+   pilot_gen[slot]   = pilot_gen[slot] % PILOT_GEN_MAX + 1;
+   pilot_slots[slot] = p;
+   return ( pilot_gen[slot] << PILOT_SLOT_BITS ) | slot;
+}
+
+/**
+ * @brief Releases the ID of a pilot so the slot can be reused.
+ *
+ * Does nothing if the pilot no longer owns the ID, e.g. a replaced player.
+ *
+ *    @param p Pilot to release the ID of.
+ */
+static void pilot_freeID( const Pilot *p )
+{
+   unsigned int slot = p->id & PILOT_SLOT_MASK;
+
+   if ( ( p->id == 0 ) || ( pilot_getSlot( p->id ) != p ) )
+      return;
+   pilot_slots[slot] = NULL;
+   if ( slot >= PILOT_SLOT_FIRST )
+      array_push_back( &pilot_freelist, slot );
+}
+
+/**
+ * @brief Gets the pilot owning an ID, including ones being deleted.
+ *
+ *    @param id ID to look up.
+ *    @return The pilot owning the ID or NULL if stale or not found.
+ */
+static Pilot *pilot_getSlot( unsigned int id )
+{
+   unsigned int slot = id & PILOT_SLOT_MASK;
+   unsigned int gen  = id >> PILOT_SLOT_BITS;
+
+   if ( slot >= (unsigned int)array_size( pilot_slots ) )
+      return NULL;
+   if ( gen != pilot_gen[slot] )
+      return NULL;
+   return pilot_slots[slot];
 }
 
 /**
@@ -113,15 +252,47 @@ static int pilot_cmp( const void *ptr1, const void *ptr2 )
  */
 static int pilot_getStackPos( unsigned int id )
 {
-   const Pilot  pid    = { .id = id };
-   const Pilot *pidptr = &pid;
-   /* binary search */
-   Pilot **pp = bsearch( &pidptr, pilot_stack, array_size( pilot_stack ),
-                         sizeof( Pilot * ), pilot_cmp );
-   if ( pp == NULL )
+   const Pilot *p = pilot_getSlot( id );
+   if ( p == NULL )
       return -1;
-   else
-      return pp - pilot_stack;
+   /* Pilots taken off the stack keep their old position. */
+   if ( ( p->stackpos < 0 ) || ( p->stackpos >= array_size( pilot_stack ) ) ||
+        ( pilot_stack[p->stackpos] != p ) )
+      return -1;
+   return p->stackpos;
+}
+
+/**
+ * @brief Updates the stack positions of the pilots after the stack changed.
+ *
+ *    @param start First position that changed.
+ */
+static void pilot_stackRenumber( int start )
+{
+   for ( int i = start; i < array_size( pilot_stack ); i++ )
+      pilot_stack[i]->stackpos = i;
+}
+
+/**
+ * @brief Moves a pilot to the start of the stack, keeping the order of the
+ * rest.
+ *
+ *    @param p Pilot to move.
+ */
+static void pilot_stackFront( const Pilot *p )
+{
+   for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
+      if ( pilot_stack[i] != p )
+         continue;
+      if ( i > 0 ) {
+         Pilot *tmp = pilot_stack[i];
+         memmove( &pilot_stack[1], &pilot_stack[0], i * sizeof( Pilot * ) );
+         pilot_stack[0] = tmp;
+         pilot_stackRenumber( 0 );
+         pilot_quadtreeInvalidate(); /* Stack positions changed. */
+      }
+      return;
+   }
 }
 
 /**
@@ -322,30 +493,148 @@ int pilot_validEnemy( const Pilot *p, const Pilot *target )
 }
 
 /**
- * @brief Gets the nearest enemy to the pilot.
+ * @brief Checks a candidate of a nearest pilot search.
  *
- *    @param p Pilot to get the nearest enemy of.
- *    @return ID of their nearest enemy.
+ *    @param p Pilot doing the search.
+ *    @param i Stack position of the candidate.
+ *    @param x X position to search from.
+ *    @param y Y position to search from.
+ *    @param func Scoring function.
+ *    @param data Data to pass to the scoring function.
+ *    @param[in,out] best Stack position of the best candidate or -1.
+ *    @param[in,out] bestscore Score of the best candidate.
  */
-unsigned int pilot_getNearestEnemy( const Pilot *p )
+static void pilot_getNearestCandidate( const Pilot *p, int i, double x,
+                                       double y, PilotNearestFunc func,
+                                       const void *data, int *best,
+                                       double *bestscore )
 {
-   unsigned int tp = 0;
-   double       d  = 0.;
+   double score;
+   if ( !func( p, pilot_stack[i], x, y, data, &score ) )
+      return;
+   /* Ties go to the lowest stack position, like a linear search would. */
+   if ( ( *best < 0 ) || ( score < *bestscore ) ||
+        ( ( score == *bestscore ) && ( i < *best ) ) ) {
+      *best      = i;
+      *bestscore = score;
+   }
+}
 
-   for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
-      double td;
+/**
+ * @brief Finds the pilot with the lowest score around a position.
+ *
+ * When the quadtree is up to date, it is searched with expanding squares
+ * around the position until no unseen pilot can beat the best one found so
+ * far. This requires that scores are never lower than weight times the
+ * squared distance to the position. Otherwise, or if weight is not positive,
+ * all the pilots are checked. Either way, the result is the same.
+ *
+ *    @param p Pilot doing the search.
+ *    @param x X position to search from.
+ *    @param y Y position to search from.
+ *    @param weight Lower bound of the score per squared distance.
+ *    @param func Scoring function, returns 0 if the target is not valid.
+ *    @param data Data to pass to the scoring function.
+ *    @param[out] score Score of the pilot found.
+ *    @return The pilot with the lowest score or NULL if none is valid.
+ */
+static Pilot *pilot_getNearestFunc( const Pilot *p, double x, double y,
+                                    double weight, PilotNearestFunc func,
+                                    const void *data, double *score )
+{
+   int    best      = -1;
+   double bestscore = 0.;
+   double r         = PILOT_NEAREST_RADIUS;
+
+   if ( !qt_valid || ( weight <= 0. ) ) {
+      for ( int i = 0; i < array_size( pilot_stack ); i++ )
+         pilot_getNearestCandidate( p, i, x, y, func, data, &best,
+                                    &bestscore );
+   } else {
+      /* Pilots missing from the quadtree always have to be checked. */
+      for ( int i = qt_num; i < array_size( pilot_stack ); i++ )
+         pilot_getNearestCandidate( p, i, x, y, func, data, &best,
+                                    &bestscore );
+      for ( int i = 0; i < array_size( qt_extra ); i++ )
+         pilot_getNearestCandidate( p, qt_extra[i], x, y, func, data, &best,
+                                    &bestscore );
+
+      while ( 1 ) {
+         /* Pad by one unit as the quadtree uses rounded positions. */
+         int x1 = floor( MAX( x - r, -qt_extent - 1. ) ) - 1;
+         int y1 = floor( MAX( y - r, -qt_extent - 1. ) ) - 1;
+         int x2 = ceil( MIN( x + r, qt_extent + 1. ) ) + 1;
+         int y2 = ceil( MIN( y + r, qt_extent + 1. ) ) + 1;
+         qt_query( &pilot_quadtree, &pilot_qtnearest, x1, y1, x2, y2 );
+         for ( int i = 0; i < il_size( &pilot_qtnearest ); i++ )
+            pilot_getNearestCandidate( p, il_get( &pilot_qtnearest, i, 0 ), x,
+                                       y, func, data, &best, &bestscore );
+
+         /* Every pilot closer than r has been seen. */
+         if ( ( best >= 0 ) && ( bestscore <= weight * pow2( r ) ) )
+            break;
 
-      if ( !pilot_validEnemy( p, pilot_stack[i] ) )
-         continue;
+         /* Whole quadtree has been seen. */
+         if ( ( x1 <= -qt_extent ) && ( y1 <= -qt_extent ) &&
+              ( x2 >= qt_extent ) && ( y2 >= qt_extent ) )
+            break;
 
-      /* Check distance. */
-      td = vec2_dist2( &pilot_stack[i]->solid.pos, &p->solid.pos );
-      if ( !tp || ( td < d ) ) {
-         d  = td;
-         tp = pilot_stack[i]->id;
+         r *= 2.;
       }
    }
-   return tp;
+
+   if ( best < 0 )
+      return NULL;
+   *score = bestscore;
+   return pilot_stack[best];
+}
+
+/**
+ * @brief Scores enemies by distance for pilot_getNearestEnemy().
+ */
+static int pilot_nearestEnemy( const Pilot *p, const Pilot *target, double x,
+                               double y, const void *data, double *score )
+{
+   (void)x;
+   (void)y;
+   (void)data;
+   if ( !pilot_validEnemy( p, target ) )
+      return 0;
+   *score = vec2_dist2( &target->solid.pos, &p->solid.pos );
+   return 1;
+}
+
+/**
+ * @brief Gets the nearest enemy to the pilot.
+ *
+ *    @param p Pilot to get the nearest enemy of.
+ *    @return ID of their nearest enemy.
+ */
+unsigned int pilot_getNearestEnemy( const Pilot *p )
+{
+   double       d;
+   const Pilot *tp = pilot_getNearestFunc( p, p->solid.pos.x, p->solid.pos.y,
+                                           1., pilot_nearestEnemy, NULL, &d );
+   return ( tp == NULL ) ? 0 : tp->id;
+}
+
+/**
+ * @brief Scores enemies within a mass range by distance for
+ * pilot_getNearestEnemy_size().
+ */
+static int pilot_nearestEnemySize( const Pilot *p, const Pilot *target,
+                                   double x, double y, const void *data,
+                                   double *score )
+{
+   const double *mass = data;
+   (void)x;
+   (void)y;
+   if ( !pilot_validEnemy( p, target ) )
+      return 0;
+   if ( target->solid.mass < mass[0] || target->solid.mass > mass[1] )
+      return 0;
+   *score = vec2_dist2( &target->solid.pos, &p->solid.pos );
+   return 1;
 }
 
 /**
@@ -360,28 +649,31 @@ unsigned int pilot_getNearestEnemy( const Pilot *p )
 unsigned int pilot_getNearestEnemy_size( const Pilot *p, double target_mass_LB,
                                          double target_mass_UB )
 {
-   unsigned int tp = 0;
-   double       d  = 0.;
-
-   for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
-      double td;
-
-      if ( !pilot_validEnemy( p, pilot_stack[i] ) )
-         continue;
-
-      if ( pilot_stack[i]->solid.mass < target_mass_LB ||
-           pilot_stack[i]->solid.mass > target_mass_UB )
-         continue;
-
-      /* Check distance. */
-      td = vec2_dist2( &pilot_stack[i]->solid.pos, &p->solid.pos );
-      if ( !tp || ( td < d ) ) {
-         d  = td;
-         tp = pilot_stack[i]->id;
-      }
-   }
+   double       d;
+   const double mass[2] = { target_mass_LB, target_mass_UB };
+   const Pilot *tp =
+      pilot_getNearestFunc( p, p->solid.pos.x, p->solid.pos.y, 1.,
+                            pilot_nearestEnemySize, mass, &d );
+   return ( tp == NULL ) ? 0 : tp->id;
+}
 
-   return tp;
+/**
+ * @brief Scores enemies for pilot_getNearestEnemy_heuristic().
+ */
+static int pilot_nearestEnemyHeuristic( const Pilot *p, const Pilot *target,
+                                        double x, double y, const void *data,
+                                        double *score )
+{
+   const double *f = data;
+   (void)x;
+   (void)y;
+   if ( !pilot_validEnemy( p, target ) )
+      return 0;
+   *score = f[3] * vec2_dist2( &target->solid.pos, &p->solid.pos ) +
+            FABS( pilot_relsize( p, target ) - f[0] ) +
+            FABS( pilot_relhp( p, target ) - f[1] ) +
+            FABS( pilot_reldps( p, target ) - f[2] );
+   return 1;
 }
 
 /**
@@ -402,29 +694,14 @@ unsigned int pilot_getNearestEnemy_heuristic( const Pilot *p,
                                               double       damage_factor,
                                               double       range_factor )
 {
-   unsigned int tp                      = 0;
-   double       current_heuristic_value = 10e3;
-
-   for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
-      double temp;
-      Pilot *target = pilot_stack[i];
-
-      if ( !pilot_validEnemy( p, target ) )
-         continue;
-
-      /* Check distance. */
-      temp = range_factor * vec2_dist2( &target->solid.pos, &p->solid.pos ) +
-             FABS( pilot_relsize( p, target ) - mass_factor ) +
-             FABS( pilot_relhp( p, target ) - health_factor ) +
-             FABS( pilot_reldps( p, target ) - damage_factor );
-
-      if ( ( tp == 0 ) || ( temp < current_heuristic_value ) ) {
-         current_heuristic_value = temp;
-         tp                      = target->id;
-      }
-   }
-
-   return tp;
+   double       h;
+   const double f[4] = { mass_factor, health_factor, damage_factor,
+                         range_factor };
+   /* The other terms are never negative, so the range term bounds the score. */
+   const Pilot *tp =
+      pilot_getNearestFunc( p, p->solid.pos.x, p->solid.pos.y, range_factor,
+                            pilot_nearestEnemyHeuristic, f, &h );
+   return ( tp == NULL ) ? 0 : tp->id;
 }
 
 /**
@@ -504,6 +781,34 @@ unsigned int pilot_getBoss( const Pilot *p )
    return t;
 }
 
+/**
+ * @brief Scores pilots by distance for pilot_getNearestPosPilot().
+ */
+static int pilot_nearestPos( const Pilot *p, const Pilot *target, double x,
+                             double y, const void *data, double *score )
+{
+   int disabled = *(const int *)data;
+
+   /* Must not be self. */
+   if ( target == p )
+      return 0;
+
+   /* Player doesn't select escorts (unless disabled is active). */
+   if ( !disabled && pilot_isPlayer( p ) && pilot_isWithPlayer( target ) )
+      return 0;
+
+   /* Shouldn't be disabled. */
+   if ( !disabled && pilot_isDisabled( target ) )
+      return 0;
+
+   /* Must be a valid target. */
+   if ( !pilot_validTarget( p, target ) )
+      return 0;
+
+   *score = pow2( x - target->solid.pos.x ) + pow2( y - target->solid.pos.y );
+   return 1;
+}
+
 /**
  * @brief Get the nearest pilot to a pilot from a certain position.
  *
@@ -518,35 +823,7 @@ double pilot_getNearestPosPilot( const Pilot *p, Pilot **tp, double x, double y,
                                  int disabled )
 {
    double d = 0.;
-   *tp      = NULL;
-   for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
-      double td;
-
-      /* Must not be self. */
-      if ( pilot_stack[i] == p )
-         continue;
-
-      /* Player doesn't select escorts (unless disabled is active). */
-      if ( !disabled && pilot_isPlayer( p ) &&
-           pilot_isWithPlayer( pilot_stack[i] ) )
-         continue;
-
-      /* Shouldn't be disabled. */
-      if ( !disabled && pilot_isDisabled( pilot_stack[i] ) )
-         continue;
-
-      /* Must be a valid target. */
-      if ( !pilot_validTarget( p, pilot_stack[i] ) )
-         continue;
-
-      /* Minimum distance. */
-      td = pow2( x - pilot_stack[i]->solid.pos.x ) +
-           pow2( y - pilot_stack[i]->solid.pos.y );
-      if ( ( ( *tp == NULL ) || ( td < d ) ) ) {
-         d   = td;
-         *tp = pilot_stack[i];
-      }
-   }
+   *tp = pilot_getNearestFunc( p, x, y, 1., pilot_nearestPos, &disabled, &d );
    return d;
 }
 
@@ -629,23 +906,19 @@ double pilot_getNearestAng( const Pilot *p, unsigned int *tp, double ang,
 /**
  * @brief Pulls a pilot out of the pilot_stack based on ID.
  *
- * It's a binary search ( O(logn) ) therefore it's pretty fast and can be
- *  abused all the time. Maximum iterations is 32 on a platform with 32 bit
- *  unsigned ints.
+ * It's a direct lookup in the ID table ( O(1) ) so it can be abused all the
+ *  time. IDs of pilots that are gone resolve to NULL even if their slot has
+ *  been reused.
  *
  *    @param id ID of the pilot to get.
  *    @return The actual pilot who has matching ID or NULL if not found.
  */
 Pilot *pilot_get( unsigned int id )
 {
-   const Pilot  pid    = { .id = id };
-   const Pilot *pidptr = &pid;
-   /* binary search */
-   Pilot **pp = bsearch( &pidptr, pilot_stack, array_size( pilot_stack ),
-                         sizeof( Pilot * ), pilot_cmp );
-   if ( ( pp == NULL ) || ( pilot_isFlag( *pp, PILOT_DELETE ) ) )
+   Pilot *p = pilot_getSlot( id );
+   if ( ( p == NULL ) || ( pilot_isFlag( p, PILOT_DELETE ) ) )
       return NULL;
-   return *pp;
+   return p;
 }
 
 /**
@@ -812,6 +1085,168 @@ void pilot_collideQueryIL( IntList *il, int x1, int y1, int x2, int y2 )
    qt_query( &pilot_quadtree, il, x1, y1, x2, y2 );
 }
 
+/**
+ * @brief Checks to see if a pilot may be visible at any distance.
+ *
+ * Mirrors the distance independent checks of pilot_inRangePilot().
+ */
+static int pilot_isVisibleAnywhere( const Pilot *p )
+{
+   return pilot_isFlag( p, PILOT_VISPLAYER ) ||
+          pilot_isFlag( p, PILOT_VISIBLE ) || ( p->parent != 0 );
+}
+
+/**
+ * @brief Compares stack positions for qsort.
+ */
+static int pilot_cmpStackPos( const void *a, const void *b )
+{
+   return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * @brief Adds a candidate to the output of pilot_getWithin().
+ */
+static void pilot_getWithinCandidate( Pilot ***out, Pilot *t, const vec2 *pos,
+                                      double r2, int always,
+                                      PilotFilterFunc filter, const void *data )
+{
+   if ( ( vec2_dist2( &t->solid.pos, pos ) > r2 ) &&
+        !( always && pilot_isVisibleAnywhere( t ) ) )
+      return;
+   if ( ( filter != NULL ) && !filter( t, data ) )
+      return;
+   array_push_back( out, t );
+}
+
+/**
+ * @brief Gets all the pilots within a radius of a position.
+ *
+ * Uses the quadtree when possible, even while pilots are moving by growing
+ * the query by how far they have moved since it was built. The result is
+ * always the same as checking all the pilots, including the order, which is
+ * the stack order.
+ *
+ *    @param[in,out] out Array (array.h) to fill, created if NULL.
+ *    @param pos Position to search around.
+ *    @param r Radius to search in.
+ *    @param always Whether or not to also get pilots that may be visible at
+ *           any distance, see pilot_inRangePilot().
+ *    @param filter Function returning 1 for pilots to keep, or NULL.
+ *    @param data Data to pass to the filter.
+ *    @return Number of pilots found.
+ */
+int pilot_getWithin( Pilot ***out, const vec2 *pos, double r, int always,
+                     PilotFilterFunc filter, const void *data )
+{
+   double r2 = pow2( MAX( r, 0. ) );
+
+   if ( *out == NULL )
+      *out = array_create( Pilot * );
+   else
+      array_erase( out, array_begin( *out ), array_end( *out ) );
+
+   if ( qt_valid || qt_moved ) {
+      /* Pad by one unit as the quadtree uses rounded positions. */
+      double R  = MAX( r, 0. ) + ( qt_valid ? 0. : qt_slack );
+      int    x1 = floor( MAX( pos->x - R, -qt_extent - 1. ) ) - 1;
+      int    y1 = floor( MAX( pos->y - R, -qt_extent - 1. ) ) - 1;
+      int    x2 = ceil( MIN( pos->x + R, qt_extent + 1. ) ) + 1;
+      int    y2 = ceil( MIN( pos->y + R, qt_extent + 1. ) ) + 1;
+
+      /* Not worth it if the whole quadtree is covered. */
+      if ( ( x1 > -qt_extent ) || ( y1 > -qt_extent ) ||
+           ( x2 < qt_extent ) || ( y2 < qt_extent ) ) {
+         array_erase( &qt_cand, array_begin( qt_cand ), array_end( qt_cand ) );
+         qt_query( &pilot_quadtree, &pilot_qtwithin, x1, y1, x2, y2 );
+         for ( int i = 0; i < il_size( &pilot_qtwithin ); i++ )
+            array_push_back( &qt_cand, il_get( &pilot_qtwithin, i, 0 ) );
+
+         /* Indexed pilots the query can miss. */
+         for ( int i = 0; i < array_size( qt_extra ); i++ )
+            array_push_back( &qt_cand, qt_extra[i] );
+         if ( always )
+            for ( int i = 0; i < array_size( qt_always ); i++ )
+               array_push_back( &qt_cand, qt_always[i] );
+         if ( ( qt_cur >= 0 ) && ( qt_cur < qt_num ) )
+            array_push_back( &qt_cand, qt_cur );
+
+         /* Keep the stack order. */
+         qsort( qt_cand, array_size( qt_cand ), sizeof( int ),
+                pilot_cmpStackPos );
+         for ( int i = 0; i < array_size( qt_cand ); i++ ) {
+            if ( ( i > 0 ) && ( qt_cand[i] == qt_cand[i - 1] ) )
+               continue;
+            pilot_getWithinCandidate( out, pilot_stack[qt_cand[i]], pos, r2,
+                                      always, filter, data );
+         }
+
+         /* Pilots missing from the quadtree always have to be checked. */
+         for ( int i = qt_num; i < array_size( pilot_stack ); i++ )
+            pilot_getWithinCandidate( out, pilot_stack[i], pos, r2, always,
+                                      filter, data );
+         return array_size( *out );
+      }
+   }
+
+   for ( int i = 0; i < array_size( pilot_stack ); i++ )
+      pilot_getWithinCandidate( out, pilot_stack[i], pos, r2, always, filter,
+                                data );
+   return array_size( *out );
+}
+
+/**
+ * @brief Marks a pilot as possibly visible at any distance for
+ * pilot_getWithin().
+ *
+ * Has to be called whenever PILOT_VISIBLE, PILOT_VISPLAYER or the parent of a
+ * pilot already in space is set.
+ *
+ *    @param p Pilot that may now be visible at any distance.
+ */
+void pilot_quadtreeAlways( const Pilot *p )
+{
+   int i = pilot_getStackPos( p->id );
+   if ( ( i >= 0 ) && ( i < qt_num ) )
+      array_push_back( &qt_always, i );
+}
+
+/**
+ * @brief Accounts for a pilot having moved since the quadtree was built.
+ *
+ *    @param i Stack position of the pilot.
+ */
+static void pilot_quadtreeMoved( int i )
+{
+   if ( !qt_moved || ( i >= qt_num ) )
+      return;
+   qt_slack =
+      MAX( qt_slack, vec2_dist( &pilot_stack[i]->solid.pos, &qt_pos[i] ) );
+}
+
+/**
+ * @brief Gets the upper bounds of the electronic warfare of the pilots.
+ *
+ * Useful to get the radius to pass to pilot_getWithin() for detection
+ * checks.
+ */
+const PilotEWBound *pilot_ewBound( void )
+{
+   return &qt_ew;
+}
+
+/**
+ * @brief Grows the electronic warfare bounds to include a pilot.
+ *
+ *    @param p Pilot whose electronic warfare changed.
+ */
+void pilot_ewBoundUpdate( const Pilot *p )
+{
+   qt_ew.detect    = MAX( qt_ew.detect, FABS( p->stats.ew_detect ) );
+   qt_ew.signature = MAX( qt_ew.signature, FABS( p->ew_signature ) );
+   qt_ew.detection = MAX( qt_ew.detection, FABS( p->ew_detection ) );
+}
+
 /**
  * @brief Tries to turn the pilot to face dir.
  *
@@ -3157,9 +3592,24 @@ int pilot_refuelStart( Pilot *p )
 
 /**
  * @brief Updates the pilot solid.
+ *
+ * Uses the integration done ahead of time by pilots_update if the solid is
+ * exactly as it was then, which gives the same result as doing it here.
  */
 static void pilot_updateSolid( Pilot *p, double dt )
 {
+   if ( ( solid_cur >= 0 ) && ( solid_cur < array_size( solid_ahead ) ) ) {
+      PilotSolidAhead *sa = &solid_ahead[solid_cur];
+      if ( ( sa->p == p ) && ( sa->ship == p->ship ) && ( sa->dt == dt ) &&
+           ( memcmp( &sa->in, &p->solid, sizeof( Solid ) ) == 0 ) ) {
+         memcpy( &p->solid, &sa->out, sizeof( Solid ) );
+         p->tsx = sa->tsx;
+         p->tsy = sa->tsy;
+         sa->p  = NULL;
+         return;
+      }
+   }
+
    p->solid.update( &p->solid, dt );
    /* TODO remove this from below when moving more towards 3D ships. */
    gl_getSpriteFromDir( &p->tsx, &p->tsy, p->ship->sx, p->ship->sy,
@@ -3514,7 +3964,7 @@ static void pilot_init_trails( Pilot *p )
  *
  * See pilot_init for parameters.
  *
- *    @return Pilot's id.
+ *    @return The new pilot or NULL on failure.
  *
  * @sa pilot_init
  */
@@ -3530,26 +3980,34 @@ Pilot *pilot_create( const Ship *ship, const char *name, int faction,
       return 0;
    }
 
+   memset( p, 0, sizeof( Pilot ) );
+
+   /* Set the ID, has to be set before pilot_init as escort stuff may do
+    * pilot_get in pilot_init. */
+   if ( !pilot_isFlagRaw( flags, PILOT_PLAYER ) ) {
+      p->id = pilot_newID( p ); /* new unique pilot id, can't be 0 */
+      if ( p->id == 0 ) {
+         nfree( p );
+         return NULL;
+      }
+   }
+
    NTracingZone( _ctx, 1 );
 
    /* Set the pilot in the stack -- must be there before initializing */
+   p->stackpos = array_size( pilot_stack );
    array_push_back( &pilot_stack, p );
-   memset( p, 0, sizeof( Pilot ) );
 
    /* Load ship graphics. */
    ship_gfxLoad( (Ship *)ship ); /* TODO no casting. */
 
-   /* Set the ID, has to be set before pilot_init as escort stuff may do
-    * pilot_get in pilot_init. */
    if ( pilot_isFlagRaw(
            flags, PILOT_PLAYER ) ) { /* Set player ID. TODO should probably be
                                         fixed to something better someday. */
-      p->id = PLAYER_ID;
-      qsort( pilot_stack, array_size( pilot_stack ), sizeof( Pilot * ),
-             pilot_cmp );
-   } else
-      p->id =
-         ++pilot_id; /* new unique pilot id based on pilot_id, can't be 0 */
+      p->id                  = PLAYER_ID;
+      pilot_slots[PLAYER_ID] = p;
+      pilot_stackFront( p );
+   }
 
    /* Initialize the pilot. */
    pilot_init( p, ship, name, faction, dir, pos, vel, flags, dockpilot,
@@ -3605,7 +4063,7 @@ Pilot *pilot_createEmpty( const Ship *ship, const char *name, int faction,
  * @brief Clones an existing pilot.
  *
  *    @param ref Reference pilot to be cloned.
- *    @return ID of the newly created clone.
+ *    @return ID of the newly created clone or 0 on failure.
  */
 unsigned int pilot_clone( const Pilot *ref )
 {
@@ -3621,12 +4079,17 @@ unsigned int pilot_clone( const Pilot *ref )
       WARN( _( "Unable to allocate memory" ) );
       return 0;
    }
+   memset( dyn, 0, sizeof( Pilot ) );
+   dyn->id = pilot_newID( dyn ); /* new unique pilot id. */
+   if ( dyn->id == 0 ) {
+      nfree( dyn );
+      return 0;
+   }
 
    /* Set the pilot in the stack -- must be there before initializing */
-   p  = &array_grow( &pilot_stack );
-   *p = dyn;
-   memset( dyn, 0, sizeof( Pilot ) );
-   dyn->id = ++pilot_id; /* new unique pilot id. */
+   dyn->stackpos = array_size( pilot_stack );
+   p             = &array_grow( &pilot_stack );
+   *p            = dyn;
 
    /* Initialize the pilot. */
    pilot_init( dyn, ref->ship, ref->name, ref->faction, ref->solid.dir,
@@ -3650,12 +4113,18 @@ unsigned int pilot_clone( const Pilot *ref )
 
 /**
  * @brief Adds a pilot to the stack.
+ *
+ *    @param p Pilot to add.
+ *    @return ID of the pilot or 0 if it couldn't be added.
  */
 unsigned int pilot_addStack( Pilot *p )
 {
-   p->id = ++pilot_id; /* new unique pilot id based on pilot_id, can't be 0 */
+   p->id = pilot_newID( p ); /* new unique pilot id, can't be 0 */
+   if ( p->id == 0 )
+      return 0;
    pilot_setFlag( p, PILOT_NOFREE );
 
+   p->stackpos = array_size( pilot_stack );
    array_push_back( &pilot_stack, p );
 
    /* Load ship graphics. */
@@ -3701,19 +4170,28 @@ Pilot *pilot_setPlayer( Pilot *after )
    int i = pilot_getStackPos( PLAYER_ID );
    int l = pilot_getStackPos( after->id );
 
-   if ( i < 0 ) {  /* No existing player ID. */
-      if ( l < 0 ) /* No existing pilot, have to create. */
+   if ( i < 0 ) { /* No existing player ID. */
+      if ( l < 0 ) { /* No existing pilot, have to create. */
+         after->stackpos = array_size( pilot_stack );
          array_push_back( &pilot_stack, after );
+      }
    } else { /* Player pilot already exists. */
       if ( l >= 0 )
          pilot_delete( pilot_stack[i] ); /* Both player and after are on stack.
                                             Remove player. */
-      else
-         pilot_stack[i] = after; /* after overwrites player. */
+      else {
+         pilot_stack[i]  = after; /* after overwrites player. */
+         after->stackpos = i;
+      }
    }
-   after->id = PLAYER_ID;
-   qsort( pilot_stack, array_size( pilot_stack ), sizeof( Pilot * ),
-          pilot_cmp );
+   /* after takes over the player slot, the old player keeps PLAYER_ID until
+    * purged but no longer resolves. */
+   pilot_freeID( after );
+   after->id              = PLAYER_ID;
+   pilot_slots[PLAYER_ID] = after;
+   pilot_stackFront( after );
+   pilot_quadtreeInvalidate(); /* Stack positions changed. */
+   pilot_ewBoundUpdate( after ); /* May not have been in space. */
 
    /* Load graphics if necessary. */
    ship_gfxLoad( (Ship *)after->ship );
@@ -3868,6 +4346,9 @@ void pilot_free( Pilot *p )
 {
    NTracingZone( _ctx, 1 );
 
+   /* Release the ID so stale references stop resolving to it. */
+   pilot_freeID( p );
+
    /* Clear some useful things. */
    pilot_clearHooks( p );
    effect_cleanup( p->effects );
@@ -3944,11 +4425,12 @@ void pilot_free( Pilot *p )
  *
  *    @param p Pilot to destroy.
  */
-static void pilot_erase( Pilot *p )
+static void pilot_erase( int i )
 {
-   int i = pilot_getStackPos( p->id );
-   pilot_free( p );
+   pilot_free( pilot_stack[i] );
    array_erase( &pilot_stack, &pilot_stack[i], &pilot_stack[i + 1] );
+   pilot_stackRenumber( i );
+   pilot_quadtreeInvalidate(); /* Stack positions changed. */
 }
 
 /**
@@ -3962,8 +4444,11 @@ void pilot_stackRemove( Pilot *p )
       WARN( _( "Trying to remove non-existent pilot '%s' from stack!" ),
             p->name );
 #endif /* DEBUGGING */
+   pilot_freeID( p );
    p->id = 0;
    array_erase( &pilot_stack, &pilot_stack[i], &pilot_stack[i + 1] );
+   pilot_stackRenumber( i );
+   pilot_quadtreeInvalidate(); /* Stack positions changed. */
 }
 
 /**
@@ -3971,8 +4456,22 @@ void pilot_stackRemove( Pilot *p )
  */
 void pilots_init( void )
 {
-   pilot_stack = array_create_size( Pilot *, PILOT_SIZE_MIN );
+   pilot_stack    = array_create_size( Pilot *, PILOT_SIZE_MIN );
+   pilot_slots    = array_create_size( Pilot *, PILOT_SIZE_MIN );
+   pilot_gen      = array_create_size( unsigned int, PILOT_SIZE_MIN );
+   pilot_freelist = array_create( int );
+   pilot_freehead = 0;
+   for ( int i = 0; i < PILOT_SLOT_FIRST; i++ ) {
+      array_push_back( &pilot_slots, NULL );
+      array_push_back( &pilot_gen, 0 );
+   }
    il_create( &pilot_qtquery, 1 );
+   il_create( &pilot_qtnearest, 1 );
+   il_create( &pilot_qtwithin, 1 );
+   qt_extra  = array_create( int );
+   qt_always = array_create( int );
+   qt_pos    = array_create( vec2 );
+   qt_cand   = array_create( int );
 }
 
 /**
@@ -3998,12 +4497,33 @@ void pilots_free( void )
    array_free( pilot_stack );
    pilot_stack = NULL;
    player.p    = NULL;
+   array_free( pilot_slots );
+   pilot_slots = NULL;
+   array_free( pilot_gen );
+   pilot_gen = NULL;
+   array_free( pilot_freelist );
+   pilot_freelist = NULL;
+   pilot_outfitLFree();
+   pilot_ewFree();
    free( player.ps.acquired );
    memset( &player.ps, 0, sizeof( PlayerShip_t ) );
 
    /* Clean up quadtree. */
    qt_destroy( &pilot_quadtree );
    il_destroy( &pilot_qtquery );
+   il_destroy( &pilot_qtnearest );
+   il_destroy( &pilot_qtwithin );
+   array_free( qt_extra );
+   qt_extra = NULL;
+   array_free( qt_always );
+   qt_always = NULL;
+   array_free( qt_pos );
+   qt_pos = NULL;
+   array_free( qt_cand );
+   qt_cand = NULL;
+   array_free( solid_ahead );
+   solid_ahead = NULL;
+   pilot_quadtreeInvalidate();
 }
 
 /**
@@ -4055,6 +4575,8 @@ void pilots_clean( int persist )
    }
    array_erase( &pilot_stack, &pilot_stack[persist_count],
                 array_end( pilot_stack ) );
+   pilot_stackRenumber( 0 );
+   pilot_quadtreeInvalidate(); /* Stack positions changed. */
 
    /* Init AI on the remaining pilots, has to be done here so the pilot_stack is
     * consistent. */
@@ -4088,7 +4610,10 @@ void pilots_newSystem( void )
    if ( qt_init )
       qt_destroy( &pilot_quadtree );
    qt_create( &pilot_quadtree, -r, -r, r, r, qt_max_elem, qt_depth );
-   qt_init = 1;
+   qt_init   = 1;
+   qt_extent = r;
+   qt_valid  = 0;
+   qt_moved  = 0;
 
    NTracingZoneEnd( _ctx );
 }
@@ -4117,6 +4642,7 @@ void pilots_cleanAll( void )
    }
    array_erase( &pilot_stack, array_begin( pilot_stack ),
                 array_end( pilot_stack ) );
+   pilot_quadtreeInvalidate();
 }
 
 static void pilot_addQuadtree( const Pilot *p, int i )
@@ -4148,24 +4674,49 @@ void pilots_updatePurge( void )
 
       /* Destroy pilot and go on. */
       if ( pilot_isFlag( p, PILOT_DELETE ) )
-         pilot_erase( p );
+         pilot_erase( i );
    }
 
    /* Second loop sets up quadtrees. */
    qt_clear( &pilot_quadtree ); /* Empty it. */
+   array_erase( &qt_extra, array_begin( qt_extra ), array_end( qt_extra ) );
+   array_erase( &qt_always, array_begin( qt_always ), array_end( qt_always ) );
+   array_resize( &qt_pos, array_size( pilot_stack ) );
+   memset( &qt_ew, 0, sizeof( qt_ew ) );
    for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
       const Pilot *p = pilot_stack[i];
 
+      /* Radius searches need to know where pilots were and what they can
+       * see. */
+      qt_pos[i] = p->solid.pos;
+      pilot_ewBoundUpdate( p );
+      if ( pilot_isVisibleAnywhere( p ) )
+         array_push_back( &qt_always, i );
+
       /* Ignore pilots being deleted. */
       if ( pilot_isFlag( p, PILOT_DELETE ) )
          continue;
 
-      /* Ignore hidden pilots. */
-      if ( pilot_isFlag( p, PILOT_HIDE ) )
+      /* Ignore hidden pilots, but they may be unhidden before the next
+       * rebuild, so nearest searches still have to check them. */
+      if ( pilot_isFlag( p, PILOT_HIDE ) ) {
+         array_push_back( &qt_extra, i );
          continue;
+      }
+
+      /* Pilots outside of the quadtree can't be found by querying it. */
+      if ( ( FABS( p->solid.pos.x ) + p->ship->size >= qt_extent ) ||
+           ( FABS( p->solid.pos.y ) + p->ship->size >= qt_extent ) ||
+           ( FABS( p->solid.pre.x ) + p->ship->size >= qt_extent ) ||
+           ( FABS( p->solid.pre.y ) + p->ship->size >= qt_extent ) )
+         array_push_back( &qt_extra, i );
 
       pilot_addQuadtree( p, i );
    }
+   qt_num   = array_size( pilot_stack );
+   qt_valid = qt_init;
+   qt_moved = 0;
+   qt_slack = 0.;
 
    NTracingZoneEnd( _ctx );
 }
@@ -4227,7 +4778,23 @@ void pilots_update( double dt )
       }
    }
 
-   /* Now update all the pilots. */
+   /* Integrate the solids ahead of time, in parallel. This only reads and
+    * writes the pilot's own solid, and pilot_update only uses the result if
+    * the solid didn't change since. */
+   if ( solid_ahead == NULL )
+      solid_ahead = array_create( PilotSolidAhead );
+   array_resize( &solid_ahead, array_size( pilot_stack ) );
+   vpool_parallel( array_size( pilot_stack ), PILOT_UPDATE_GRAIN,
+                   pilots_updateSolidRange, &dt );
+
+   /* Pilots are about to move, so the quadtree can't be trusted anymore.
+    * Radius searches can still use it by keeping track of how far they
+    * move. */
+   qt_moved = qt_valid;
+   qt_valid = 0;
+   qt_slack = 0.;
+
+   /* Now update all the pilots. This runs Lua, so it has to be serial. */
    for ( int i = 0; i < array_size( pilot_stack ); i++ ) {
       Pilot *p = pilot_stack[i];
 
@@ -4240,15 +4807,48 @@ void pilots_update( double dt )
          continue;
 
       /* Just update the pilot. */
+      qt_cur    = i;
+      solid_cur = i;
       if ( pilot_isFlag( p, PILOT_PLAYER ) )
          player_update( p, dt );
       else
          pilot_update( p, dt );
+      pilot_quadtreeMoved( i );
    }
+   qt_cur    = -1;
+   solid_cur = -1;
 
    NTracingZoneEnd( _ctx );
 }
 
+/**
+ * @brief Integrates the solids of a range of pilots ahead of their update, run
+ * from vpool_parallel.
+ *
+ *    @param start First pilot to integrate.
+ *    @param end One past the last pilot to integrate.
+ *    @param data Pointer to the current delta tick.
+ */
+static void pilots_updateSolidRange( int start, int end, void *data )
+{
+   double dt = *(const double *)data;
+   for ( int i = start; i < end; i++ ) {
+      const Pilot     *p  = pilot_stack[i];
+      PilotSolidAhead *sa = &solid_ahead[i];
+      sa->p               = NULL;
+      if ( pilot_isFlag( p, PILOT_DELETE ) || pilot_isFlag( p, PILOT_HIDE ) )
+         continue;
+      sa->p    = p;
+      sa->ship = p->ship;
+      sa->dt   = dt * p->stats.time_speedup; /* Same as pilot_update. */
+      memcpy( &sa->in, &p->solid, sizeof( Solid ) );
+      memcpy( &sa->out, &p->solid, sizeof( Solid ) );
+      sa->out.update( &sa->out, sa->dt );
+      gl_getSpriteFromDir( &sa->tsx, &sa->tsy, p->ship->sx, p->ship->sy,
+                           sa->out.dir );
+   }
+}
+
 /**
  * @brief Renders all the pilots.
  */
@@ -4567,3 +5167,15 @@ void pilot_quadtreeParams( int max_elem, int depth )
    qt_max_elem = max_elem;
    qt_depth    = depth;
 }
+
+/**
+ * @brief Marks the quad tree as outdated until it is rebuilt.
+ *
+ * Has to be called when pilots are moved outside of the physics update, so that
+ * the nearest pilot searches don't rely on old positions.
+ */
+void pilot_quadtreeInvalidate( void )
+{
+   qt_valid = 0;
+   qt_moved = 0;
+}
@@ -260,9 +260,11 @@ typedef struct Escort_s {
  * @brief The representation of an in-game pilot.
  */
 typedef struct Pilot_ {
-   unsigned int id;   /**< pilot's id, used for many functions */
-   char        *name; /**< pilot's name (if unique) */
-   double       r;    /**< Pilot's randomness value in [0,1] range. */
+   unsigned int id;       /**< pilot's id, used for many functions */
+   int          stackpos; /**< Position in the pilot stack, only valid while
+                               on it. */
+   char        *name;     /**< pilot's name (if unique) */
+   double       r;        /**< Pilot's randomness value in [0,1] range. */
 
    /* Fleet/faction management. */
    int faction;  /**< Pilot's faction. */
@@ -445,6 +447,20 @@ typedef struct Pilot_ {
    lvar  *shipvar;       /**< Per-ship version of lua mission variables. */
 } Pilot;
 
+/**
+ * @brief Filter for pilot_getWithin(), returns 1 for pilots to keep.
+ */
+typedef int ( *PilotFilterFunc )( const Pilot *p, const void *data );
+
+/**
+ * @brief Upper bounds of the electronic warfare of the pilots in space.
+ */
+typedef struct PilotEWBound_ {
+   double detect;    /**< Bound of the absolute stats.ew_detect. */
+   double signature; /**< Bound of the absolute ew_signature. */
+   double detection; /**< Bound of the absolute ew_detection. */
+} PilotEWBound;
+
 /* These depend on Pilot being defined first. */
 #include "pilot_cargo.h"  // IWYU pragma: export
 #include "pilot_ew.h"     // IWYU pragma: export
@@ -476,6 +492,8 @@ double pilot_getNearestPos( const Pilot *p, unsigned int *tp, double x,
                             double y, int disabled );
 double pilot_getNearestAng( const Pilot *p, unsigned int *tp, double ang,
                             int disabled );
+int    pilot_getWithin( Pilot ***out, const vec2 *pos, double r, int always,
+                        PilotFilterFunc filter, const void *data );
 int    pilot_getJumps( const Pilot *p );
 const glColour *pilot_getColour( const Pilot *p );
 int             pilot_validTarget( const Pilot *p, const Pilot *target );
@@ -589,3 +607,7 @@ PilotOutfitSlot *pilot_getDockSlot( Pilot *p );
 const IntList   *pilot_collideQuery( int x1, int y1, int x2, int y2 );
 void pilot_collideQueryIL( IntList *il, int x1, int y1, int x2, int y2 );
 void pilot_quadtreeParams( int max_elem, int depth );
+void pilot_quadtreeInvalidate( void );
+void pilot_quadtreeAlways( const Pilot *p );
+const PilotEWBound *pilot_ewBound( void );
+void                pilot_ewBoundUpdate( const Pilot *p );
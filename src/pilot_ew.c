@@ -28,9 +28,12 @@ static void   pilot_ewUpdate( Pilot *p );
 static double pilot_ewMass( double mass );
 static double pilot_ewAsteroid( const Pilot *p );
 static double pilot_ewJumpPoint( const Pilot *p );
+static int    pilot_ewStealthFilter( const Pilot *t, const void *data );
 static int    pilot_ewStealthGetNearby( const Pilot *p, double *mod, int *close,
                                         int *isplayer );
 
+static Pilot **ew_nearby = NULL; /**< Pilots near a stealthed pilot. */
+
 /**
  * @brief Gets the time it takes to scan a pilot.
  *
@@ -91,6 +94,9 @@ static void pilot_ewUpdate( Pilot *p )
    p->ew_stealth =
       MAX( 1000., p->ew_mass * p->stats.ew_hide * 0.25 * p->stats.ew_stealth ) *
       p->ew_asteroid * ew_interference * p->ew_jumppoint;
+
+   /* Keep radius searches large enough. */
+   pilot_ewBoundUpdate( p );
 }
 
 /**
@@ -418,6 +424,39 @@ double pilot_ewWeaponTrack( const Pilot *p, const Pilot *t, double trackmin,
               DOUBLE_TOL ) ); /* Avoid divide by zero if trackmax==trackmin. */
 }
 
+/**
+ * @brief Filters out the pilots that can't break stealth regardless of
+ * distance.
+ *
+ *    @param t Pilot to check.
+ *    @param data Stealthed pilot.
+ *    @return 1 if the pilot may break the stealth.
+ */
+static int pilot_ewStealthFilter( const Pilot *t, const void *data )
+{
+   const Pilot *p = data;
+
+   /* Quick checks first. */
+   if ( pilot_isDisabled( t ) )
+      return 0;
+   if ( !pilot_canTarget( t ) )
+      return 0;
+
+   /* Must not be landing nor taking off. */
+   if ( pilot_isFlag( t, PILOT_LANDING ) || pilot_isFlag( t, PILOT_TAKEOFF ) )
+      return 0;
+
+   /* Allies are ignored. */
+   if ( pilot_areAllies( p, t ) )
+      return 0;
+
+   /* Stealthed pilots don't reduce stealth. */
+   // if (pilot_isFlag(t, PILOT_STEALTH))
+   //    return 0;
+
+   return 1;
+}
+
 /**
  * @brief Checks to see if there are pilots nearby to a stealthed pilot that
  * could break stealth.
@@ -431,8 +470,8 @@ double pilot_ewWeaponTrack( const Pilot *p, const Pilot *t, double trackmin,
 static int pilot_ewStealthGetNearby( const Pilot *p, double *mod, int *close,
                                      int *isplayer )
 {
-   Pilot *const *ps;
-   int           n;
+   int    n;
+   double r;
 
    /* Check nearby non-allies. */
    if ( mod != NULL )
@@ -441,30 +480,14 @@ static int pilot_ewStealthGetNearby( const Pilot *p, double *mod, int *close,
       *close = 0;
    if ( isplayer != NULL )
       *isplayer = 0;
-   n  = 0;
-   ps = pilot_getAll();
-   for ( int i = 0; i < array_size( ps ); i++ ) {
-      double dist;
-      Pilot *t = ps[i];
-
-      /* Quick checks first. */
-      if ( pilot_isDisabled( t ) )
-         continue;
-      if ( !pilot_canTarget( t ) )
-         continue;
-
-      /* Must not be landing nor taking off. */
-      if ( pilot_isFlag( t, PILOT_LANDING ) ||
-           pilot_isFlag( t, PILOT_TAKEOFF ) )
-         continue;
-
-      /* Allies are ignored. */
-      if ( pilot_areAllies( p, t ) )
-         continue;
-
-      /* Stealthed pilots don't reduce stealth. */
-      // if (pilot_isFlag(t, PILOT_STEALTH))
-      //    continue;
+   n = 0;
+   /* Nobody can be further away than the largest detection allows. */
+   r = FABS( p->ew_stealth ) * 1.5 * pilot_ewBound()->detect;
+   pilot_getWithin( &ew_nearby, &p->solid.pos, r, 0, pilot_ewStealthFilter,
+                    p );
+   for ( int i = 0; i < array_size( ew_nearby ); i++ ) {
+      double       dist;
+      const Pilot *t = ew_nearby[i];
 
       /* Compute distance. */
       dist = vec2_dist2( &p->solid.pos, &t->solid.pos );
@@ -488,6 +511,15 @@ static int pilot_ewStealthGetNearby( const Pilot *p, double *mod, int *close,
    return n;
 }
 
+/**
+ * @brief Frees the memory used to look for pilots near stealthed ones.
+ */
+void pilot_ewFree( void )
+{
+   array_free( ew_nearby );
+   ew_nearby = NULL;
+}
+
 /**
  * @brief Updates the stealth mode and checks to see if it is getting broken.
  *
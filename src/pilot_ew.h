@@ -43,3 +43,4 @@ void   pilot_ewUpdateDynamic( Pilot *p, double dt );
 void pilot_ewUpdateStealth( Pilot *p, double dt );
 int  pilot_stealth( Pilot *p );
 void pilot_destealth( Pilot *p );
+void pilot_ewFree( void );
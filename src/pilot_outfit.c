@@ -29,11 +29,26 @@
 
 static int stealth_break = 0; /**< Whether or not to break stealth. */
 
+/**
+ * @brief Slot with a Lua update function, used to group the updates by outfit.
+ */
+typedef struct OutfitLUpdate_ {
+   nlua_env env; /**< Environment of the outfit. */
+   int      id;  /**< Slot index, intrinsic slots go after the normal ones. */
+} OutfitLUpdate;
+static OutfitLUpdate *outfitlupdate_list    = NULL; /**< Slots to update. */
+static int            outfitlupdate_running = 0;    /**< List is in use. */
+
 /*
  * Prototypes.
  */
-static void        pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot );
-static const char *outfitkeytostr( OutfitKey key );
+static void             pilot_calcStatsSlot( Pilot           *pilot,
+                                             PilotOutfitSlot *slot );
+static const char      *outfitkeytostr( OutfitKey key );
+static int              outfitLUpdate_cmp( const void *p1, const void *p2 );
+static PilotOutfitSlot *pilot_outfitLUpdateSlot( Pilot *p, int id );
+static int              pilot_outfitLUpdateBatch( Pilot *pilot, int start,
+                                                  double dt );
 
 /**
  * @brief Updates the lockons on the pilot's launchers
@@ -957,7 +972,7 @@ static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot )
       ss_statsMergeFromList( &pilot->stats, slot->lua_stats );
 
    /* Has update function. */
-   if ( o->lua_update != LUA_NOREF )
+   if ( ( o->lua_update != LUA_NOREF ) || ( o->lua_update_batch != LUA_NOREF ) )
       pilot->outfitlupdate = 1;
 
    /* Apply modifications. */
@@ -1516,11 +1531,48 @@ int pilot_outfitLInit( const Pilot *pilot, PilotOutfitSlot *po )
    return 1;
 }
 
+/**
+ * @brief Runs update_batch for a single slot.
+ *
+ * Only used when the updates can't be grouped by outfit.
+ */
+static void outfitLUpdateBatch( const Pilot *pilot, PilotOutfitSlot *po,
+                                const void *data )
+{
+   nlua_env env = po->outfit->lua_env;
+   double   dt  = *(double *)data;
+
+   if ( po->lua_mem == LUA_NOREF ) {
+      lua_newtable( naevL );                              /* mem */
+      po->lua_mem = luaL_ref( naevL, LUA_REGISTRYINDEX ); /* */
+   }
+
+   /* Set up the function: update_batch( p, { po }, { mem }, dt ) */
+   lua_rawgeti( naevL, LUA_REGISTRYINDEX, po->outfit->lua_update_batch );
+   lua_pushpilot( naevL, pilot->id );
+   lua_newtable( naevL );
+   lua_pushpilotoutfit( naevL, po );
+   lua_rawseti( naevL, -2, 1 );
+   lua_newtable( naevL );
+   lua_rawgeti( naevL, LUA_REGISTRYINDEX, po->lua_mem );
+   lua_rawseti( naevL, -2, 1 );
+   lua_pushnumber( naevL, dt );
+   if ( nlua_pcall( env, 4, 0 ) ) {
+      outfitLRunWarning( pilot, po->outfit, "update_batch",
+                         lua_tostring( naevL, -1 ) );
+      lua_pop( naevL, 1 );
+   }
+}
+
 static void outfitLUpdate( const Pilot *pilot, PilotOutfitSlot *po,
                            const void *data )
 {
    double dt;
    int    oldmem;
+   if ( po->outfit->lua_update_batch != LUA_NOREF ) {
+      outfitLUpdateBatch( pilot, po, data );
+      return;
+   }
    if ( po->outfit->lua_update == LUA_NOREF )
       return;
 
@@ -1544,22 +1596,206 @@ static void outfitLUpdate( const Pilot *pilot, PilotOutfitSlot *po,
    }
    pilot_outfitLunmem( env, oldmem );
 }
+
+/**
+ * @brief Compares slots to update so that they get grouped by outfit.
+ */
+static int outfitLUpdate_cmp( const void *p1, const void *p2 )
+{
+   const OutfitLUpdate *u1 = p1;
+   const OutfitLUpdate *u2 = p2;
+   if ( u1->env != u2->env )
+      return u1->env - u2->env;
+   return u1->id - u2->id;
+}
+
+/**
+ * @brief Gets a slot by index, with the intrinsic slots after the normal ones.
+ *
+ *    @param p Pilot to get slot of.
+ *    @param id Index of the slot.
+ *    @return The slot or NULL if out of range.
+ */
+static PilotOutfitSlot *pilot_outfitLUpdateSlot( Pilot *p, int id )
+{
+   int n = array_size( p->outfits );
+   if ( id < n )
+      return p->outfits[id];
+   id -= n;
+   if ( id < array_size( p->outfit_intrinsic ) )
+      return &p->outfit_intrinsic[id];
+   return NULL;
+}
+
+/**
+ * @brief Runs update_batch once for all the slots of an outfit.
+ *
+ * The pilot and the old memory of the outfit have to be on the Lua stack.
+ *
+ *    @param pilot Pilot to run Lua outfits for.
+ *    @param start First entry of outfitlupdate_list with the outfit.
+ *    @param dt Delta-tick from last time it was run.
+ *    @return Last entry of outfitlupdate_list with the outfit.
+ */
+static int pilot_outfitLUpdateBatch( Pilot *pilot, int start, double dt )
+{
+   const PilotOutfitSlot *first =
+      pilot_outfitLUpdateSlot( pilot, outfitlupdate_list[start].id );
+   const Outfit *o = first->outfit;
+   int           i, n;
+
+   /* Set up the function: update_batch( p, pos, mems, dt ) */
+   lua_rawgeti( naevL, LUA_REGISTRYINDEX, o->lua_update_batch ); /* f */
+   lua_pushvalue( naevL, -3 );                                   /* f, p */
+   lua_newtable( naevL ); /* f, p, pos */
+   lua_newtable( naevL ); /* f, p, pos, mems */
+   n = 0;
+   for ( i = start; i < array_size( outfitlupdate_list ); i++ ) {
+      PilotOutfitSlot *po;
+      if ( outfitlupdate_list[i].env != outfitlupdate_list[start].env )
+         break;
+
+      /* Previous updates may have changed the outfits. */
+      po = pilot_outfitLUpdateSlot( pilot, outfitlupdate_list[i].id );
+      if ( ( po == NULL ) || ( po->outfit != o ) )
+         continue;
+
+      if ( po->lua_mem == LUA_NOREF ) {
+         lua_newtable( naevL );                              /* mem */
+         po->lua_mem = luaL_ref( naevL, LUA_REGISTRYINDEX ); /* */
+      }
+      n++;
+      lua_pushpilotoutfit( naevL, po ); /* f, p, pos, mems, po */
+      lua_rawseti( naevL, -3, n );      /* f, p, pos, mems */
+      lua_rawgeti( naevL, LUA_REGISTRYINDEX, po->lua_mem );
+      lua_rawseti( naevL, -2, n ); /* f, p, pos, mems */
+   }
+   lua_pushnumber( naevL, dt );           /* f, p, pos, mems, dt */
+   if ( nlua_pcall( o->lua_env, 4, 0 ) ) { /* */
+      outfitLRunWarning( pilot, o, "update_batch", lua_tostring( naevL, -1 ) );
+      lua_pop( naevL, 1 );
+   }
+   return i - 1;
+}
+
 /**
  * @brief Runs the pilot's Lua outfits update script.
  *
+ * Slots are updated grouped by outfit, so the environment memory only has to
+ * be saved and restored once per outfit instead of once per slot, and the
+ * pilot is only pushed once. Each slot still sees its own memory.
+ *
+ * Outfits can instead define update_batch( p, pos, mems, dt ), which is run
+ * once with the list of all the pilot's slots with the outfit and the list of
+ * their memories.
+ *
  *    @param pilot Pilot to run Lua outfits for.
  *    @param dt Delta-tick from last time it was run.
  */
 void pilot_outfitLUpdate( Pilot *pilot, double dt )
 {
+   nlua_env env;
+   int      n;
+
    if ( !pilot->outfitlupdate )
       return;
 
    NTracingZone( _ctx, 1 );
-   pilot_outfitLRun( pilot, outfitLUpdate, &dt );
+
+   /* Shouldn't happen, but don't clobber the list if called from an update. */
+   if ( outfitlupdate_running ) {
+      pilot_outfitLRun( pilot, outfitLUpdate, &dt );
+      NTracingZoneEnd( _ctx );
+      return;
+   }
+
+   /* Gather the slots to update. */
+   if ( outfitlupdate_list == NULL )
+      outfitlupdate_list = array_create( OutfitLUpdate );
+   array_resize( &outfitlupdate_list, 0 );
+   n = array_size( pilot->outfits ) + array_size( pilot->outfit_intrinsic );
+   for ( int i = 0; i < n; i++ ) {
+      const PilotOutfitSlot *po = pilot_outfitLUpdateSlot( pilot, i );
+      OutfitLUpdate         *u;
+      if ( ( po->outfit == NULL ) ||
+           ( ( po->outfit->lua_update == LUA_NOREF ) &&
+             ( po->outfit->lua_update_batch == LUA_NOREF ) ) )
+         continue;
+      u      = &array_grow( &outfitlupdate_list );
+      u->env = po->outfit->lua_env;
+      u->id  = i;
+   }
+   qsort( outfitlupdate_list, array_size( outfitlupdate_list ),
+          sizeof( OutfitLUpdate ), outfitLUpdate_cmp );
+
+   outfitlupdate_running = 1;
+   pilotoutfit_modified  = 0;
+   env                   = LUA_NOREF;
+   lua_pushpilot( naevL, pilot->id ); /* p */
+   for ( int i = 0; i < array_size( outfitlupdate_list ); i++ ) {
+      PilotOutfitSlot *po =
+         pilot_outfitLUpdateSlot( pilot, outfitlupdate_list[i].id );
+
+      /* Previous updates may have changed the outfits. */
+      if ( ( po == NULL ) || ( po->outfit == NULL ) ||
+           ( ( po->outfit->lua_update == LUA_NOREF ) &&
+             ( po->outfit->lua_update_batch == LUA_NOREF ) ) )
+         continue;
+
+      /* Save the environment memory when changing outfits. */
+      if ( po->outfit->lua_env != env ) {
+         if ( env != LUA_NOREF )
+            nlua_setenv( naevL, env, "mem" ); /* p */
+         env = po->outfit->lua_env;
+         nlua_getenv( naevL, env, "mem" ); /* p, oldmem */
+      }
+
+      /* The outfit may update all its slots at once. */
+      if ( po->outfit->lua_update_batch != LUA_NOREF ) {
+         i = pilot_outfitLUpdateBatch( pilot, i, dt );
+         continue;
+      }
+
+      /* Set the memory of the slot. */
+      if ( po->lua_mem == LUA_NOREF ) {
+         lua_newtable( naevL );                              /* mem */
+         po->lua_mem = luaL_ref( naevL, LUA_REGISTRYINDEX ); /* */
+      }
+      lua_rawgeti( naevL, LUA_REGISTRYINDEX, po->lua_mem ); /* p, oldmem, mem */
+      nlua_setenv( naevL, env, "mem" );                     /* p, oldmem */
+
+      /* Set up the function: update( p, po, dt ) */
+      lua_rawgeti( naevL, LUA_REGISTRYINDEX, po->outfit->lua_update ); /* f */
+      lua_pushvalue( naevL, -3 );       /* f, p */
+      lua_pushpilotoutfit( naevL, po ); /* f, p, po */
+      lua_pushnumber( naevL, dt );      /* f, p, po, dt */
+      if ( nlua_pcall( env, 3, 0 ) ) {  /* */
+         outfitLRunWarning( pilot, po->outfit, "update",
+                            lua_tostring( naevL, -1 ) );
+         lua_pop( naevL, 1 );
+      }
+   }
+   if ( env != LUA_NOREF )
+      nlua_setenv( naevL, env, "mem" ); /* p */
+   lua_pop( naevL, 1 );                 /* */
+   outfitlupdate_running = 0;
+
+   /* Recalculate if anything changed. */
+   if ( pilotoutfit_modified )
+      pilot_calcStats( pilot );
+
    NTracingZoneEnd( _ctx );
 }
 
+/**
+ * @brief Frees the memory used to run the Lua outfit updates.
+ */
+void pilot_outfitLFree( void )
+{
+   array_free( outfitlupdate_list );
+   outfitlupdate_list = NULL;
+}
+
 static void outfitLOutofenergy( const Pilot *pilot, PilotOutfitSlot *po,
                                 const void *data )
 {
@@ -79,6 +79,7 @@ int  pilot_outfitLRemove( const Pilot *pilot, PilotOutfitSlot *po );
 void pilot_outfitLInitAll( Pilot *pilot );
 int  pilot_outfitLInit( const Pilot *pilot, PilotOutfitSlot *po );
 void pilot_outfitLUpdate( Pilot *pilot, double dt );
+void pilot_outfitLFree( void );
 void pilot_outfitLOutfofenergy( Pilot *pilot );
 void pilot_outfitLOnhit( Pilot *pilot, double armour, double shield,
                          unsigned int attacker );
@@ -1256,10 +1256,12 @@ int pilot_shootWeapon( Pilot *p, PilotOutfitSlot *w, const Target *target,
             dockslot = j;
       }
 
-      /* Create the escort. */
-      if ( !outfit_isProp( w->outfit, OUTFIT_PROP_SHOOT_DRY ) )
-         escort_create( p, w->outfit->u.bay.ship, &vp, &p->solid.vel,
-                        p->solid.dir, ESCORT_TYPE_BAY, 1, dockslot );
+      /* Create the escort, not using up ammo if it fails. */
+      if ( !outfit_isProp( w->outfit, OUTFIT_PROP_SHOOT_DRY ) &&
+           ( escort_create( p, w->outfit->u.bay.ship, &vp, &p->solid.vel,
+                            p->solid.dir, ESCORT_TYPE_BAY, 1,
+                            dockslot ) == 0 ) )
+         return 0;
 
       w->u.ammo.quantity -= 1; /* we just shot it */
       p->mass_outfit -= w->outfit->u.bay.ship_mass;
@@ -1002,6 +1002,7 @@ void player_warp( double x, double y )
 {
    unsigned int target = cam_getTarget();
    vec2_cset( &player.p->solid.pos, x, y );
+   pilot_quadtreeInvalidate();
    /* Have to move camera over to avoid moving stars when loading. */
    if ( target == player.p->id )
       cam_setTargetPilot( target, 0 );
@@ -129,7 +129,9 @@ int pfleet_deploy( PlayerShip_t *ps )
               player.p->solid.pos.y + 50. * sin( a ) );
 
    /* Add the escort to the fleet. */
-   escort_createRef( player.p, ps->p, &v, NULL, a, ESCORT_TYPE_FLEET, 1, -1 );
+   if ( escort_createRef( player.p, ps->p, &v, NULL, a, ESCORT_TYPE_FLEET, 1,
+                          -1 ) == 0 )
+      return -1;
 
    /* Initialize. */
    ai_pinit( ps->p, "escort" );
@@ -80,6 +80,20 @@ void rng_init( void )
       mt_genArray();
 }
 
+/**
+ * @brief Reseeds the random number generator so the numbers it gives out can
+ * be reproduced.
+ *
+ *    @param seed Seed to use.
+ */
+void rng_seed( unsigned int seed )
+{
+   mt_initArray( seed );
+   for ( int j = 0; j < 10;
+         j++ ) /* generate numbers to get away from poor initial values */
+      mt_genArray();
+}
+
 /**
  * @fn static uint32_t rng_timeEntropy (void)
  *
@@ -46,6 +46,7 @@
 
 /* Init */
 void rng_init( void );
+void rng_seed( unsigned int seed );
 
 /* Random functions */
 unsigned int randint( void );
@@ -140,6 +140,11 @@ static UnionFind
 static cholmod_triplet
    *stiff; /**< K matrix, UT triplets: internal edges (E*3), implicit jump
               connections, anchor conditions. */
+static cholmod_factor
+   *stiff_f; /**< Factorization of stiff. The sparsity pattern doesn't change
+                between turns, so it's only analyzed once. */
+static cholmod_dense *Y_workspace; /**< Workspace for solving with stiff_f. */
+static cholmod_dense *E_workspace; /**< Workspace for solving with stiff_f. */
 static cholmod_sparse *QtQ; /**< (Q*)Q where Q is the ExV difference matrix. */
 static cholmod_dense
    *ftilde; /**< Fluxes (bunch of F columns in the KU=F problem). */
@@ -355,6 +360,9 @@ static void safelanes_destroyOptimizer( void )
                                 updated after the final activateByGradient. */
    cholmod_free_dense( &ftilde, &C );
    cholmod_free_sparse( &QtQ, &C );
+   cholmod_free_factor( &stiff_f, &C );
+   cholmod_free_dense( &Y_workspace, &C );
+   cholmod_free_dense( &E_workspace, &C );
    cholmod_free_triplet( &stiff, &C );
 }
 
@@ -365,14 +373,16 @@ static void safelanes_destroyOptimizer( void )
 static int safelanes_buildOneTurn( int iters_done )
 {
    cholmod_sparse *stiff_s;
-   cholmod_factor *stiff_f;
-   cholmod_dense  *_QtQutilde, *Lambda_tilde, *Y_workspace, *E_workspace;
+   cholmod_dense  *_QtQutilde, *Lambda_tilde;
    int             turns_next_time;
    double          zero[] = { 0, 0 }, neg_1[] = { -1, 0 };
 
-   Y_workspace = E_workspace = Lambda_tilde = NULL;
-   stiff_s = cholmod_triplet_to_sparse( stiff, 0, &C );
-   stiff_f = cholmod_analyze( stiff_s, &C );
+   Lambda_tilde = NULL;
+   stiff_s      = cholmod_triplet_to_sparse( stiff, 0, &C );
+   /* Only conductivities change between turns, so the symbolic analysis can be
+    * reused and just the numeric factorization redone. */
+   if ( stiff_f == NULL )
+      stiff_f = cholmod_analyze( stiff_s, &C );
    cholmod_factorize( stiff_s, stiff_f, &C );
    cholmod_solve2( CHOLMOD_A, stiff_f, ftilde, NULL, &utilde, NULL,
                    &Y_workspace, &E_workspace, &C );
@@ -381,9 +391,6 @@ static int safelanes_buildOneTurn( int iters_done )
    cholmod_solve2( CHOLMOD_A, stiff_f, _QtQutilde, NULL, &Lambda_tilde, NULL,
                    &Y_workspace, &E_workspace, &C );
    cholmod_free_dense( &_QtQutilde, &C );
-   cholmod_free_dense( &Y_workspace, &C );
-   cholmod_free_dense( &E_workspace, &C );
-   cholmod_free_factor( &stiff_f, &C );
    cholmod_free_sparse( &stiff_s, &C );
    turns_next_time = safelanes_activateByGradient( Lambda_tilde, iters_done );
    cholmod_free_dense( &Lambda_tilde, &C );
@@ -82,6 +82,13 @@ SHADERS = [
       attributes = ["vertex"],
       uniforms = ["projection", "colour", "tex_mat", "sampler"],
    ),
+   Shader(
+      name = "texture_batch",
+      vs_path = "texture_batch.vert",
+      fs_path = "texture_batch.frag",
+      attributes = ["vertex", "vertex_tex", "vertex_colour"],
+      uniforms = ["projection", "sampler"],
+   ),
    Shader(
       name = "texture_depth",
       vs_path = "texture.vert",
@@ -147,10 +154,10 @@ SHADERS = [
    ),
    Shader(
       name = "nebula_puff",
-      vs_path = "project_pos.vert",
+      vs_path = "nebula_puff.vert",
       fs_path = "nebula_puff.frag",
-      attributes = ["vertex"],
-      uniforms = ["projection", "nebu_col", "time", "r" ],
+      attributes = ["vertex", "vertex_pos", "vertex_r"],
+      uniforms = ["projection", "nebu_col", "time" ],
    ),
    Shader(
       name = "nebula_map",
@@ -185,8 +192,8 @@ SHADERS = [
       name = "font",
       vs_path = "font.vert",
       fs_path = "font.frag",
-      attributes = ["vertex", "tex_coord"],
-      uniforms = ["projection", "m", "colour", "outline_colour"],
+      attributes = ["vertex", "tex_coord", "vertex_m"],
+      uniforms = ["projection", "colour", "outline_colour"],
    ),
    Shader(
       name = "beam",
@@ -515,6 +522,8 @@ void shaders_load (void) {
    if (conf.devmode) {
       time = SDL_GetTicks() - time;
       DEBUG( n_("Loaded %d Shader in %.3f s", "Loaded %d Shaders in %.3f s", NUM_SHADERS ), NUM_SHADERS, time/1000. );
+      if (gl_has( OPENGL_PROGRAM_BINARY ))
+         DEBUG( n_("%d Shader program loaded from the binary cache", "%d Shader programs loaded from the binary cache", gl_program_cacheHits() ), gl_program_cacheHits() );
    }
    else
       DEBUG( n_("Loaded %d Shader", "Loaded %d Shaders", NUM_SHADERS ), NUM_SHADERS );
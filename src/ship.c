@@ -20,6 +20,7 @@
 #include "conf.h"
 #include "faction.h"
 #include "log.h"
+#include "nameindex.h"
 #include "ndata.h"
 #include "nlua.h"
 #include "nlua_camera.h"
@@ -56,6 +57,7 @@ typedef struct ShipThreadData_ {
 } ShipThreadData;
 
 static Ship *ship_stack = NULL; /**< Stack of ships available in the game. */
+static NameIndex ship_index; /**< Maps ship names to stack positions. */
 
 #define SHIP_FBO 3
 static double       max_size            = 512.; /* Use at least 512 x 512. */
@@ -111,9 +113,8 @@ const Ship *ship_get( const char *name )
  */
 const Ship *ship_getW( const char *name )
 {
-   const Ship s = { .name = (char *)name };
-   return bsearch( &s, ship_stack, array_size( ship_stack ), sizeof( Ship ),
-                   ship_cmp );
+   int id = nameindex_get( &ship_index, name );
+   return ( id < 0 ) ? NULL : &ship_stack[id];
 }
 
 /**
@@ -1520,6 +1521,9 @@ int ships_load( void )
 
    /* Sort and done! */
    qsort( ship_stack, array_size( ship_stack ), sizeof( Ship ), ship_cmp );
+   nameindex_clear( &ship_index );
+   for ( int i = 0; i < array_size( ship_stack ); i++ )
+      nameindex_add( &ship_index, ship_stack[i].name, i );
 
 #if DEBUGGING
    /* Check to see if there are name collisions. */
@@ -1689,6 +1693,7 @@ void ships_free( void )
 
    array_free( ship_stack );
    ship_stack = NULL;
+   nameindex_free( &ship_index );
 }
 
 static void ship_freeSlot( ShipOutfitSlot *s )
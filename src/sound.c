@@ -51,6 +51,7 @@
 #include "nlua_spfx.h"
 #include "nopenal.h"
 #include "pilot.h"
+#include "threadpool.h"
 
 #define SOUND_FADEOUT 100
 #define SOUND_VOICES                                                           \
@@ -59,6 +60,7 @@
 
 #define SOUND_SUFFIX_WAV ".wav" /**< Suffix of sounds. */
 #define SOUND_SUFFIX_OGG ".ogg" /**< Suffix of sounds. */
+#define SOUND_LOAD_GRAIN 4      /**< Sounds to decode per vpool chunk. */
 
 #define voiceLock() SDL_LockMutex( voice_mutex )
 #define voiceUnlock() SDL_UnlockMutex( voice_mutex )
@@ -73,9 +75,20 @@ typedef struct alSound_ {
    char  *name;     /**< Buffer's name. */
    double length;   /**< Length of the buffer. */
    int    channels; /**< Number of channels of the buffer. */
+   int    lazy;     /**< Not decoded yet, will be on first use. */
    ALuint buf;      /**< Buffer data. */
 } alSound;
 
+/**
+ * @struct SoundLoad
+ *
+ * @brief A sound being loaded by sound_makeList.
+ */
+typedef struct SoundLoad_ {
+   alSound snd; /**< Sound being loaded. */
+   int     ret; /**< Status of the load, 0 on success. */
+} SoundLoad;
+
 /**
  * @typedef voice_state_t
  * @brief The state of a voice.
@@ -155,6 +168,8 @@ static double snd_compression_gain = 0.; /**< Current compression gain. */
  */
 /* General. */
 static int  sound_makeList( void );
+static void sound_loadRange( int start, int end, void *data );
+static int  sound_loadLazy( alSound *snd );
 static void sound_free( alSound *snd );
 /* Voices. */
 
@@ -220,6 +235,7 @@ static int         al_enableEFX( void );
 static int al_playVoice( alVoice *v, alSound *s, ALfloat px, ALfloat py,
                          ALfloat vx, ALfloat vy, ALint relative );
 static int al_load( alSound *snd, SDL_RWops *rw, const char *name );
+static int al_probe( alSound *snd, SDL_RWops *rw, const char *name );
 static int al_loadWav( ALuint *buf, SDL_RWops *rw );
 static int al_loadOgg( ALuint *buf, OggVorbis_File *vf );
 /*
@@ -802,11 +818,13 @@ int sound_play( int sound )
    if ( ( sound < 0 ) || ( sound >= array_size( sound_list ) ) )
       return -1;
 
-   /* Gets a new voice. */
-   v = voice_new();
-
    /* Get the sound. */
    s = &sound_list[sound];
+   if ( sound_loadLazy( s ) )
+      return -1;
+
+   /* Gets a new voice. */
+   v = voice_new();
 
    /* Try to play the sound. */
    if ( al_playVoice( v, s, 0., 0., 0., 0., AL_TRUE ) )
@@ -860,11 +878,13 @@ int sound_playPos( int sound, double px, double py, double vx, double vy )
          return 0;
    }
 
-   /* Gets a new voice. */
-   v = voice_new();
-
    /* Get the sound. */
    s = &sound_list[sound];
+   if ( sound_loadLazy( s ) )
+      return -1;
+
+   /* Gets a new voice. */
+   v = voice_new();
 
    /* Try to play the sound. */
    if ( al_playVoice( v, s, px, py, vx, vy, AL_FALSE ) )
@@ -1202,13 +1222,72 @@ void sound_setSpeed( double s )
    soundUnlock();
 }
 
+/**
+ * @brief Loads a range of sounds, run from vpool_parallel.
+ *
+ * Decoding is done in parallel, while uploading to OpenAL is serialized by
+ * the sound lock in the loaders.
+ *
+ *    @param start First sound to load.
+ *    @param end One past the last sound to load.
+ *    @param data Array of SoundLoad being loaded.
+ */
+static void sound_loadRange( int start, int end, void *data )
+{
+   SoundLoad *sl = data;
+   for ( int i = start; i < end; i++ ) {
+      alSound   *snd = &sl[i].snd;
+      SDL_RWops *rw  = PHYSFSRWOPS_openRead( snd->filename );
+      if ( rw == NULL ) {
+         WARN( _( "Failed to open sound file '%s'." ), snd->filename );
+         sl[i].ret = -1;
+         continue;
+      }
+      if ( conf.sound_lazy )
+         sl[i].ret = al_probe( snd, rw, snd->name );
+      else
+         sl[i].ret = al_load( snd, rw, snd->name );
+      SDL_RWclose( rw );
+   }
+}
+
+/**
+ * @brief Makes sure a sound is decoded and uploaded before being played.
+ *
+ *    @param snd Sound to load if it is lazy.
+ *    @return 0 if the sound can be played.
+ */
+static int sound_loadLazy( alSound *snd )
+{
+   SDL_RWops *rw;
+
+   if ( !snd->lazy )
+      return ( snd->buf == 0 ) ? -1 : 0;
+
+   /* Only try once, failures stay silent afterwards. */
+   snd->lazy = 0;
+   rw        = PHYSFSRWOPS_openRead( snd->filename );
+   if ( rw == NULL ) {
+      WARN( _( "Failed to open sound file '%s'." ), snd->filename );
+      return -1;
+   }
+   if ( sound_al_buffer( &snd->buf, rw, snd->name ) )
+      snd->buf = 0;
+   SDL_RWclose( rw );
+   return ( snd->buf == 0 ) ? -1 : 0;
+}
+
 /**
  * @brief Makes the list of available sounds.
  */
 static int sound_makeList( void )
 {
-   char **files;
-   int    suflen;
+   char     **files;
+   int        suflen;
+   SoundLoad *sl;
+#if DEBUGGING
+   Uint32 time = SDL_GetTicks();
+#endif /* DEBUGGING */
 
    if ( sound_disabled )
       return 0;
@@ -1218,13 +1297,14 @@ static int sound_makeList( void )
 
    /* Create the list. */
    sound_list = array_create( alSound );
+   sl         = array_create( SoundLoad );
 
-   /* load the profiles */
+   /* find the sounds */
    suflen = strlen( SOUND_SUFFIX_WAV );
    for ( size_t i = 0; files[i] != NULL; i++ ) {
       int        len;
       char       path[PATH_MAX];
-      SDL_RWops *rw;
+      SoundLoad *l;
       int        flen = strlen( files[i] );
 
       /* Must be longer than suffix. */
@@ -1238,22 +1318,45 @@ static int sound_makeList( void )
              0 ) )
          continue;
 
-      /* Load the sound. */
       snprintf( path, sizeof( path ), SOUND_PATH "%s", files[i] );
-      rw = PHYSFSRWOPS_openRead( path );
 
       /* remove the suffix */
       len           = flen - suflen;
       files[i][len] = '\0';
 
-      source_newRW( rw, files[i], 0 );
-      SDL_RWclose( rw );
+      l = &array_grow( &sl );
+      memset( l, 0, sizeof( SoundLoad ) );
+      l->snd.filename = strdup( path );
+      l->snd.name     = strdup( files[i] );
+   }
+
+   /* Decode them all in parallel. */
+   vpool_parallel( array_size( sl ), SOUND_LOAD_GRAIN, sound_loadRange, sl );
+
+   /* Add in order, so the IDs don't depend on the threads. */
+   for ( int i = 0; i < array_size( sl ); i++ ) {
+      if ( sl[i].ret != 0 ) {
+         free( sl[i].snd.filename );
+         free( sl[i].snd.name );
+         continue;
+      }
+      array_push_back( &sound_list, sl[i].snd );
    }
 
-   DEBUG( n_( "Loaded %d Sound", "Loaded %d Sounds", array_size( sound_list ) ),
-          array_size( sound_list ) );
+#if DEBUGGING
+   if ( conf.devmode ) {
+      time = SDL_GetTicks() - time;
+      DEBUG( n_( "Loaded %d Sound in %.3f s", "Loaded %d Sounds in %.3f s",
+                 array_size( sound_list ) ),
+             array_size( sound_list ), time / 1000. );
+   } else
+#endif /* DEBUGGING */
+      DEBUG( n_( "Loaded %d Sound", "Loaded %d Sounds",
+                 array_size( sound_list ) ),
+             array_size( sound_list ) );
 
    /* Clean up. */
+   array_free( sl );
    PHYSFS_freeList( files );
 
    return 0;
@@ -1321,6 +1424,8 @@ static void sound_free( alSound *snd )
    free( snd->filename );
 
    /* Free internals. */
+   if ( snd->buf == 0 )
+      return;
    soundLock();
 
    alDeleteBuffers( 1, &snd->buf );
@@ -1418,6 +1523,8 @@ int sound_playGroup( int group, int sound, int once )
       return -1;
 
    s = &sound_list[sound];
+   if ( sound_loadLazy( s ) )
+      return -1;
    for ( int i = 0; i < al_ngroups; i++ ) {
       alGroup_t *g;
 
@@ -2152,6 +2259,50 @@ int al_load( alSound *snd, SDL_RWops *rw, const char *name )
    return 0;
 }
 
+/**
+ * @brief Reads the sound information without decoding it.
+ *
+ * Only Ogg files get deferred, as wav files are already PCM and there is
+ * nothing to gain by not loading them right away.
+ *
+ *    @param snd Sound to probe.
+ *    @param rw File to probe.
+ *    @param name Name for debugging purposes.
+ *    @return 0 on success.
+ */
+static int al_probe( alSound *snd, SDL_RWops *rw, const char *name )
+{
+   int            ret;
+   OggVorbis_File vf;
+   vorbis_info   *info;
+
+   /* Not an Ogg, so just load it. */
+   if ( ov_test_callbacks( rw, &vf, NULL, 0, sound_al_ovcall_noclose ) != 0 ) {
+      ov_clear( &vf );
+      SDL_RWseek( rw, 0, SEEK_SET );
+      return al_load( snd, rw, name );
+   }
+
+   /* Finish opening the file. */
+   ret = ov_test_open( &vf );
+   if ( ret ) {
+      WARN( _( "Failed to finish loading Ogg file '%s': %s" ), name,
+            vorbis_getErr( ret ) );
+      ov_clear( &vf );
+      return -1;
+   }
+
+   /* Get the length from the headers. */
+   info          = ov_info( &vf, -1 );
+   snd->channels = info->channels;
+   snd->length   = (double)ov_pcm_total( &vf, -1 ) / (double)info->rate;
+   snd->buf      = 0;
+   snd->lazy     = 1;
+
+   ov_clear( &vf );
+   return 0;
+}
+
 /**
  * @brief Internal volume update function.
  */
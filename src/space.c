@@ -33,6 +33,7 @@
 #include "menu.h"
 #include "mission.h"
 #include "music.h"
+#include "nameindex.h"
 #include "ndata.h"
 #include "nebula.h"
 #include "nlua.h"
@@ -94,13 +95,8 @@ static char **systemname_stack =
 StarSystem         *systems_stack = NULL; /**< Star system stack. */
 static Spob        *spob_stack    = NULL; /**< Spob stack. */
 static VirtualSpob *vspob_stack   = NULL; /**< Virtual spob stack. */
-/* TODO get rid of the stack_changed stuff, and just redo all the id/pointer
- * stuff. Main issue will be redoing the Lua system/spob modules to handle such
- * a case, but can be done with  the weapon module as a referenc. */
-static int systemstack_changed =
-   0; /**< Whether or not the systems_stack was changed after loading. */
-static int spobstack_changed =
-   0; /**< Whether or not the spob_stack was changed after loading. */
+static NameIndex systems_index; /**< Maps system names to systems_stack IDs. */
+static NameIndex spobs_index;   /**< Maps spob names to spob_stack IDs. */
 static MapShader **mapshaders = NULL; /**< Map shaders. */
 
 /*
@@ -458,12 +454,27 @@ int spob_rename( Spob *p, char *newname )
    }
    if ( !found )
       WARN( _( "Renaming spob '%s', but not found in name stack!" ), p->name );
+   nameindex_remove( &spobs_index, p->name );
    free( p->name );
    p->name = newname;
+   nameindex_add( &spobs_index, p->name, p->id );
 
-   /* Order changed, so no more bsearch for us. */
-   spobstack_changed = 1;
+   return 0;
+}
 
+/**
+ * @brief Renames a star system.
+ *
+ *    @param sys System to rename.
+ *    @param newname New name to give the system, ownership is taken.
+ *    @return 0 on success.
+ */
+int system_rename( StarSystem *sys, char *newname )
+{
+   nameindex_remove( &systems_index, sys->name );
+   free( sys->name );
+   sys->name = newname;
+   nameindex_add( &systems_index, sys->name, sys->id );
    return 0;
 }
 
@@ -880,19 +891,14 @@ int space_sysReachable( const StarSystem *sys )
  */
 int space_sysReallyReachable( const char *sysname )
 {
-   StarSystem **path, *goal;
+   const StarSystem *goal;
 
    if ( strcmp( sysname, cur_system->name ) == 0 )
       return 1;
    goal = system_get( sysname );
    if ( goal == NULL )
       return 0;
-   path = map_getJumpPath( cur_system, NULL, goal, 1, 1, NULL, NULL );
-   if ( path != NULL ) {
-      array_free( path );
-      return 1;
-   }
-   return 0;
+   return ( map_jumpDist( cur_system, goal, 1 ) >= 0 );
 }
 
 /**
@@ -1001,21 +1007,9 @@ StarSystem *system_get( const char *sysname )
    if ( sysname == NULL )
       return NULL;
 
-   /* Somethig was added, and since we store IDs too, everything can't be sorted
-    * anymore by name... */
-   if ( systemstack_changed ) {
-      for ( int i = 0; i < array_size( systems_stack ); i++ )
-         if ( strcmp( systems_stack[i].name, sysname ) == 0 )
-            return &systems_stack[i];
-      WARN( _( "System '%s' not found in stack" ), sysname );
-      return NULL;
-   }
-
-   const StarSystem s = { .name = (char *)sysname };
-   StarSystem *found  = bsearch( &s, systems_stack, array_size( systems_stack ),
-                                 sizeof( StarSystem ), system_cmp );
-   if ( found != NULL )
-      return found;
+   int id = nameindex_get( &systems_index, sysname );
+   if ( id >= 0 )
+      return &systems_stack[id];
 
    WARN( _( "System '%s' not found in stack" ), sysname );
    return NULL;
@@ -1095,21 +1089,9 @@ Spob *spob_get( const char *spobname )
       return NULL;
    }
 
-   /* Somethig was added, and since we store IDs too, everything can't be sorted
-    * anymore by name... */
-   if ( spobstack_changed ) {
-      for ( int i = 0; i < array_size( spob_stack ); i++ )
-         if ( strcmp( spob_stack[i].name, spobname ) == 0 )
-            return &spob_stack[i];
-      WARN( _( "Spob '%s' not found in the universe" ), spobname );
-      return NULL;
-   }
-
-   const Spob p     = { .name = (char *)spobname };
-   Spob      *found = bsearch( &p, spob_stack, array_size( spob_stack ),
-                               sizeof( Spob ), spob_cmp );
-   if ( found != NULL )
-      return found;
+   int id = nameindex_get( &spobs_index, spobname );
+   if ( id >= 0 )
+      return &spob_stack[id];
 
    WARN( _( "Spob '%s' not found in the universe" ), spobname );
    return NULL;
@@ -1783,21 +1765,23 @@ void space_init( const char *sysname, int do_simulate )
 
 /**
  * @brief Creates a new spob.
+ *
+ *    @param name Name of the new spob, ownership is taken.
+ *    @return The new spob.
  */
-Spob *spob_new( void )
+Spob *spob_new( char *name )
 {
    Spob *p, *old_stack;
    int   realloced;
 
-   if ( !systems_loading )
-      spobstack_changed = 1;
-
    /* Grow and initialize memory. */
    old_stack = spob_stack;
    p         = &array_grow( &spob_stack );
    realloced = ( old_stack != spob_stack );
    spob_initDefaults( p );
-   p->id = array_size( spob_stack ) - 1;
+   p->id   = array_size( spob_stack ) - 1;
+   p->name = name;
+   nameindex_add( &spobs_index, p->name, p->id );
 
    /* Reconstruct the jumps. */
    if ( !systems_loading && realloced )
@@ -1857,8 +1841,11 @@ static int spobs_load( void )
       free( spob_files[i] );
    }
    qsort( spob_stack, array_size( spob_stack ), sizeof( Spob ), spob_cmp );
-   for ( int j = 0; j < array_size( spob_stack ); j++ )
+   nameindex_clear( &spobs_index );
+   for ( int j = 0; j < array_size( spob_stack ); j++ ) {
       spob_stack[j].id = j;
+      nameindex_add( &spobs_index, spob_stack[j].name, j );
+   }
 
    /* Clean up. */
    array_free( spob_files );
@@ -2230,28 +2217,35 @@ void space_gfxLoad( StarSystem *sys )
  */
 void space_gfxUnload( StarSystem *sys )
 {
-   for ( int i = 0; i < array_size( sys->spobs ); i++ ) {
-      Spob *spob = sys->spobs[i];
-
-      if ( spob->lua_unload != LUA_NOREF ) {
-         spob_luaInitMem( spob );
-         lua_rawgeti( naevL, LUA_REGISTRYINDEX, spob->lua_unload ); /* f */
-         if ( nlua_pcall( spob->lua_env, 0, 0 ) ) {
-            WARN( _( "Spob '%s' failed to run '%s':\n%s" ), spob->name,
-                  "unload", lua_tostring( naevL, -1 ) );
-            lua_pop( naevL, 1 );
-         }
-      }
+   for ( int i = 0; i < array_size( sys->spobs ); i++ )
+      spob_gfxUnload( sys->spobs[i] );
+}
 
-      if ( spob->gfx_space3d != NULL ) {
-         glDeleteFramebuffers( 1, &spob->gfx_fbo );
-         glDeleteTextures( 1, &spob->gfx_dtex );
+/**
+ * @brief Unloads a spob's graphics.
+ *
+ *    @param spob Spob to unload graphics for.
+ */
+void spob_gfxUnload( Spob *spob )
+{
+   if ( spob->lua_unload != LUA_NOREF ) {
+      spob_luaInitMem( spob );
+      lua_rawgeti( naevL, LUA_REGISTRYINDEX, spob->lua_unload ); /* f */
+      if ( nlua_pcall( spob->lua_env, 0, 0 ) ) {
+         WARN( _( "Spob '%s' failed to run '%s':\n%s" ), spob->name, "unload",
+               lua_tostring( naevL, -1 ) );
+         lua_pop( naevL, 1 );
       }
-      gltf_free( spob->gfx_space3d );
-      spob->gfx_space3d = NULL;
-      gl_freeTexture( spob->gfx_space );
-      spob->gfx_space = NULL;
    }
+
+   if ( spob->gfx_space3d != NULL ) {
+      glDeleteFramebuffers( 1, &spob->gfx_fbo );
+      glDeleteTextures( 1, &spob->gfx_dtex );
+   }
+   gltf_free( spob->gfx_space3d );
+   spob->gfx_space3d = NULL;
+   gl_freeTexture( spob->gfx_space );
+   spob->gfx_space = NULL;
 }
 
 /**
@@ -2632,9 +2626,9 @@ int system_addSpob( StarSystem *sys, const char *spobname )
    /* This is required to clear the player statistics for this spob */
    economy_clearSingleSpob( spob );
 
-   /* Reload graphics if necessary. */
-   if ( cur_system != NULL )
-      space_gfxLoad( cur_system );
+   /* Load graphics if necessary. */
+   if ( sys == cur_system )
+      spob_gfxLoad( spob );
 
    /* Initialize economy if applicable. */
    if ( spob_hasService( spob, SPOB_SERVICE_COMMODITY ) )
@@ -2849,15 +2843,15 @@ static void system_init( StarSystem *sys )
 
 /**
  * @brief Creates a new star system.
+ *
+ *    @param name Name of the new system, ownership is taken.
+ *    @return The new system.
  */
-StarSystem *system_new( void )
+StarSystem *system_new( char *name )
 {
    StarSystem *sys;
    int         id;
 
-   if ( !systems_loading )
-      systemstack_changed = 1;
-
    /* Protect current system in case of realloc. */
    id = -1;
    if ( cur_system != NULL )
@@ -2872,7 +2866,9 @@ StarSystem *system_new( void )
 
    /* Initialize system and id. */
    system_init( sys );
-   sys->id = array_size( systems_stack ) - 1;
+   sys->id   = array_size( systems_stack ) - 1;
+   sys->name = name;
+   nameindex_add( &systems_index, sys->name, sys->id );
 
    /* Reconstruct the jumps, only truely necessary if the systems realloced. */
    if ( !systems_loading ) {
@@ -2945,6 +2941,46 @@ void systems_reconstructJumps( void )
          sys->jumps[j].targetid = sys->jumps[j].target->id;
    }
 
+   /* Cached jump distances are no longer valid. */
+   map_jumpDistInvalidate();
+
+   NTracingZoneEnd( _ctx );
+}
+
+/**
+ * @brief Reconstructs the jumps of only some systems.
+ *
+ * Systems with jumps into any of the changed systems are also reconstructed, as
+ * their return jumps point into the changed jump arrays.
+ *
+ *    @param changed Array (array.h) of systems whose jumps changed.
+ */
+void systems_reconstructJumpsSet( StarSystem *const *changed )
+{
+   char *mark;
+
+   NTracingZone( _ctx, 1 );
+
+   mark = calloc( array_size( systems_stack ), sizeof( char ) );
+   for ( int i = 0; i < array_size( changed ); i++ )
+      mark[changed[i]->id] = 1;
+
+   for ( int i = 0; i < array_size( systems_stack ); i++ ) {
+      StarSystem *sys   = &systems_stack[i];
+      int         dirty = mark[i];
+      for ( int j = 0; !dirty && ( j < array_size( sys->jumps ) ); j++ )
+         dirty = mark[sys->jumps[j].targetid];
+      if ( !dirty )
+         continue;
+      system_reconstructJumps( sys );
+      for ( int j = 0; j < array_size( sys->jumps ); j++ )
+         sys->jumps[j].targetid = sys->jumps[j].target->id;
+   }
+   free( mark );
+
+   /* Cached jump distances are no longer valid. */
+   map_jumpDistInvalidate();
+
    NTracingZoneEnd( _ctx );
 }
 
@@ -3568,9 +3604,11 @@ static int systems_load( void )
    }
    qsort( systems_stack, array_size( systems_stack ), sizeof( StarSystem ),
           system_cmp );
+   nameindex_clear( &systems_index );
    for ( int j = 0; j < array_size( systems_stack ); j++ ) {
       systems_stack[j].id   = j;
       systems_stack[j].note = NULL; /* just to be sure */
+      nameindex_add( &systems_index, systems_stack[j].name, j );
    }
 
    /*
@@ -3822,6 +3860,8 @@ void space_exit( void )
       nlua_freeEnv( spb->lua_env );
    }
    array_free( spob_stack );
+   spob_stack = NULL;
+   nameindex_free( &spobs_index );
 
    for ( int i = 0; i < array_size( spob_lua_stack ); i++ )
       spob_lua_free( &spob_lua_stack[i] );
@@ -3867,6 +3907,7 @@ void space_exit( void )
    }
    array_free( systems_stack );
    systems_stack = NULL;
+   nameindex_free( &systems_index );
 
    /* Free asteroids stuff. */
    asteroids_free();
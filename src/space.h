@@ -372,10 +372,11 @@ void space_exit( void );
 /*
  * spob stuff
  */
-Spob       *spob_new( void );
+Spob       *spob_new( char *name );
 const char *spob_name( const Spob *p );
 int         spob_luaInit( Spob *spb );
 void        spob_gfxLoad( Spob *p );
+void        spob_gfxUnload( Spob *p );
 int         spob_hasSystem( const Spob *spb );
 const char *spob_getSystem( const char *spobname );
 Spob       *spob_getAll( void );
@@ -427,8 +428,10 @@ const char *jump_getSymbol( const JumpPoint *jp );
  */
 void        system_reconstructJumps( StarSystem *sys );
 void        systems_reconstructJumps( void );
+void        systems_reconstructJumpsSet( StarSystem *const *changed );
 void        systems_reconstructSpobs( void );
-StarSystem *system_new( void );
+StarSystem *system_new( char *name );
+int         system_rename( StarSystem *sys, char *newname );
 const char *system_name( const StarSystem *sys );
 const char *system_nameKnown( const StarSystem *sys );
 int         system_addSpob( StarSystem *sys, const char *spobname );
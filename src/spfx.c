@@ -1110,6 +1110,9 @@ static void spfx_renderStack( SPFX *spfx_stack )
               ( y > SCREEN_H + h ) )
             continue;
 
+         /* Has to go above the sprites queued so far. */
+         gl_renderSpriteFlush();
+
          /* Let's get to business. */
          glUseProgram( effect->shader );
 
@@ -1152,12 +1155,15 @@ static void spfx_renderStack( SPFX *spfx_stack )
             spfx_stack[i].lastframe = sx * sy * MIN( time, 1. );
          }
 
-         /* Renders */
-         gl_renderSprite( effect->gfx, VX( spfx_stack[i].pos ),
-                          VY( spfx_stack[i].pos ), spfx_stack[i].lastframe % sx,
-                          spfx_stack[i].lastframe / sx, NULL );
+         /* Renders, batched with the previous sprites of the same texture. */
+         gl_renderSpriteBatched( effect->gfx, VX( spfx_stack[i].pos ),
+                                 VY( spfx_stack[i].pos ),
+                                 spfx_stack[i].lastframe % sx,
+                                 spfx_stack[i].lastframe / sx, NULL );
       }
    }
+
+   gl_renderSpriteFlush();
 }
 
 /**
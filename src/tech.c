@@ -21,6 +21,7 @@
 #include "nxml.h"
 #include "outfit.h"
 #include "ship.h"
+#include "space.h"
 
 #define XML_TECH_ID "Techs" /**< Tech xml document tag. */
 #define XML_TECH_TAG "tech" /**< Individual tech xml tag. */
@@ -35,6 +36,8 @@ typedef enum tech_item_type_e {
    TECH_TYPE_GROUP,        /**< Tech contains another tech group. */
    TECH_TYPE_GROUP_POINTER /**< Tech contains a tech group pointer. */
 } tech_item_type_t;
+#define TECH_TYPE_FLAT                                                         \
+   ( TECH_TYPE_COMMODITY + 1 ) /**< Number of types that can be flattened. */
 
 /**
  * @brief Item contained in a tech group.
@@ -58,12 +61,42 @@ struct tech_group_s {
    char        *name;     /**< Name of the tech group. */
    char        *filename; /**< Name of the file. */
    tech_item_t *items;    /**< Items in the tech group. */
+   void **flat[TECH_TYPE_FLAT]; /**< Array (array.h): Cached items of each type
+                                   including subgroups, sorted by pointer. */
+   unsigned int flat_gen; /**< Generation the cached items belong to. */
 };
 
+/**
+ * @brief Item and spob pair used to build the reverse index.
+ */
+typedef struct tech_pair_s {
+   const void *ptr;  /**< Item. */
+   int         spob; /**< ID of the spob that has the item. */
+} tech_pair_t;
+
+/**
+ * @brief Reverse index from items of a type to the spobs that have them.
+ */
+typedef struct tech_spob_s {
+   const void **items; /**< Array (array.h): Items, sorted with duplicates. */
+   int         *spobs; /**< Array (array.h): ID of the spob of each item. */
+} tech_spob_t;
+
 /*
  * Group list.
  */
 static tech_group_t *tech_groups = NULL;
+static unsigned int  tech_gen =
+   1; /**< Bumped whenever any tech group changes, invalidating caches. */
+
+/*
+ * Reverse index.
+ */
+static tech_spob_t tech_spob_index[TECH_TYPE_FLAT] = {
+   { 0 } }; /**< Reverse index for each item type. */
+static unsigned int tech_spob_gen =
+   0; /**< Generation the reverse index was built for. */
+static int tech_spob_n = 0; /**< Number of spobs the index was built for. */
 
 /*
  * Prototypes.
@@ -87,6 +120,14 @@ static int tech_addItemGroup( tech_group_t *grp, const char *name );
 /* Getting by tech. */
 static void **tech_addGroupItem( void **items, tech_item_type_t type,
                                  const tech_group_t *tech );
+static void *const *tech_getFlat( const tech_group_t *tech,
+                                  tech_item_type_t    type );
+static int          tech_hasFlat( const tech_group_t *tech,
+                                  tech_item_type_t type, const void *ptr );
+static void       **tech_copyFlat( const tech_group_t *tech,
+                                   tech_item_type_t    type );
+static const int   *tech_getSpobs( tech_item_type_t type, const void *ptr,
+                                   int *n );
 
 static int tech_cmp( const void *p1, const void *p2 )
 {
@@ -95,6 +136,34 @@ static int tech_cmp( const void *p1, const void *p2 )
    return strcmp( t1->name, t2->name );
 }
 
+/**
+ * @brief Compares two item pointers.
+ */
+static int tech_cmpPtr( const void *p1, const void *p2 )
+{
+   const void *v1 = *(const void **)p1;
+   const void *v2 = *(const void **)p2;
+   if ( v1 < v2 )
+      return -1;
+   else if ( v1 > v2 )
+      return +1;
+   return 0;
+}
+
+/**
+ * @brief Compares two item and spob pairs by item and then spob.
+ */
+static int tech_cmpPair( const void *p1, const void *p2 )
+{
+   const tech_pair_t *t1 = p1;
+   const tech_pair_t *t2 = p2;
+   if ( t1->ptr < t2->ptr )
+      return -1;
+   else if ( t1->ptr > t2->ptr )
+      return +1;
+   return t1->spob - t2->spob;
+}
+
 /**
  * @brief Loads the tech information.
  */
@@ -136,6 +205,7 @@ int tech_load( void )
    s = array_size( tech_groups );
    for ( int i = 0; i < s; i++ )
       tech_parseFileData( &tech_groups[i] );
+   tech_gen++;
 
       /* Info. */
 #if DEBUGGING
@@ -162,6 +232,16 @@ void tech_free( void )
 
    /* Free the tech array. */
    array_free( tech_groups );
+   tech_groups = NULL;
+
+   /* Free the reverse index. */
+   for ( int i = 0; i < TECH_TYPE_FLAT; i++ ) {
+      array_free( tech_spob_index[i].items );
+      array_free( tech_spob_index[i].spobs );
+      tech_spob_index[i].items = NULL;
+      tech_spob_index[i].spobs = NULL;
+   }
+   tech_gen++;
 }
 
 /**
@@ -172,6 +252,8 @@ static void tech_freeGroup( tech_group_t *grp )
    free( grp->name );
    free( grp->filename );
    array_free( grp->items );
+   for ( int i = 0; i < TECH_TYPE_FLAT; i++ )
+      array_free( grp->flat[i] );
 }
 
 /**
@@ -182,6 +264,7 @@ tech_group_t *tech_groupCreateXML( xmlNodePtr node )
    /* Load data. */
    tech_group_t *tech = tech_groupCreate();
    tech_parseXMLData( tech, node );
+   tech_gen++;
    return tech;
 }
 
@@ -191,6 +274,7 @@ tech_group_t *tech_groupCreateXML( xmlNodePtr node )
 tech_group_t *tech_groupCreate( void )
 {
    tech_group_t *tech = calloc( 1, sizeof( tech_group_t ) );
+   tech_gen++; /* Spobs may have gained a tech. */
    return tech;
 }
 
@@ -204,6 +288,7 @@ void tech_groupDestroy( tech_group_t *grp )
 
    tech_freeGroup( grp );
    free( grp );
+   tech_gen++;
 }
 
 /**
@@ -474,6 +559,7 @@ int tech_addItem( const char *name, const char *value )
       return -1;
    }
 
+   tech_gen++;
    return 0;
 }
 
@@ -494,6 +580,7 @@ int tech_addItemTech( tech_group_t *tech, const char *value )
       WARN( _( "Generic item '%s' not found in tech group" ), value );
       return -1;
    }
+   tech_gen++;
    return 0;
 }
 
@@ -508,6 +595,7 @@ int tech_rmItemTech( tech_group_t *tech, const char *value )
       const char *buf = tech_getItemName( &tech->items[i] );
       if ( strcmp( buf, value ) == 0 ) {
          array_erase( &tech->items, &tech->items[i], &tech->items[i + 1] );
+         tech_gen++;
          return 0;
       }
    }
@@ -541,6 +629,7 @@ int tech_rmItem( const char *name, const char *value )
       const char *buf = tech_getItemName( &tech->items[i] );
       if ( strcmp( buf, value ) == 0 ) {
          array_erase( &tech->items, &tech->items[i], &tech->items[i + 1] );
+         tech_gen++;
          return 0;
       }
    }
@@ -616,53 +705,179 @@ static void tech_createMetaGroup( tech_group_t *grp, tech_group_t **tech,
 }
 
 /**
- * @brief Recursive function for creating an array of commodities from a tech
- * group.
+ * @brief Recursive function for creating an array of items from a tech group.
+ *
+ * Subgroups use their own cached items, so each group only gets flattened once
+ * until the tech groups change. The result may contain duplicates.
  */
 static void **tech_addGroupItem( void **items, tech_item_type_t type,
                                  const tech_group_t *tech )
 {
-   /* Set up. */
    int size = array_size( tech->items );
-
-   /* Load commodities first, then we handle groups. */
    for ( int i = 0; i < size; i++ ) {
-      int          f;
-      tech_item_t *item = &tech->items[i];
+      const tech_item_t  *item = &tech->items[i];
+      const tech_group_t *grp;
+      void *const        *sub;
 
-      /* Only handle commodities for now. */
-      if ( item->type != type )
+      if ( item->type == type ) {
+         array_push_back( &items, item->u.ptr );
          continue;
-
-      /* Skip if already in list. */
-      f = 0;
-      for ( int j = 0; j < array_size( items ); j++ ) {
-         if ( items[j] == item->u.ptr ) {
-            f = 1;
-            break;
-         }
       }
-      if ( f == 1 )
+
+      if ( item->type == TECH_TYPE_GROUP )
+         grp = &tech_groups[item->u.grp];
+      else if ( item->type == TECH_TYPE_GROUP_POINTER )
+         grp = item->u.grpptr;
+      else
          continue;
+      sub = tech_getFlat( grp, type );
+      for ( int j = 0; j < array_size( sub ); j++ )
+         array_push_back( &items, sub[j] );
+   }
+   return items;
+}
 
-      /* Add. */
-      if ( items == NULL )
-         items = array_create( void * );
-      array_push_back( &items, item->u.ptr );
+/**
+ * @brief Gets the flattened items of a type in a tech group.
+ *
+ *    @param tech Tech group to get items from.
+ *    @param type Type of the items to get.
+ *    @return Array (array.h): Items sorted by pointer and without duplicates.
+ * Owned by the tech group.
+ */
+static void *const *tech_getFlat( const tech_group_t *tech,
+                                  tech_item_type_t    type )
+{
+   /* The cache is not part of the state of the group, so we can modify it. */
+   tech_group_t *grp = (tech_group_t *)tech;
+   void        **items;
+   int           n;
+
+   /* Throw away everything if anything changed. */
+   if ( grp->flat_gen != tech_gen ) {
+      for ( int i = 0; i < TECH_TYPE_FLAT; i++ ) {
+         array_free( grp->flat[i] );
+         grp->flat[i] = NULL;
+      }
+      grp->flat_gen = tech_gen;
    }
+   if ( grp->flat[type] != NULL )
+      return grp->flat[type];
+
+   /* Gather, sort and remove duplicates. */
+   items = tech_addGroupItem( array_create( void * ), type, grp );
+   qsort( items, array_size( items ), sizeof( void * ), tech_cmpPtr );
+   n = 0;
+   for ( int i = 0; i < array_size( items ); i++ )
+      if ( ( n == 0 ) || ( items[n - 1] != items[i] ) )
+         items[n++] = items[i];
+   array_resize( &items, n );
+   array_shrink( &items );
+
+   grp->flat[type] = items;
+   return items;
+}
 
-   /* Now handle other groups. */
-   for ( int i = 0; i < size; i++ ) {
-      tech_item_t *item = &tech->items[i];
+/**
+ * @brief Checks to see if a tech group has an item.
+ */
+static int tech_hasFlat( const tech_group_t *tech, tech_item_type_t type,
+                         const void *ptr )
+{
+   void *const *items;
+   if ( tech == NULL )
+      return 0;
+   items = tech_getFlat( tech, type );
+   return bsearch( &ptr, items, array_size( items ), sizeof( void * ),
+                   tech_cmpPtr ) != NULL;
+}
 
-      /* Only handle commodities for now. */
-      if ( item->type == TECH_TYPE_GROUP )
-         items = tech_addGroupItem( items, type, &tech_groups[item->u.grp] );
-      else if ( item->type == TECH_TYPE_GROUP_POINTER )
-         items = tech_addGroupItem( items, type, item->u.grpptr );
+/**
+ * @brief Gets a copy of the flattened items of a tech group.
+ *
+ *    @return Array (array.h): Copy of the items or NULL if there are none.
+ */
+static void **tech_copyFlat( const tech_group_t *tech, tech_item_type_t type )
+{
+   void *const *items = tech_getFlat( tech, type );
+   void       **copy;
+   int          n = array_size( items );
+   if ( n == 0 )
+      return NULL;
+   copy = array_create_size( void *, n );
+   array_resize( &copy, n );
+   memcpy( copy, items, n * sizeof( void * ) );
+   return copy;
+}
+
+/**
+ * @brief Gets the spobs that have an item in their tech group.
+ *
+ * The index is built for all the spobs and rebuilt only when the tech groups
+ * change.
+ *
+ *    @param type Type of the item.
+ *    @param ptr Item to look up.
+ *    @param[out] n Number of spobs found.
+ *    @return IDs of the spobs with the item, owned by the index.
+ */
+static const int *tech_getSpobs( tech_item_type_t type, const void *ptr,
+                                 int *n )
+{
+   const Spob        *spobs = spob_getAll();
+   const tech_spob_t *index;
+   int                lo, hi;
+
+   /* Rebuild if necessary. */
+   if ( ( tech_spob_gen != tech_gen ) ||
+        ( tech_spob_n != array_size( spobs ) ) ) {
+      for ( int t = 0; t < TECH_TYPE_FLAT; t++ ) {
+         tech_spob_t *ts    = &tech_spob_index[t];
+         tech_pair_t *pairs = array_create( tech_pair_t );
+         for ( int i = 0; i < array_size( spobs ); i++ ) {
+            void *const *items;
+            if ( spobs[i].tech == NULL )
+               continue;
+            items = tech_getFlat( spobs[i].tech, t );
+            for ( int j = 0; j < array_size( items ); j++ ) {
+               tech_pair_t pair = { .ptr = items[j], .spob = spobs[i].id };
+               array_push_back( &pairs, pair );
+            }
+         }
+         qsort( pairs, array_size( pairs ), sizeof( tech_pair_t ),
+                tech_cmpPair );
+
+         array_free( ts->items );
+         array_free( ts->spobs );
+         ts->items = array_create_size( const void *, array_size( pairs ) );
+         ts->spobs = array_create_size( int, array_size( pairs ) );
+         for ( int i = 0; i < array_size( pairs ); i++ ) {
+            array_push_back( &ts->items, pairs[i].ptr );
+            array_push_back( &ts->spobs, pairs[i].spob );
+         }
+         array_free( pairs );
+      }
+      tech_spob_gen = tech_gen;
+      tech_spob_n   = array_size( spobs );
    }
 
-   return items;
+   /* Find the range of entries of the item. */
+   index = &tech_spob_index[type];
+   lo    = 0;
+   hi    = array_size( index->items );
+   while ( lo < hi ) {
+      int mid = ( lo + hi ) / 2;
+      if ( index->items[mid] < ptr )
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   for ( hi = lo;
+         ( hi < array_size( index->items ) ) && ( index->items[hi] == ptr );
+         hi++ )
+      ;
+   *n = hi - lo;
+   return ( *n > 0 ) ? &index->spobs[lo] : NULL;
 }
 
 /**
@@ -685,45 +900,6 @@ int tech_hasItem( const tech_group_t *tech, const char *item )
    return 0;
 }
 
-static int tech_hasItemInternal( const tech_group_t *tech,
-                                 const tech_item_t  *item )
-{
-   if ( tech == NULL )
-      return 0;
-   int s = array_size( tech->items );
-   for ( int i = 0; i < s; i++ ) {
-      const tech_item_t *itemi = &tech->items[i];
-
-      if ( item->type == itemi->type ) {
-         switch ( item->type ) {
-         case TECH_TYPE_OUTFIT:
-            if ( item->u.outfit == itemi->u.outfit )
-               return 1;
-            break;
-         case TECH_TYPE_SHIP:
-            if ( item->u.ship == itemi->u.ship )
-               return 1;
-            break;
-         case TECH_TYPE_COMMODITY:
-            if ( item->u.comm == itemi->u.comm )
-               return 1;
-            break;
-         default:
-            break;
-         }
-      }
-
-      if ( itemi->type == TECH_TYPE_GROUP ) {
-         if ( tech_hasItemInternal( &tech_groups[itemi->u.grp], item ) )
-            return 1;
-      } else if ( itemi->type == TECH_TYPE_GROUP_POINTER ) {
-         if ( tech_hasItemInternal( itemi->u.grpptr, item ) )
-            return 1;
-      }
-   }
-   return 0;
-}
-
 /**
  * @brief Checks to see whether a tech group contains a ship.
  *
@@ -733,11 +909,7 @@ static int tech_hasItemInternal( const tech_group_t *tech,
  */
 int tech_hasShip( const tech_group_t *tech, const Ship *ship )
 {
-   const tech_item_t item = {
-      .type   = TECH_TYPE_SHIP,
-      .u.ship = ship,
-   };
-   return tech_hasItemInternal( tech, &item );
+   return tech_hasFlat( tech, TECH_TYPE_SHIP, ship );
 }
 
 /**
@@ -749,11 +921,7 @@ int tech_hasShip( const tech_group_t *tech, const Ship *ship )
  */
 int tech_hasOutfit( const tech_group_t *tech, const Outfit *outfit )
 {
-   const tech_item_t item = {
-      .type     = TECH_TYPE_OUTFIT,
-      .u.outfit = outfit,
-   };
-   return tech_hasItemInternal( tech, &item );
+   return tech_hasFlat( tech, TECH_TYPE_OUTFIT, outfit );
 }
 
 /**
@@ -765,11 +933,7 @@ int tech_hasOutfit( const tech_group_t *tech, const Outfit *outfit )
  */
 int tech_hasCommodity( const tech_group_t *tech, const Commodity *comm )
 {
-   const tech_item_t item = {
-      .type   = TECH_TYPE_COMMODITY,
-      .u.comm = comm,
-   };
-   return tech_hasItemInternal( tech, &item );
+   return tech_hasFlat( tech, TECH_TYPE_COMMODITY, comm );
 }
 
 /**
@@ -838,7 +1002,7 @@ Outfit **tech_getOutfit( const tech_group_t *tech )
    if ( tech == NULL )
       return NULL;
 
-   o = (Outfit **)tech_addGroupItem( NULL, TECH_TYPE_OUTFIT, tech );
+   o = (Outfit **)tech_copyFlat( tech, TECH_TYPE_OUTFIT );
 
    /* Sort. */
    if ( o != NULL )
@@ -886,8 +1050,8 @@ Ship **tech_getShip( const tech_group_t *tech )
    if ( tech == NULL )
       return NULL;
 
-   /* Get the outfits. */
-   s = (Ship **)tech_addGroupItem( NULL, TECH_TYPE_SHIP, tech );
+   /* Get the ships. */
+   s = (Ship **)tech_copyFlat( tech, TECH_TYPE_SHIP );
 
    /* Sort. */
    if ( s != NULL )
@@ -960,7 +1124,7 @@ Commodity **tech_getCommodity( const tech_group_t *tech )
       return NULL;
 
    /* Get the commodities. */
-   c = (Commodity **)tech_addGroupItem( NULL, TECH_TYPE_COMMODITY, tech );
+   c = (Commodity **)tech_copyFlat( tech, TECH_TYPE_COMMODITY );
 
    /* Sort. */
    if ( c != NULL )
@@ -974,13 +1138,47 @@ Commodity **tech_getCommodity( const tech_group_t *tech )
  */
 int tech_checkOutfit( const tech_group_t *tech, const Outfit *o )
 {
-   Outfit **to = tech_getOutfit( tech );
-   for ( int i = 0; i < array_size( to ); i++ ) {
-      if ( to[i] == o ) {
-         array_free( to );
-         return 1;
-      }
-   }
-   array_free( to );
-   return 0;
+   return tech_hasOutfit( tech, o );
+}
+
+/**
+ * @brief Gets the spobs that have an outfit in their tech group.
+ *
+ * @note Services of the spobs are not checked.
+ *
+ *    @param o Outfit to look for.
+ *    @param[out] n Number of spobs found.
+ *    @return IDs of the spobs found (not to be freed), or NULL if none.
+ */
+const int *tech_getSpobsOutfit( const Outfit *o, int *n )
+{
+   return tech_getSpobs( TECH_TYPE_OUTFIT, o, n );
+}
+
+/**
+ * @brief Gets the spobs that have a ship in their tech group.
+ *
+ * @note Services of the spobs are not checked.
+ *
+ *    @param s Ship to look for.
+ *    @param[out] n Number of spobs found.
+ *    @return IDs of the spobs found (not to be freed), or NULL if none.
+ */
+const int *tech_getSpobsShip( const Ship *s, int *n )
+{
+   return tech_getSpobs( TECH_TYPE_SHIP, s, n );
+}
+
+/**
+ * @brief Gets the spobs that have a commodity in their tech group.
+ *
+ * @note Services of the spobs are not checked.
+ *
+ *    @param c Commodity to look for.
+ *    @param[out] n Number of spobs found.
+ *    @return IDs of the spobs found (not to be freed), or NULL if none.
+ */
+const int *tech_getSpobsCommodity( const Commodity *c, int *n )
+{
+   return tech_getSpobs( TECH_TYPE_COMMODITY, c, n );
 }
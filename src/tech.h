@@ -57,3 +57,10 @@ Commodity **tech_getCommodityArray( tech_group_t **tech, int num );
  * Check.
  */
 int tech_checkOutfit( const tech_group_t *tech, const Outfit *o );
+
+/*
+ * Reverse lookup.
+ */
+const int *tech_getSpobsOutfit( const Outfit *o, int *n );
+const int *tech_getSpobsShip( const Ship *s, int *n );
+const int *tech_getSpobsCommodity( const Commodity *c, int *n );
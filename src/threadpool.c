@@ -29,6 +29,8 @@
 
 #include "SDL_cpuinfo.h"
 #include "SDL_thread.h"
+
+#include "naev.h"
 /** @endcond */
 
 #include "threadpool.h"
@@ -74,6 +76,7 @@ struct ThreadQueue_ {
    SDL_mutex               *mutex;
    struct vpoolThreadData_ *arg;
    int                      cnt;
+   int started; /**< Whether the jobs have been launched by vpool_start. */
 };
 
 /**
@@ -110,9 +113,25 @@ struct vpoolThreadData_ {
 };
 typedef struct vpoolThreadData_ vpoolThreadData;
 
+/**
+ * @brief A chunk of a range being processed by vpool_parallel.
+ */
+typedef struct vpoolRange_ {
+   void ( *function )( int start, int end,
+                       void *data ); /**< Function to run on the chunk. */
+   void *data;                       /**< User data for the function. */
+   int   start;                      /**< First index of the chunk. */
+   int   end;                        /**< One past the last index. */
+} vpoolRange;
+
 /* The global threadpool queue */
 static ThreadQueue *global_queue = NULL;
 
+/* Reused vpool for per-frame parallel ranges. */
+static ThreadQueue *range_queue = NULL; /**< Queue for vpool_parallel. */
+static vpoolRange  *range_data =
+   NULL; /**< Chunks for vpool_parallel (array.h). */
+
 /*
  * Prototypes.
  */
@@ -123,6 +142,7 @@ static void         tq_destroy( ThreadQueue *q );
 static int          threadpool_worker( void *data );
 static int          threadpool_handler( void *data );
 static int          vpool_worker( void *data );
+static int          vpool_rangeWorker( void *data );
 
 /**
  * @brief Creates a concurrent queue.
@@ -491,9 +511,28 @@ int threadpool_init( void )
       return -1;
    }
 
+   /* Queue used for the per-frame parallel ranges. */
+   range_queue = vpool_create();
+   range_data  = array_create( vpoolRange );
+
    return 0;
 }
 
+/**
+ * @brief Frees what the threadpool uses for the parallel ranges.
+ *
+ * The worker threads are left running, so vpool_parallel() falls back to
+ *  running on the calling thread afterwards.
+ */
+void threadpool_exit( void )
+{
+   if ( range_queue != NULL )
+      vpool_cleanup( range_queue );
+   range_queue = NULL;
+   array_free( range_data );
+   range_data = NULL;
+}
+
 /**
  * @brief Creates a new vpool queue.
  *
@@ -565,17 +604,19 @@ static int vpool_worker( void *data )
    return 0;
 }
 
-/* @brief Run every job in the vpool queue and block until every job in the
- *        queue is done.
+/**
+ * @brief Runs every job in the vpool queue without waiting for them to be
+ *        done.
  *
- * @note It destroys the queue when it's done.
+ * The calling thread is free to do other work in the meantime, but must call
+ * vpool_wait before enqueueing more jobs in the queue.
  */
-void vpool_wait( ThreadQueue *queue )
+void vpool_start( ThreadQueue *queue )
 {
-   /* Number of tasks we have. */
    int cnt;
-   queue->cnt = array_size( queue->arg );
-   cnt        = queue->cnt;
+
+   if ( queue->started )
+      return;
 
    if ( global_queue == NULL ) {
       WARN( _( "Threadpool has not been initialized yet!" ) );
@@ -583,11 +624,12 @@ void vpool_wait( ThreadQueue *queue )
    }
 
    /* Nothing to do. */
+   cnt = array_size( queue->arg );
    if ( cnt <= 0 )
       return;
 
-   /* Allocate all vpoolThreadData objects */
    SDL_mutexP( queue->mutex );
+   queue->cnt = cnt;
    /* Initialize the vpoolThreadData */
    for ( int i = 0; i < cnt; i++ ) {
       vpoolThreadData *arg;
@@ -601,10 +643,27 @@ void vpool_wait( ThreadQueue *queue )
       arg->wrapper.data = arg;
       tq_enqueue( global_queue, &queue->arg[i].wrapper );
    }
+   queue->started = 1;
+   SDL_mutexV( queue->mutex );
+}
+
+/* @brief Run every job in the vpool queue and block until every job in the
+ *        queue is done.
+ *
+ * Jobs already launched with vpool_start are only waited for.
+ */
+void vpool_wait( ThreadQueue *queue )
+{
+   vpool_start( queue );
+   if ( !queue->started )
+      return;
 
-   /* Wait for the threads to finish */
-   SDL_CondWait( queue->cond, queue->mutex );
+   /* Wait for the threads to finish, guarding against spurious wakeups. */
+   SDL_mutexP( queue->mutex );
+   while ( queue->cnt > 0 )
+      SDL_CondWait( queue->cond, queue->mutex );
    SDL_mutexV( queue->mutex );
+   queue->started = 0;
 
    /* Can toss away all the queue stuff. */
    array_erase( &queue->arg, array_begin( queue->arg ),
@@ -619,3 +678,61 @@ void vpool_cleanup( ThreadQueue *queue )
    /* Clean up */
    tq_destroy( queue );
 }
+
+/**
+ * @brief Runs a chunk of a vpool_parallel range.
+ */
+static int vpool_rangeWorker( void *data )
+{
+   const vpoolRange *r = (const vpoolRange *)data;
+   r->function( r->start, r->end, r->data );
+   return 0;
+}
+
+/**
+ * @brief Runs a function over a range of indices in parallel.
+ *
+ * The range [0,n) is split into at most one contiguous chunk per worker
+ * thread, each chunk being at least grain elements long. The function must
+ * only modify the elements in the chunk it is given, which makes the result
+ * independent of how the range gets split. If the range is too small to be
+ * worth splitting, the function is run directly on the calling thread.
+ *
+ * @note Not reentrant: only call from the main thread and never from inside
+ *       another vpool job.
+ *
+ *    @param n Number of elements in the range.
+ *    @param grain Minimum number of elements per chunk.
+ *    @param function Function to run on each chunk.
+ *    @param data User data passed to the function.
+ */
+void vpool_parallel( int n, int grain,
+                     void ( *function )( int start, int end, void *data ),
+                     void *data )
+{
+   int nchunks;
+
+   if ( n <= 0 )
+      return;
+
+   /* Figure out how many chunks to use. */
+   grain   = MAX( grain, 1 );
+   nchunks = MIN( MAXTHREADS - 1, ( n + grain - 1 ) / grain );
+   if ( ( nchunks <= 1 ) || ( range_queue == NULL ) ) {
+      function( 0, n, data );
+      return;
+   }
+
+   /* Set up all the chunks before enqueueing, as resizing moves them. */
+   array_resize( &range_data, nchunks );
+   for ( int i = 0; i < nchunks; i++ ) {
+      vpoolRange *r = &range_data[i];
+      r->function   = function;
+      r->data       = data;
+      r->start      = (int)( (long long)n * i / nchunks );
+      r->end        = (int)( (long long)n * ( i + 1 ) / nchunks );
+   }
+   for ( int i = 0; i < nchunks; i++ )
+      vpool_enqueue( range_queue, vpool_rangeWorker, &range_data[i] );
+   vpool_wait( range_queue );
+}
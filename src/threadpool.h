@@ -20,6 +20,9 @@ typedef struct ThreadQueue_ ThreadQueue;
 /* Initializes the threadpool */
 int threadpool_init( void );
 
+/* Frees the threadpool memory that can be freed. */
+void threadpool_exit( void );
+
 /* Creates a new vpool queue. Destroy with vpool_wait. */
 ThreadQueue *vpool_create( void );
 
@@ -29,9 +32,20 @@ ThreadQueue *vpool_create( void );
 void vpool_enqueue( ThreadQueue *queue, int ( *function )( void * ),
                     void        *data );
 
+/* Run every job in the vpool queue without blocking. Finish with vpool_wait
+ * before enqueueing more jobs. */
+void vpool_start( ThreadQueue *queue );
+
 /* Run every job in the vpool queue and block until every job in the queue is
  * done. */
 void vpool_wait( ThreadQueue *queue );
 
 /* Clean up. */
 void vpool_cleanup( ThreadQueue *queue );
+
+/* Runs a function over the index range [0,n) split into chunks on the
+ * threadpool and blocks until every chunk is done. Only to be used from the
+ * main thread for data-parallel work that touches disjoint elements. */
+void vpool_parallel( int n, int grain,
+                     void ( *function )( int start, int end, void *data ),
+                     void *data );
@@ -43,13 +43,26 @@ typedef struct UniDiff_ {
 /*
  * Diff stack.
  */
-static UniDiff_t *diff_stack = NULL; /**< Currently applied universe diffs. */
+static UniDiff_t   *diff_stack = NULL; /**< Currently applied universe diffs. */
+static unsigned int diff_gen =
+   0; /**< Bumped every time a diff is applied or removed. */
+
+/* Parts of the universe that have to be updated after patching. */
+#define DIFF_DIRTY_JUMPS ( 1 << 0 )    /**< Jumps changed. */
+#define DIFF_DIRTY_PRESENCE ( 1 << 1 ) /**< Presence has to be recomputed. */
+#define DIFF_DIRTY_LANES ( 1 << 2 )    /**< Safe lanes have to be recomputed. */
+#define DIFF_DIRTY_ECONOMY ( 1 << 3 )  /**< Economy has to be recomputed. */
+#define DIFF_DIRTY_NAV ( 1 << 4 )      /**< Current system layout changed. */
 
 /* Useful variables. */
-static int diff_universe_changed =
-   0; /**< Whether or not the universe changed. */
-static int         diff_universe_defer = 0; /**< Defers changes to later. */
-static const char *diff_nav_spob =
+static unsigned int diff_universe_changed =
+   0; /**< What parts of the universe changed. */
+static StarSystem **diff_dirty_sys =
+   NULL; /**< Array (array.h): Systems whose jumps changed. */
+static Spob **diff_dirty_spob =
+   NULL; /**< Array (array.h): Spobs whose graphics have to be reloaded. */
+static int          diff_universe_defer = 0; /**< Defers changes to later. */
+static const char  *diff_nav_spob =
    NULL; /**< Stores the player's spob target if necessary. */
 static const char *diff_nav_hyperspace =
    NULL; /**< Stores the player's hyperspace target if necessary. */
@@ -456,7 +469,11 @@ static void        diff_hunkFailed( UniDiff_t *diff, const UniHunk_t *hunk );
 static void        diff_hunkSuccess( UniDiff_t *diff, const UniHunk_t *hunk );
 static void        diff_cleanup( UniDiff_t *diff );
 /* Misc. */
-static int diff_checkUpdateUniverse( void );
+static void diff_dirtySystem( const StarSystem *sys, unsigned int flags );
+static void diff_dirtyJump( StarSystem *sys, StarSystem *target );
+static void diff_dirtySpob( Spob *p );
+static void diff_dirtyClear( void );
+static int  diff_checkUpdateUniverse( void );
 /* Externed. */
 int diff_save( xmlTextWriterPtr writer ); /**< Used in save.c */
 int diff_load( xmlNodePtr parent );       /**< Used in save.c */
@@ -560,6 +577,7 @@ void diff_freeData( UniDiffData_t *diff )
 void diff_exit( void )
 {
    diff_clear();
+   diff_dirtyClear();
    for ( int i = 0; i < array_size( diff_available ); i++ ) {
       UniDiffData_t *d = &diff_available[i];
       diff_freeData( d );
@@ -635,6 +653,19 @@ int diff_isApplied( const char *name )
    return 0;
 }
 
+/**
+ * @brief Gets the current diff generation.
+ *
+ * The generation changes every time a diff is applied or removed, so it can be
+ * used to invalidate anything derived from the state of the universe.
+ *
+ *    @return The current diff generation.
+ */
+unsigned int diff_generation( void )
+{
+   return diff_gen;
+}
+
 /**
  * @brief Gets a diff by name.
  *
@@ -689,7 +720,7 @@ static int diff_applyInternal( const char *name, int oneshot )
 
    /* Reset change variable. */
    if ( oneshot && !diff_universe_defer )
-      diff_universe_changed = 0;
+      diff_dirtyClear();
 
    const UniDiffData_t q = { .name = (char *)name };
    d = bsearch( &q, diff_available, array_size( diff_available ),
@@ -772,6 +803,8 @@ static int diff_applyInternal( const char *name, int oneshot )
       }
    }
 
+   diff_gen++;
+
    /* Update overlay map just in case. */
    ovr_refresh();
 
@@ -787,7 +820,7 @@ static int diff_applyInternal( const char *name, int oneshot )
  */
 void diff_start( void )
 {
-   diff_universe_changed = 0;
+   diff_dirtyClear();
 }
 
 /**
@@ -1148,20 +1181,26 @@ int diff_patchHunk( UniHunk_t *hunk )
       if ( p == NULL )
          return -1;
       spob_luaInit( p );
-      diff_universe_changed = 1;
+      diff_dirtySystem( ssys, DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES |
+                                 DIFF_DIRTY_ECONOMY );
       return system_addSpob( ssys, hunk->u.name );
    /* Removing an spob. */
    case HUNK_TYPE_SPOB_REMOVE:
-      diff_universe_changed = 1;
+      p = spob_get( hunk->u.name );
+      /* Won't be reloaded with the current system anymore, so unload now. */
+      if ( ( p != NULL ) && ( ssys == cur_system ) )
+         spob_gfxUnload( p );
+      diff_dirtySystem( ssys, DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES |
+                                 DIFF_DIRTY_ECONOMY );
       return system_rmSpob( ssys, hunk->u.name );
 
    /* Adding a virtual spob. */
    case HUNK_TYPE_VSPOB_ADD:
-      diff_universe_changed = 1;
+      diff_universe_changed |= DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES;
       return system_addVirtualSpob( ssys, hunk->u.name );
    /* Removing a virtual spob. */
    case HUNK_TYPE_VSPOB_REMOVE:
-      diff_universe_changed = 1;
+      diff_universe_changed |= DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES;
       return system_rmVirtualSpob( ssys, hunk->u.name );
 
    /* Adding a jump. */
@@ -1169,7 +1208,7 @@ int diff_patchHunk( UniHunk_t *hunk )
       ssys2 = system_get( hunk->u.name );
       if ( ssys2 == NULL )
          return -1;
-      diff_universe_changed = 1;
+      diff_dirtyJump( ssys, ssys2 );
       if ( system_addJump( ssys, ssys2 ) )
          return -1;
       if ( system_addJump( ssys2, ssys ) )
@@ -1180,7 +1219,7 @@ int diff_patchHunk( UniHunk_t *hunk )
       ssys2 = system_get( hunk->u.name );
       if ( ssys2 == NULL )
          return -1;
-      diff_universe_changed = 1;
+      diff_dirtyJump( ssys, ssys2 );
       if ( system_rmJump( ssys, ssys2 ) )
          return -1;
       if ( system_rmJump( ssys2, ssys ) )
@@ -1537,14 +1576,16 @@ int diff_patchHunk( UniHunk_t *hunk )
          hunk->o.name = NULL;
       else
          hunk->o.name = faction_name( p->presence.faction );
-      diff_universe_changed = 1;
+      diff_universe_changed |=
+         DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES | DIFF_DIRTY_ECONOMY;
       /* Special case to clear the faction. */
       if ( strcasecmp( hunk->u.name, "None" ) == 0 )
          return spob_setFaction( p, -1 );
       else
          return spob_setFaction( p, faction_get( hunk->u.name ) );
    case HUNK_TYPE_SPOB_FACTION_REVERT:
-      diff_universe_changed = 1;
+      diff_universe_changed |=
+         DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES | DIFF_DIRTY_ECONOMY;
       if ( hunk->o.name == NULL )
          return spob_setFaction( p, -1 );
       else
@@ -1552,31 +1593,34 @@ int diff_patchHunk( UniHunk_t *hunk )
 
    /* Presence stuff. */
    case HUNK_TYPE_SPOB_PRESENCE_BASE:
-      diff_universe_changed = 1;
-      hunk->o.fdata         = p->presence.base;
-      p->presence.base      = hunk->u.fdata;
+      diff_universe_changed |= DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES;
+      hunk->o.fdata    = p->presence.base;
+      p->presence.base = hunk->u.fdata;
       return 0;
    case HUNK_TYPE_SPOB_PRESENCE_BASE_REVERT:
-      diff_universe_changed = 1;
-      p->presence.base      = hunk->o.fdata;
+      diff_universe_changed |= DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES;
+      p->presence.base = hunk->o.fdata;
       return 0;
    case HUNK_TYPE_SPOB_PRESENCE_BONUS:
-      diff_universe_changed = 1;
-      hunk->o.fdata         = p->presence.bonus;
-      p->presence.bonus     = hunk->u.fdata;
+      diff_universe_changed |= DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES;
+      hunk->o.fdata     = p->presence.bonus;
+      p->presence.bonus = hunk->u.fdata;
       return 0;
    case HUNK_TYPE_SPOB_PRESENCE_BONUS_REVERT:
-      diff_universe_changed = 1;
-      p->presence.bonus     = hunk->o.fdata;
+      diff_universe_changed |= DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES;
+      p->presence.bonus = hunk->o.fdata;
       return 0;
    case HUNK_TYPE_SPOB_PRESENCE_RANGE:
-      diff_universe_changed = 1;
-      hunk->o.data          = p->presence.range;
-      p->presence.range     = hunk->u.data;
+      /* Range is also used for commodity prices. */
+      diff_universe_changed |=
+         DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES | DIFF_DIRTY_ECONOMY;
+      hunk->o.data      = p->presence.range;
+      p->presence.range = hunk->u.data;
       return 0;
    case HUNK_TYPE_SPOB_PRESENCE_RANGE_REVERT:
-      diff_universe_changed = 1;
-      p->presence.range     = hunk->o.data;
+      diff_universe_changed |=
+         DIFF_DIRTY_PRESENCE | DIFF_DIRTY_LANES | DIFF_DIRTY_ECONOMY;
+      p->presence.range = hunk->o.data;
       return 0;
 
    /* Changing spob hide. */
@@ -1632,7 +1676,7 @@ int diff_patchHunk( UniHunk_t *hunk )
       if ( spob_hasService( p, a ) )
          return -1;
       spob_addService( p, a );
-      diff_universe_changed = 1;
+      diff_universe_changed |= DIFF_DIRTY_ECONOMY;
       return 0;
    case HUNK_TYPE_SPOB_SERVICE_REMOVE:
       a = spob_getService( hunk->u.name );
@@ -1641,7 +1685,7 @@ int diff_patchHunk( UniHunk_t *hunk )
       if ( !spob_hasService( p, a ) )
          return -1;
       spob_rmService( p, a );
-      diff_universe_changed = 1;
+      diff_universe_changed |= DIFF_DIRTY_ECONOMY;
       return 0;
 
    /* Modifying mission spawn. */
@@ -1688,13 +1732,13 @@ int diff_patchHunk( UniHunk_t *hunk )
 
    /* Changing spob space graphics. */
    case HUNK_TYPE_SPOB_SPACE:
-      hunk->o.name          = p->gfx_spaceName;
-      p->gfx_spaceName      = hunk->u.name;
-      diff_universe_changed = 1;
+      hunk->o.name     = p->gfx_spaceName;
+      p->gfx_spaceName = hunk->u.name;
+      diff_dirtySpob( p );
       return 0;
    case HUNK_TYPE_SPOB_SPACE_REVERT:
-      p->gfx_spaceName      = (char *)hunk->o.name;
-      diff_universe_changed = 1;
+      p->gfx_spaceName = (char *)hunk->o.name;
+      diff_dirtySpob( p );
       return 0;
 
    /* Changing spob exterior graphics. */
@@ -1711,12 +1755,12 @@ int diff_patchHunk( UniHunk_t *hunk )
       hunk->o.name = p->lua_file;
       p->lua_file  = hunk->u.name;
       spob_luaInit( p );
-      diff_universe_changed = 1;
+      diff_dirtySpob( p );
       return 0;
    case HUNK_TYPE_SPOB_LUA_REVERT:
       p->lua_file = (char *)hunk->o.name;
       spob_luaInit( p );
-      diff_universe_changed = 1;
+      diff_dirtySpob( p );
       return 0;
 
    /* Making a faction visible. */
@@ -1897,6 +1941,7 @@ static int diff_removeDiff( UniDiff_t *diff )
 
    diff_cleanup( diff );
    array_erase( &diff_stack, diff, &diff[1] );
+   diff_gen++;
    return 0;
 }
 
@@ -1982,10 +2027,10 @@ int diff_load( xmlNodePtr parent )
    int        defer = diff_universe_defer;
 
    /* Don't update universe here. */
-   diff_universe_defer   = 1;
-   diff_universe_changed = 0;
-   diff_nav_spob         = NULL;
-   diff_nav_hyperspace   = NULL;
+   diff_universe_defer = 1;
+   diff_nav_spob       = NULL;
+   diff_nav_hyperspace = NULL;
+   diff_dirtyClear();
    diff_clear();
    diff_universe_defer = defer;
 
@@ -2014,30 +2059,111 @@ int diff_load( xmlNodePtr parent )
    return 0;
 }
 
+/**
+ * @brief Marks a system as changed.
+ *
+ *    @param sys System that changed.
+ *    @param flags Parts of the universe that have to be updated.
+ */
+static void diff_dirtySystem( const StarSystem *sys, unsigned int flags )
+{
+   diff_universe_changed |= flags;
+   if ( ( sys != NULL ) && ( sys == cur_system ) )
+      diff_universe_changed |= DIFF_DIRTY_NAV;
+}
+
+/**
+ * @brief Marks a jump between two systems as changed.
+ *
+ *    @param sys System the jump is in.
+ *    @param target Target system of the jump.
+ */
+static void diff_dirtyJump( StarSystem *sys, StarSystem *target )
+{
+   if ( diff_dirty_sys == NULL )
+      diff_dirty_sys = array_create( StarSystem * );
+   array_push_back( &diff_dirty_sys, sys );
+   array_push_back( &diff_dirty_sys, target );
+   diff_dirtySystem( sys, DIFF_DIRTY_JUMPS | DIFF_DIRTY_PRESENCE |
+                             DIFF_DIRTY_LANES | DIFF_DIRTY_ECONOMY );
+   diff_dirtySystem( target, 0 );
+}
+
+/**
+ * @brief Marks the graphics of a spob as changed.
+ *
+ *    @param p Spob to reload the graphics of.
+ */
+static void diff_dirtySpob( Spob *p )
+{
+   for ( int i = 0; i < array_size( diff_dirty_spob ); i++ )
+      if ( diff_dirty_spob[i] == p )
+         return;
+   if ( diff_dirty_spob == NULL )
+      diff_dirty_spob = array_create( Spob * );
+   array_push_back( &diff_dirty_spob, p );
+}
+
+/**
+ * @brief Clears all the changes that are pending to be updated.
+ */
+static void diff_dirtyClear( void )
+{
+   diff_universe_changed = 0;
+   array_free( diff_dirty_sys );
+   diff_dirty_sys = NULL;
+   array_free( diff_dirty_spob );
+   diff_dirty_spob = NULL;
+}
+
 /**
  * @brief Checks and updates the universe if necessary.
+ *
+ * Only the parts of the universe that were touched by the patched hunks are
+ * updated, as recomputing the safe lanes in particular is very slow.
  */
 static int diff_checkUpdateUniverse( void )
 {
    Pilot *const *pilots;
 
-   if ( !diff_universe_changed || diff_universe_defer )
+   if ( diff_universe_defer )
+      return 0;
+   if ( !diff_universe_changed && ( array_size( diff_dirty_spob ) == 0 ) )
       return 0;
 
-   /* Reconstruct jumps just in case. */
-   systems_reconstructJumps();
+   /* Reconstruct jumps of the systems that changed. */
+   if ( diff_universe_changed & DIFF_DIRTY_JUMPS )
+      systems_reconstructJumpsSet( diff_dirty_sys );
    /* Update presences, then safelanes. */
-   space_reconstructPresences();
-   safelanes_recalculate();
+   if ( diff_universe_changed & DIFF_DIRTY_PRESENCE )
+      space_reconstructPresences();
+   if ( diff_universe_changed & DIFF_DIRTY_LANES )
+      safelanes_recalculate();
 
    /* Re-compute the economy. */
    economy_execQueued();
-   economy_initialiseCommodityPrices();
+   if ( diff_universe_changed & DIFF_DIRTY_ECONOMY )
+      economy_initialiseCommodityPrices();
 
-   /* Have to update planet graphics if necessary. */
+   /* Have to update spob graphics if necessary. */
    if ( cur_system != NULL ) {
-      space_gfxUnload( cur_system );
-      space_gfxLoad( cur_system );
+      for ( int i = 0; i < array_size( diff_dirty_spob ); i++ ) {
+         Spob *spob = diff_dirty_spob[i];
+         /* Only spobs in the current system were loaded. */
+         for ( int j = 0; j < array_size( cur_system->spobs ); j++ ) {
+            if ( cur_system->spobs[j] == spob ) {
+               spob_gfxUnload( spob );
+               spob_gfxLoad( spob );
+               break;
+            }
+         }
+      }
+   }
+
+   /* Targets only have to be fixed if the current system changed. */
+   if ( !( diff_universe_changed & DIFF_DIRTY_NAV ) ) {
+      diff_dirtyClear();
+      return 1;
    }
 
    /* Have to pilot targetting just in case. */
@@ -2095,7 +2221,7 @@ static int diff_checkUpdateUniverse( void )
    } else
       player_targetHyperspaceSet( -1, 0 );
 
-   diff_universe_changed = 0;
+   diff_dirtyClear();
    return 1;
 }
 
@@ -190,6 +190,7 @@ typedef struct UniDiffData_ {
 int  diff_init( void );
 void diff_exit( void );
 NONNULL( 1 ) int diff_isApplied( const char *name );
+unsigned int     diff_generation( void );
 NONNULL( 1 ) int diff_apply( const char *name );
 NONNULL( 1 ) void diff_remove( const char *name );
 void diff_clear( void );
@@ -10,6 +10,7 @@
  * on the outfit that created them.
  */
 /** @cond */
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
 
@@ -38,6 +39,10 @@
 #include "rng.h"
 #include "sound.h"
 #include "spfx.h"
+#include "threadpool.h"
+
+#define WEAPON_UPDATE_GRAIN                                                    \
+   256 /**< Minimum amount of weapons moved per thread. */
 
 /**
  * @brief Struct useful for generalization of weapno collisions.
@@ -68,9 +73,20 @@ typedef struct WeaponHit_ {
       *pos; /* Location of the hit, can be 2d array in the case of beams. */
 } WeaponHit;
 
+#define WEAPON_SLOT_BITS 18 /**< Bits of a weapon ID used for the slot. */
+#define WEAPON_SLOT_MASK                                                       \
+   ( ( 1U << WEAPON_SLOT_BITS ) - 1 ) /**< Mask of the slot in an ID. */
+#define WEAPON_GEN_MAX                                                         \
+   ( UINT_MAX >> WEAPON_SLOT_BITS ) /**< Maximum generation of a slot. */
+
 /* Weapon layers. */
 static Weapon *weapon_stack =
-   NULL; /**< All the weapon munitions are piled up here. */
+   NULL; /**< All the weapon munitions are piled up here. Slots never move, so
+            their positions can be used as handles. */
+static int *weapon_active   = NULL; /**< Slots in use, in order of creation. */
+static int *weapon_freelist = NULL; /**< Slots that can be reused. */
+static unsigned int *weapon_gen =
+   NULL; /**< Generation of each slot, incremented when reused. */
 
 /* Graphics. */
 static gl_vbo  *weapon_vbo     = NULL; /**< Weapon VBO. */
@@ -78,7 +94,6 @@ static GLfloat *weapon_vboData = NULL; /**< Data of weapon VBO. */
 static size_t   weapon_vboSize = 0;    /**< Size of the VBO. */
 
 /* Internal stuff. */
-static unsigned int weapon_idgen = 0; /**< Weapon identifier generator. */
 static int      qt_init = 0; /**< Whether or not the quadtree was created. */
 static Quadtree weapon_quadtree; /**< Quadtree for weapons. */
 static IntList  weapon_qtquery;  /**< For querying collisions. */
@@ -88,6 +103,7 @@ static IntList  weapon_qtexp; /**< For querying collisions from explosions. */
  * Prototypes
  */
 /* Creation. */
+static Weapon *weapon_alloc( void );
 static void   weapon_updateVBO( void );
 static double weapon_aimTurretAngle( const Outfit *outfit, const Pilot *parent,
                                      const Target *target, const vec2 *pos,
@@ -114,6 +130,7 @@ static double weapon_computeTimes( double rdir, double rx, double ry,
 static void weapon_render( Weapon *w, double dt );
 static void weapon_updateCollide( Weapon *w, double dt );
 static void weapon_update( Weapon *w, double dt );
+static void weapons_updateRange( int start, int end, void *data );
 static void weapon_sample_trail( Weapon *w );
 /* Destruction. */
 static void weapon_destroy( Weapon *w );
@@ -143,19 +160,56 @@ static void weapon_setTurn( Weapon *w, double turn );
  */
 void weapon_init( void )
 {
-   weapon_stack = array_create( Weapon );
+   weapon_stack    = array_create( Weapon );
+   weapon_active   = array_create( int );
+   weapon_freelist = array_create( int );
+   weapon_gen      = array_create( unsigned int );
    il_create( &weapon_qtquery, 1 );
    il_create( &weapon_qtexp, 1 );
 }
 
 /**
  * @brief Gets the weapon stack. Do not manipulate directly.
+ *
+ * Unused slots are marked as destroyed.
  */
 Weapon *weapon_getStack( void )
 {
    return weapon_stack;
 }
 
+/**
+ * @brief Gets a free weapon slot, reusing old ones if possible.
+ *
+ * The slot gets a new generation, so IDs of the previous weapon in the slot
+ * become invalid.
+ *
+ *    @return The new weapon to set up or NULL if out of slots.
+ */
+static Weapon *weapon_alloc( void )
+{
+   int slot;
+   int n = array_size( weapon_freelist );
+
+   if ( n > 0 ) {
+      slot = weapon_freelist[n - 1];
+      array_resize( &weapon_freelist, n - 1 );
+   } else {
+      slot = array_size( weapon_stack );
+      if ( (unsigned int)slot > WEAPON_SLOT_MASK ) {
+         WARN( _( "Too many weapons, unable to create more!" ) );
+         return NULL;
+      }
+      array_resize( &weapon_stack, slot + 1 );
+      array_push_back( &weapon_gen, 0 );
+   }
+
+   /* Generation 0 is skipped so 0 is never a valid ID. */
+   weapon_gen[slot] = weapon_gen[slot] % WEAPON_GEN_MAX + 1;
+   array_push_back( &weapon_active, slot );
+   return &weapon_stack[slot];
+}
+
 /**
  * @brief Checks to see if we have to update the VBO size.
  */
@@ -173,26 +227,17 @@ static void weapon_updateVBO( void )
    }
 }
 
-/**
- * @brief Compare id (for use with bsearch)
- */
-static int weapon_cmp( const void *ptr1, const void *ptr2 )
-{
-   const Weapon *w1, *w2;
-   w1 = (const Weapon *)ptr1;
-   w2 = (const Weapon *)ptr2;
-   return w1->id - w2->id;
-}
-
 /**
  * @brief Gets a weapon by ID.
  */
 Weapon *weapon_getID( unsigned int id )
 {
-   const Weapon wid = { .id = id };
-   Weapon      *w   = bsearch( &wid, weapon_stack, array_size( weapon_stack ),
-                               sizeof( Weapon ), weapon_cmp );
-   if ( ( w == NULL ) || weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
+   Weapon      *w;
+   unsigned int slot = id & WEAPON_SLOT_MASK;
+   if ( slot >= (unsigned int)array_size( weapon_stack ) )
+      return NULL;
+   w = &weapon_stack[slot];
+   if ( ( w->id != id ) || weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
       return NULL;
    return w;
 }
@@ -243,10 +288,10 @@ void weapon_minimap( double res, double w, double h, const RadarShape shape,
    /* Draw the points for weapons on all layers. */
    /* TODO potentially do quadtree look-up. Not sure if worth it given that only
     * weapons with health are currently added to the quadtree. */
-   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
+   for ( int i = 0; i < array_size( weapon_active ); i++ ) {
       double          x, y;
       const glColour *c;
-      Weapon         *wp = &weapon_stack[i];
+      Weapon         *wp = &weapon_stack[weapon_active[i]];
       int             isplayer;
 
       /* Make sure is in range. */
@@ -618,27 +663,32 @@ static void think_beam( Weapon *w, double dt )
  */
 void weapons_updatePurge( void )
 {
+   int n;
+
    NTracingZone( _ctx, 1 );
 
    /* Clear quadtree. */
    qt_clear( &weapon_quadtree );
 
-   /* Actually purge and remove weapons. */
-   for ( int i = array_size( weapon_stack ) - 1; i >= 0; i-- ) {
-      Weapon *w = &weapon_stack[i];
-      if ( !weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
-         continue;
-      weapon_free( w );
-      array_erase( &weapon_stack, &weapon_stack[i], &weapon_stack[i + 1] );
-   }
-
-   /* Do a second pass to add the quadtree elements. */
-   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
-      const Weapon    *w = &weapon_stack[i];
+   /* Free destroyed weapons and compact the active slots in a single pass,
+    * while adding the remaining ones to the quadtree. */
+   n = 0;
+   for ( int i = 0; i < array_size( weapon_active ); i++ ) {
+      int              slot = weapon_active[i];
+      Weapon          *w    = &weapon_stack[slot];
       int              x, y, px, py, w2, h2;
       const OutfitGFX *gfx;
       double           range;
 
+      if ( weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) ) {
+         weapon_free( w );
+         w->id    = 0;
+         w->flags = WEAPON_FLAG_DESTROYED;
+         array_push_back( &weapon_freelist, slot );
+         continue;
+      }
+      weapon_active[n++] = slot;
+
       if ( !weapon_isFlag( w, WEAPON_FLAG_HITTABLE ) )
          continue;
 
@@ -655,9 +705,10 @@ void weapons_updatePurge( void )
       py = round( w->solid.pre.y );
       w2 = ceil( range * 0.5 );
       h2 = ceil( range * 0.5 );
-      qt_insert( &weapon_quadtree, i, MIN( x, px ) - w2, MIN( y, py ) - h2,
+      qt_insert( &weapon_quadtree, slot, MIN( x, px ) - w2, MIN( y, py ) - h2,
                  MAX( x, px ) + w2, MAX( y, py ) + h2 );
    }
+   array_resize( &weapon_active, n );
 
    NTracingZoneEnd( _ctx );
 }
@@ -668,10 +719,10 @@ void weapons_updatePurge( void )
 void weapons_updateCollide( double dt )
 {
    NTracingZone( _ctx, 1 );
-   NTracingPlotI( "weapons", array_size( weapon_stack ) );
+   NTracingPlotI( "weapons", array_size( weapon_active ) );
 
-   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
-      Weapon *w = &weapon_stack[i];
+   for ( int i = 0; i < array_size( weapon_active ); i++ ) {
+      Weapon *w = &weapon_stack[weapon_active[i]];
 
       /* Ignore destroyed wapons. */
       if ( weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
@@ -741,16 +792,51 @@ void weapons_update( double dt )
 {
    NTracingZone( _ctx, 1 );
 
-   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
-      Weapon *w = &weapon_stack[i];
+   /* Thinking can modify the parent pilot and uses the RNG, so it has to be
+    * done serially and in order. */
+   for ( int i = 0; i < array_size( weapon_active ); i++ ) {
+      Weapon *w = &weapon_stack[weapon_active[i]];
       /* Only increment if weapon wasn't destroyed. */
-      if ( !weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
-         weapon_update( w, dt );
+      if ( weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
+         continue;
+      w->odir = w->solid.dir;
+      if ( w->think != NULL )
+         ( *w->think )( w, dt );
+   }
+
+   /* Movement only touches the weapon itself. */
+   vpool_parallel( array_size( weapon_active ), WEAPON_UPDATE_GRAIN,
+                   weapons_updateRange, &dt );
+
+   /* Sound isn't thread-safe. */
+   for ( int i = 0; i < array_size( weapon_active ); i++ ) {
+      const Weapon *w = &weapon_stack[weapon_active[i]];
+      if ( weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
+         continue;
+      sound_updatePos( w->voice, w->solid.pos.x, w->solid.pos.y,
+                       w->solid.vel.x, w->solid.vel.y );
    }
 
    NTracingZoneEnd( _ctx );
 }
 
+/**
+ * @brief Moves a range of weapons, run from vpool_parallel.
+ *
+ *    @param start First weapon to update.
+ *    @param end One past the last weapon to update.
+ *    @param data Pointer to the current delta tick.
+ */
+static void weapons_updateRange( int start, int end, void *data )
+{
+   double dt = *(const double *)data;
+   for ( int i = start; i < end; i++ ) {
+      Weapon *w = &weapon_stack[weapon_active[i]];
+      if ( !weapon_isFlag( w, WEAPON_FLAG_DESTROYED ) )
+         weapon_update( w, dt );
+   }
+}
+
 /**
  * @brief Renders all the weapons in a layer.
  *
@@ -761,12 +847,16 @@ void weapons_render( const WeaponLayer layer, double dt )
 {
    NTracingZone( _ctx, 1 );
 
-   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
-      Weapon *w = &weapon_stack[i];
+   for ( int i = 0; i < array_size( weapon_active ); i++ ) {
+      Weapon *w = &weapon_stack[weapon_active[i]];
       if ( w->layer == layer )
          weapon_render( w, dt );
    }
 
+   /* Draw the remaining sprite bolts. Everything else flushes the batch before
+    * drawing so it stays on top of the older bolts. */
+   gl_renderSpriteFlush();
+
    NTracingZoneEnd( _ctx );
 }
 
@@ -853,6 +943,8 @@ static void weapon_render( Weapon *w, double dt )
          col_blend( &col, &cYellow, &cRed, st );
          col.a = 0.5;
 
+         /* Has to go above the sprites drawn so far. */
+         gl_renderSpriteFlush();
          glUseProgram( shaders.iflockon.program );
          glUniform1f( shaders.iflockon.paramf, st );
          gl_renderShader( x, y, r, r, r, &shaders.iflockon, &col, 1 );
@@ -868,13 +960,14 @@ static void weapon_render( Weapon *w, double dt )
       /* Render. */
       if ( gfx->tex != NULL ) {
          const glTexture *tex = gfx->tex;
-         if ( gfx->tex_end != NULL )
+         if ( gfx->tex_end != NULL ) {
+            gl_renderSpriteFlush();
             gl_renderSpriteInterpolate( tex, gfx->tex_end, w->timer / w->life,
                                         w->solid.pos.x, w->solid.pos.y, w->sx,
                                         w->sy, &c );
-         else
-            gl_renderSprite( tex, w->solid.pos.x, w->solid.pos.y, w->sx, w->sy,
-                             &c );
+         } else
+            gl_renderSpriteBatched( tex, w->solid.pos.x, w->solid.pos.y, w->sx,
+                                    w->sy, &c );
       } else {
          double r, z;
 
@@ -890,6 +983,7 @@ static void weapon_render( Weapon *w, double dt )
               ( y > SCREEN_H + r ) )
             return;
 
+         gl_renderSpriteFlush();
          mat4 projection = gl_view_matrix;
          mat4_translate_xy( &projection, x, y );
          mat4_rotate2d( &projection, w->solid.dir );
@@ -917,6 +1011,7 @@ static void weapon_render( Weapon *w, double dt )
    /* Beam weapons. */
    case OUTFIT_TYPE_BEAM:
    case OUTFIT_TYPE_TURRET_BEAM:
+      gl_renderSpriteFlush();
       weapon_renderBeam( w, dt );
       break;
 
@@ -1416,19 +1511,16 @@ static void weapon_updateCollide( Weapon *w, double dt )
 }
 
 /**
- * @brief Updates an individual weapon.
+ * @brief Updates an individual weapon's movement and graphics.
+ *
+ * Thinking and sound are handled by weapons_update, as this can be run
+ * from worker threads.
  *
  *    @param w Weapon to update.
  *    @param dt Current delta tick.
  */
 static void weapon_update( Weapon *w, double dt )
 {
-   double odir = w->solid.dir;
-
-   /* Smart weapons also get to think their next move */
-   if ( w->think != NULL )
-      ( *w->think )( w, dt );
-
    /* Update the solid position. */
    ( *w->solid.update )( &w->solid, dt );
 
@@ -1449,17 +1541,13 @@ static void weapon_update( Weapon *w, double dt )
          w->sx = w->sprite % (int)tex->sx;
          w->sy = w->sprite / (int)tex->sx;
       }
-   } else if ( fabs( odir - w->solid.dir ) > DOUBLE_TOL ) {
+   } else if ( fabs( w->odir - w->solid.dir ) > DOUBLE_TOL ) {
       const OutfitGFX *gfx = outfit_gfx( w->outfit );
       if ( ( gfx != NULL ) && ( gfx->tex != NULL ) )
          gl_getSpriteFromDir( &w->sx, &w->sy, gfx->tex->sx, gfx->tex->sy,
                               w->solid.dir );
    }
 
-   /* Update the sound. */
-   sound_updatePos( w->voice, w->solid.pos.x, w->solid.pos.y, w->solid.vel.x,
-                    w->solid.vel.y );
-
    /* Update the trail. */
    if ( w->trail != NULL )
       weapon_sample_trail( w );
@@ -2467,12 +2555,14 @@ static int weapon_create( Weapon *w, PilotOutfitSlot *po, const Outfit *ref,
                           const Target *target, double time, int aim )
 {
    double        mass, rdir;
+   unsigned int  slot;
    const Outfit *outfit =
       ( ( ref == NULL ) && ( po != NULL ) ) ? po->outfit : ref;
 
    /* Create basic features */
    memset( w, 0, sizeof( Weapon ) );
-   w->id      = ++weapon_idgen;
+   slot       = w - weapon_stack;
+   w->id      = ( weapon_gen[slot] << WEAPON_SLOT_BITS ) | slot;
    w->layer   = ( parent->id == PLAYER_ID ) ? WEAPON_LAYER_FG : WEAPON_LAYER_BG;
    w->mount   = po;
    w->dam_mod = 1.;                     /* Default of 100% damage. */
@@ -2617,7 +2707,9 @@ Weapon *weapon_add( PilotOutfitSlot *po, const Outfit *ref, double dir,
    }
 #endif /* DEBUGGING */
 
-   w = &array_grow( &weapon_stack );
+   w = weapon_alloc();
+   if ( w == NULL )
+      return NULL;
    weapon_create( w, po, ref, T, dir, pos, vel, parent, target, time, aim );
 
    /* Grow the vertex stuff if needed. */
@@ -2679,7 +2771,9 @@ unsigned int beam_start( PilotOutfitSlot *po, double dir, const vec2 *pos,
       return -1;
    }
 
-   w = &array_grow( &weapon_stack );
+   w = weapon_alloc();
+   if ( w == NULL )
+      return 0;
    weapon_create( w, po, NULL, 0., dir, pos, vel, parent, target, 0., aim );
 
    /* Grow the vertex stuff if needed. */
@@ -2694,6 +2788,8 @@ unsigned int beam_start( PilotOutfitSlot *po, double dir, const vec2 *pos,
  */
 void beam_end( unsigned int beam )
 {
+   Weapon *w;
+
 #if DEBUGGING
    if ( beam == 0 ) {
       WARN( _( "Trying to remove beam with ID 0!" ) );
@@ -2702,13 +2798,9 @@ void beam_end( unsigned int beam )
 #endif /* DEBUGGING */
 
    /* Now try to destroy the beam. */
-   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
-      Weapon *w = &weapon_stack[i];
-      if ( w->id == beam ) { /* Found it. */
-         weapon_miss( w );
-         break;
-      }
-   }
+   w = weapon_getID( beam );
+   if ( w != NULL )
+      weapon_miss( w );
 }
 
 /**
@@ -2767,15 +2859,20 @@ void weapon_clear( void )
    NTracingZone( _ctx, 1 );
 
    /* Don't forget to stop the sounds. */
-   for ( int i = 0; i < array_size( weapon_stack ); i++ ) {
-      Weapon *w = &weapon_stack[i];
+   for ( int i = 0; i < array_size( weapon_active ); i++ ) {
+      Weapon *w = &weapon_stack[weapon_active[i]];
       sound_stop( w->voice );
       weapon_free( w );
+      w->id    = 0;
+      w->flags = WEAPON_FLAG_DESTROYED;
    }
-   array_erase( &weapon_stack, array_begin( weapon_stack ),
-                array_end( weapon_stack ) );
-   /* We can restart the idgen. */
-   weapon_idgen = 0; /* May mess up Lua stuff... */
+   array_erase( &weapon_active, array_begin( weapon_active ),
+                array_end( weapon_active ) );
+
+   /* All slots are free now, generations are kept so old IDs stay invalid. */
+   array_resize( &weapon_freelist, array_size( weapon_stack ) );
+   for ( int i = 0; i < array_size( weapon_stack ); i++ )
+      weapon_freelist[i] = array_size( weapon_stack ) - i - 1;
 
    NTracingZoneEnd( _ctx );
 }
@@ -2789,6 +2886,13 @@ void weapon_exit( void )
 
    /* Destroy weapon stack. */
    array_free( weapon_stack );
+   weapon_stack = NULL;
+   array_free( weapon_active );
+   weapon_active = NULL;
+   array_free( weapon_freelist );
+   weapon_freelist = NULL;
+   array_free( weapon_gen );
+   weapon_gen = NULL;
 
    /* Destroy VBO. */
    free( weapon_vboData );
@@ -49,7 +49,7 @@ typedef struct Weapon_ {
    WeaponLayer  layer; /**< Weapon layer. */
    unsigned int flags; /**< Weapon flags. */
    Solid        solid; /**< Actually has its own solid :) */
-   unsigned int id;    /**< Unique weapon id. */
+   unsigned int id;    /**< Weapon id, made of its slot and generation. */
 
    int           faction; /**< faction of pilot that shot it */
    unsigned int  parent;  /**< pilot that shot it */
@@ -76,6 +76,7 @@ typedef struct Weapon_ {
    int         sx;            /**< Current X sprite to use. */
    int         sy;            /**< Current Y sprite to use. */
    Trail_spfx *trail;         /**< Trail graphic if applicable, else NULL. */
+   double      odir; /**< Direction before thinking, used to update sprites. */
 
    double armour; /**< Health status of the weapon. */
 
@@ -0,0 +1,403 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file test_collision.c
+ *
+ * @brief Checks the sprite collisions against testing pixels one by one.
+ *
+ * The sprite collisions test whole words of the transparency maps at once,
+ *  this makes sure they find the same collision and crash point as the
+ *  original loops over gl_isTrans() on random and edge case masks.
+ *
+ * The polygons are all convex so the reference can use a simpler check to
+ *  know if a pixel is inside one.
+ */
+/** @cond */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "naev.h"
+/** @endcond */
+
+#include "collision.h"
+
+#include "physics.h"
+
+#define TEST_RUNS 2000 /**< Number of random runs per test. */
+
+static int test_failed = 0; /**< Number of failed checks. */
+
+/*
+ * Stubs for what collision.c needs from the rest of the game.
+ */
+int log_warn( const char *file, size_t line, const char *func, const char *fmt,
+              ... )
+{
+   (void)line;
+   (void)fmt;
+   fprintf( stderr, "%s:%s: warning\n", file, func );
+   return 0;
+}
+const char *gettext_ngettext( const char *msgid, const char *msgid_plural,
+                              uint64_t n )
+{
+   return ( ( n == 1 ) || ( msgid_plural == NULL ) ) ? msgid : msgid_plural;
+}
+double angle_clean( double a )
+{
+   return a;
+}
+void vectnull( vec2 *v )
+{
+   v->x = v->y = 0.;
+}
+
+/**
+ * @brief Creates a sprite sheet with a random mask.
+ *
+ *    @param sx Number of sprites horizontally.
+ *    @param sy Number of sprites vertically.
+ *    @param sw Width of a sprite.
+ *    @param sh Height of a sprite.
+ *    @param fill Chance in 1/256 of a pixel not being transparent, or 256
+ *           to pick full and empty rows at random.
+ */
+static glTexture *test_texNew( int sx, int sy, int sw, int sh, int fill )
+{
+   glTexture *t = calloc( 1, sizeof( glTexture ) );
+   t->sx        = sx;
+   t->sy        = sy;
+   t->sw        = sw;
+   t->sh        = sh;
+   t->w         = sx * sw;
+   t->h         = sy * sh;
+   t->tstride   = ( (int)t->w + 63 ) / 64 + 1;
+   t->trans     = calloc( (size_t)t->tstride * t->h, sizeof( uint64_t ) );
+   for ( int y = 0; y < (int)t->h; y++ ) {
+      int row = ( fill >= 256 ) ? rand() % 3 : -1;
+      for ( int x = 0; x < (int)t->w; x++ ) {
+         int set;
+         if ( row == 0 )
+            set = 0;
+         else if ( row == 1 )
+            set = 1;
+         else if ( fill >= 256 )
+            set = rand() % 2;
+         else
+            set = ( rand() % 256 ) < fill;
+         if ( set )
+            t->trans[y * t->tstride + x / 64] |= UINT64_C( 1 ) << ( x % 64 );
+      }
+   }
+   return t;
+}
+
+/**
+ * @brief Frees a texture made with test_texNew.
+ */
+static void test_texFree( glTexture *t )
+{
+   free( t->trans );
+   free( t );
+}
+
+/**
+ * @brief The sprite collision as it was, testing pixels one by one.
+ */
+static int test_refSprite( const glTexture *at, int asx, int asy,
+                           const vec2 *ap, const glTexture *bt, int bsx,
+                           int bsy, const vec2 *bp, vec2 *crash )
+{
+   int ax1 = (int)VX( *ap ) - (int)( at->sw ) / 2;
+   int ay1 = (int)VY( *ap ) - (int)( at->sh ) / 2;
+   int ax2 = ax1 + (int)( at->sw ) - 1;
+   int ay2 = ay1 + (int)( at->sh ) - 1;
+   int bx1 = (int)VX( *bp ) - (int)( bt->sw ) / 2;
+   int by1 = (int)VY( *bp ) - (int)( bt->sh ) / 2;
+   int bx2 = bx1 + bt->sw - 1;
+   int by2 = by1 + bt->sh - 1;
+   int abx, aby, bbx, bby;
+
+   if ( ( bx2 < ax1 ) || ( ax2 < bx1 ) )
+      return 0;
+   if ( ( by2 < ay1 ) || ( ay2 < by1 ) )
+      return 0;
+
+   abx = asx * (int)( at->sw ) - ax1;
+   aby = ( at->sy - asy - 1 ) * (int)( at->sh ) - ay1;
+   bbx = bsx * (int)( bt->sw ) - bx1;
+   bby = ( bt->sy - bsy - 1 ) * (int)( bt->sh ) - by1;
+
+   for ( int y = MAX( ay1, by1 ); y <= MIN( ay2, by2 ); y++ )
+      for ( int x = MAX( ax1, bx1 ); x <= MIN( ax2, bx2 ); x++ )
+         if ( ( !gl_isTrans( at, abx + x, aby + y ) ) &&
+              ( !gl_isTrans( bt, bbx + x, bby + y ) ) ) {
+            crash->x = x;
+            crash->y = y;
+            return 1;
+         }
+   return 0;
+}
+
+/**
+ * @brief The circle and sprite collision as it was, testing pixels one by one.
+ */
+static int test_refCircleSprite( const vec2 *ap, double ar, const glTexture *bt,
+                                 int bsx, int bsy, const vec2 *bp,
+                                 vec2 *crash )
+{
+   int r   = ceil( ar );
+   int acx = (int)VX( *ap );
+   int acy = (int)VY( *ap );
+   int bx1 = (int)VX( *bp ) - (int)( bt->sw ) / 2;
+   int by1 = (int)VY( *bp ) - (int)( bt->sh ) / 2;
+   int bx2 = bx1 + bt->sw - 1;
+   int by2 = by1 + bt->sh - 1;
+   int bbx, bby;
+
+   if ( ( bx2 < acx - r ) || ( acx + r < bx1 ) )
+      return 0;
+   if ( ( by2 < acy - r ) || ( acy + r < by1 ) )
+      return 0;
+
+   bbx = bsx * (int)( bt->sw ) - bx1;
+   bby = ( bt->sy - bsy - 1 ) * (int)( bt->sh ) - by1;
+
+   for ( int y = MAX( acy - r, by1 ); y <= MIN( acy + r, by2 ); y++ )
+      for ( int x = MAX( acx - r, bx1 ); x <= MIN( acx + r, bx2 ); x++ )
+         if ( ( !gl_isTrans( bt, bbx + x, bby + y ) ) &&
+              ( pow2( x - acx ) + pow2( y - acy ) <= r * r ) ) {
+            crash->x = x;
+            crash->y = y;
+            return 1;
+         }
+   return 0;
+}
+
+/**
+ * @brief Checks to see if a point is inside a convex counter-clockwise polygon.
+ */
+static int test_inPolygon( const CollPolyView *at, const vec2 *ap, double x,
+                           double y )
+{
+   for ( int i = 0; i < at->npt; i++ ) {
+      int    j  = ( i + 1 ) % at->npt;
+      double x1 = at->x[i] + VX( *ap );
+      double y1 = at->y[i] + VY( *ap );
+      double x2 = at->x[j] + VX( *ap );
+      double y2 = at->y[j] + VY( *ap );
+      if ( ( x2 - x1 ) * ( y - y1 ) - ( y2 - y1 ) * ( x - x1 ) < 0. )
+         return 0;
+   }
+   return 1;
+}
+
+/**
+ * @brief The polygon and sprite collision as it was, testing pixels one by one.
+ */
+static int test_refSpritePolygon( const CollPolyView *at, const vec2 *ap,
+                                  const glTexture *bt, int bsx, int bsy,
+                                  const vec2 *bp, vec2 *crash )
+{
+   int ax1 = (int)VX( *ap ) + (int)( at->xmin );
+   int ay1 = (int)VY( *ap ) + (int)( at->ymin );
+   int ax2 = (int)VX( *ap ) + (int)( at->xmax );
+   int ay2 = (int)VY( *ap ) + (int)( at->ymax );
+   int bx1 = (int)VX( *bp ) - (int)( bt->sw ) / 2;
+   int by1 = (int)VY( *bp ) - (int)( bt->sh ) / 2;
+   int bx2 = bx1 + bt->sw - 1;
+   int by2 = by1 + bt->sh - 1;
+   int bbx, bby;
+
+   if ( ( bx2 < ax1 ) || ( ax2 < bx1 ) )
+      return 0;
+   if ( ( by2 < ay1 ) || ( ay2 < by1 ) )
+      return 0;
+
+   bbx = bsx * (int)( bt->sw ) - bx1;
+   bby = ( bt->sy - bsy - 1 ) * (int)( bt->sh ) - by1;
+
+   for ( int y = MAX( ay1, by1 ); y <= MIN( ay2, by2 ); y++ )
+      for ( int x = MAX( ax1, bx1 ); x <= MIN( ax2, bx2 ); x++ )
+         if ( ( !gl_isTrans( bt, bbx + x, bby + y ) ) &&
+              test_inPolygon( at, ap, x, y ) ) {
+            crash->x = x;
+            crash->y = y;
+            return 1;
+         }
+   return 0;
+}
+
+/**
+ * @brief Compares a result against the reference one.
+ */
+static void test_check( const char *what, int run, int ret, const vec2 *crash,
+                        int ref, const vec2 *refcrash )
+{
+   if ( ret != ref ) {
+      fprintf( stderr, "%s run %d: got %d, expected %d\n", what, run, ret,
+               ref );
+      test_failed++;
+   } else if ( ret && ( ( crash->x != refcrash->x ) ||
+                        ( crash->y != refcrash->y ) ) ) {
+      fprintf( stderr, "%s run %d: crash at (%g,%g), expected (%g,%g)\n",
+               what, run, crash->x, crash->y, refcrash->x, refcrash->y );
+      test_failed++;
+   }
+}
+
+/**
+ * @brief Gets a random sprite size, favouring the ones around word edges.
+ */
+static int test_size( void )
+{
+   static const int edges[] = { 1, 2, 31, 63, 64, 65, 127, 128, 129 };
+   if ( rand() % 2 )
+      return edges[rand() % (int)( sizeof( edges ) / sizeof( edges[0] ) )];
+   return 1 + rand() % 200;
+}
+
+/**
+ * @brief Gets a random fill for a mask, including empty, full and by rows.
+ */
+static int test_fill( void )
+{
+   static const int fills[] = { 0, 1, 8, 128, 255, 256 };
+   if ( rand() % 2 )
+      return fills[rand() % (int)( sizeof( fills ) / sizeof( fills[0] ) )];
+   return rand() % 257;
+}
+
+/**
+ * @brief Tests sprite against sprite collisions.
+ */
+static void test_sprite( void )
+{
+   for ( int run = 0; run < TEST_RUNS; run++ ) {
+      /* Sprite sheets put sprites at offsets not aligned to words. */
+      glTexture *at = test_texNew( 1 + rand() % 3, 1 + rand() % 3, test_size(),
+                                   test_size(), test_fill() );
+      glTexture *bt = test_texNew( 1 + rand() % 3, 1 + rand() % 3, test_size(),
+                                   test_size(), test_fill() );
+      int        asx = rand() % (int)at->sx;
+      int        asy = rand() % (int)at->sy;
+      int        bsx = rand() % (int)bt->sx;
+      int        bsy = rand() % (int)bt->sy;
+      vec2       ap, bp, crash, refcrash;
+      int        ret, ref;
+
+      ap.x = rand() % 256 - 128;
+      ap.y = rand() % 256 - 128;
+      bp.x = rand() % 256 - 128;
+      bp.y = rand() % 256 - 128;
+      ret = CollideSprite( at, asx, asy, &ap, bt, bsx, bsy, &bp, &crash );
+      ref = test_refSprite( at, asx, asy, &ap, bt, bsx, bsy, &bp, &refcrash );
+      test_check( "CollideSprite", run, ret, &crash, ref, &refcrash );
+
+      test_texFree( at );
+      test_texFree( bt );
+   }
+}
+
+/**
+ * @brief Tests circle against sprite collisions.
+ */
+static void test_circleSprite( void )
+{
+   for ( int run = 0; run < TEST_RUNS; run++ ) {
+      glTexture *bt  = test_texNew( 1 + rand() % 3, 1 + rand() % 3, test_size(),
+                                    test_size(), test_fill() );
+      int        bsx = rand() % (int)bt->sx;
+      int        bsy = rand() % (int)bt->sy;
+      double     ar  = ( rand() % 1600 ) / 10.;
+      vec2       ap, bp, crash, refcrash;
+      int        ret, ref;
+
+      ap.x = rand() % 256 - 128;
+      ap.y = rand() % 256 - 128;
+      bp.x = rand() % 256 - 128;
+      bp.y = rand() % 256 - 128;
+      ret = CollideCircleSprite( &ap, ar, bt, bsx, bsy, &bp, &crash );
+      ref = test_refCircleSprite( &ap, ar, bt, bsx, bsy, &bp, &refcrash );
+      test_check( "CollideCircleSprite", run, ret, &crash, ref, &refcrash );
+
+      test_texFree( bt );
+   }
+}
+
+/**
+ * @brief Creates a random convex polygon with its points on a circle.
+ */
+static void test_polyNew( CollPolyView *poly )
+{
+   double r = 1. + ( rand() % 1500 ) / 10.;
+   double a[8];
+
+   poly->npt = 3 + rand() % 6;
+   poly->x   = malloc( poly->npt * sizeof( float ) );
+   poly->y   = malloc( poly->npt * sizeof( float ) );
+   /* Sorting the angles keeps it convex and counter-clockwise. */
+   for ( int i = 0; i < poly->npt; i++ ) {
+      a[i] = 2. * M_PI * rand() / ( RAND_MAX + 1. );
+      for ( int j = i; ( j > 0 ) && ( a[j - 1] > a[j] ); j-- ) {
+         double t = a[j];
+         a[j]     = a[j - 1];
+         a[j - 1] = t;
+      }
+   }
+   poly->xmin = poly->ymin = HUGE_VALF;
+   poly->xmax = poly->ymax = -HUGE_VALF;
+   for ( int i = 0; i < poly->npt; i++ ) {
+      poly->x[i] = r * cos( a[i] );
+      poly->y[i] = r * sin( a[i] );
+      poly->xmin = MIN( poly->xmin, poly->x[i] );
+      poly->xmax = MAX( poly->xmax, poly->x[i] );
+      poly->ymin = MIN( poly->ymin, poly->y[i] );
+      poly->ymax = MAX( poly->ymax, poly->y[i] );
+   }
+}
+
+/**
+ * @brief Tests polygon against sprite collisions.
+ */
+static void test_spritePolygon( void )
+{
+   for ( int run = 0; run < TEST_RUNS; run++ ) {
+      glTexture   *bt  = test_texNew( 1 + rand() % 3, 1 + rand() % 3,
+                                      test_size(), test_size(), test_fill() );
+      int          bsx = rand() % (int)bt->sx;
+      int          bsy = rand() % (int)bt->sy;
+      CollPolyView poly;
+      vec2         ap, bp, crash, refcrash;
+      int          ret, ref;
+
+      test_polyNew( &poly );
+      ap.x = rand() % 256 - 128;
+      ap.y = rand() % 256 - 128;
+      bp.x = rand() % 256 - 128;
+      bp.y = rand() % 256 - 128;
+      ret  = CollideSpritePolygon( &poly, &ap, bt, bsx, bsy, &bp, &crash );
+      ref  = test_refSpritePolygon( &poly, &ap, bt, bsx, bsy, &bp, &refcrash );
+      test_check( "CollideSpritePolygon", run, ret, &crash, ref, &refcrash );
+
+      free( poly.x );
+      free( poly.y );
+      test_texFree( bt );
+   }
+}
+
+int main( void )
+{
+   srand( 42 );
+   test_sprite();
+   test_circleSprite();
+   test_spritePolygon();
+   if ( test_failed > 0 ) {
+      fprintf( stderr, "%d checks failed\n", test_failed );
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+--[[
+   Headless battle benchmark. Run with naevlua:
+
+      naevlua utils/benchmark/battle.lua [ticks] [seed] [system]
+
+   Sets up two hostile fleets in a system, runs a fixed number of fixed time
+   step updates without rendering nor sound, and prints the time spent in each
+   phase of the update, the pilot and weapon counts, and a hash of the final
+   state as a single line of JSON. Two runs with the same arguments should
+   give the same hash, if they don't something is not deterministic.
+--]]
+local ticks    = tonumber(arg[1]) or 3600
+local seed     = tonumber(arg[2]) or 42
+local sysname  = arg[3] or "Delta Polaris"
+local dt       = 1/60
+
+-- Fleets to fight it out, each with its own dynamic faction
+local scenario = {
+   {
+      name  = "red",
+      base  = "Empire",
+      pos   = vec2.new( -4000, 0 ),
+      ships = {
+         { "Empire Shark", 8 },
+         { "Empire Lancelot", 6 },
+         { "Empire Admonisher", 3 },
+         { "Empire Pacifier", 2 },
+         { "Empire Hawking", 1 },
+      },
+   },
+   {
+      name  = "blue",
+      base  = "Dvaered",
+      pos   = vec2.new( 4000, 0 ),
+      ships = {
+         { "Dvaered Vendetta", 10 },
+         { "Dvaered Ancestor", 4 },
+         { "Dvaered Phalanx", 3 },
+         { "Dvaered Vigilance", 2 },
+         { "Dvaered Goddard", 1 },
+      },
+   },
+}
+
+-- Everything random has to come from the seed
+bench.seed( seed )
+math.randomseed( seed )
+
+bench.space( sysname )
+pilot.toggleSpawn( false )
+pilot.clear()
+
+local facs = {}
+for i,f in ipairs(scenario) do
+   facs[i] = faction.dynAdd( f.base, "bench_"..f.name, f.name,
+      { clear_enemies=true, clear_allies=true } )
+   for j=1,i-1 do
+      facs[i]:dynEnemy( facs[j] )
+   end
+end
+for i,f in ipairs(scenario) do
+   for _k,s in ipairs(f.ships) do
+      for _n=1,s[2] do
+         pilot.add( s[1], facs[i], f.pos + vec2.newP( 500*rnd.rnd(), rnd.angle() ) )
+      end
+   end
+end
+
+local res = bench.run( ticks, dt )
+
+-- Minimal JSON output so the results can be easily compared between runs
+local jsonesc = { ['"']='\\"', ['\\']='\\\\', ['\b']='\\b', ['\f']='\\f',
+   ['\n']='\\n', ['\r']='\\r', ['\t']='\\t' }
+local function jsonstr( s )
+   return '"'..string.gsub( s, '[%c"\\]', function( c )
+      return jsonesc[c] or string.format( "\\u%04x", string.byte(c) )
+   end )..'"'
+end
+local function json( v )
+   if type(v)=="table" then
+      local keys = {}
+      for k,_v in pairs(v) do
+         table.insert( keys, k )
+      end
+      table.sort( keys )
+      local out = {}
+      for _k,k in ipairs(keys) do
+         table.insert( out, jsonstr(tostring(k))..":"..json(v[k]) )
+      end
+      return "{"..table.concat( out, "," ).."}"
+   elseif type(v)=="string" then
+      return jsonstr( v )
+   end
+   return tostring(v)
+end
+
+res.seed    = seed
+res.system  = sysname
+res.hash    = bench.hash()
+print( json(res) )
@@ -1,6 +1,6 @@
 local equipopt = require 'equipopt'
 local benchmark = {}
-function benchmark.run( _testname, reps, sparams )
+function benchmark.run( _testname, reps, sparams, memoize )
    local ships = {
       "Llama",
       "Hyena",
@@ -25,6 +25,10 @@ function benchmark.run( _testname, reps, sparams )
       equipopt.proteron,
    }
 
+   -- Solver parameters can only be compared when actually solving
+   equipopt.optimize.memoize = memoize or false
+   equipopt.optimize.memo_clear()
+
    pilot.clear()
    local pos = vec2.new(0,0)
    local vals = {}
@@ -61,6 +65,17 @@ function benchmark.run( _testname, reps, sparams )
    return mean, stddev, vals
 end
 
+-- Runs with loadout memoization and prints the speedup and hit rate compared
+-- to solving every time
+function benchmark.run_memo( reps, sparams, ref_mean )
+   local mean, stddev, vals = benchmark.run( "Memoized", reps, sparams, true )
+   local hits, misses = equipopt.optimize.memo_stats()
+   print(string.format("Memoized: %.3f (%.3f) ms, %.1fx speedup, %d hits, %d misses (%.1f%% hit rate)",
+      mean, stddev, ref_mean / mean, hits, misses, 100 * hits / math.max(1, hits+misses) ) )
+   equipopt.optimize.memoize = true
+   return mean, stddev, vals
+end
+
 function benchmark.csv_open( header, reps )
    local csvfile = file.new("benchmark.csv")
    csvfile:open("w")
@@ -0,0 +1,55 @@
+--[[
+   Stress test for pushing pilot handles to Lua. Run with naevlua:
+
+      naevlua utils/benchmark/pilot_handles.lua [system]
+
+   Repeatedly fetches the same pilots and reports how much memory the Lua
+   heap grows by and how many collection cycles it needed, which is what
+   interning of the handles is meant to keep down.
+--]]
+local sysname = arg[1] or "Delta Polaris"
+local npilots = 200
+local reps = 500
+
+bench.space( sysname )
+pilot.toggleSpawn( false )
+pilot.clear()
+local pos = vec2.new(0,0)
+local plts = {}
+for i=1,npilots do
+   plts[i] = pilot.add( "Llama", "Dummy", pos, nil, {naked=true} )
+end
+
+-- Equality semantics must be the same whether or not handles are shared
+local a = pilot.get()
+local b = pilot.get()
+for i=1,#a do
+   assert( a[i] == b[i], "pilot handles not equal" )
+end
+
+local function run( testname, func )
+   collectgarbage("collect")
+   collectgarbage("stop")
+   local mem = collectgarbage("count")
+   local tstart = naev.clock()
+   for i=1,reps do
+      func()
+   end
+   local elapsed = naev.clock() - tstart
+   local grow = collectgarbage("count") - mem
+   collectgarbage("restart")
+   print(string.format("%s: %.3f ms, %.1f KiB allocated (%.1f B per pilot)",
+      testname, elapsed * 1000 / reps, grow / reps, grow * 1024 / (reps * npilots) ) )
+end
+
+print("====== BENCHMARK START ======")
+run( "pilot.get", function ()
+   return pilot.get()
+end )
+run( "getAllies", function ()
+   return plts[1]:getAllies( 1e6 )
+end )
+run( "getVisible", function ()
+   return plts[1]:getVisible()
+end )
+print("====== BENCHMARK END ======")
@@ -0,0 +1,68 @@
+--[[
+   Stealth and sensor stress test. Run with naevlua:
+
+      naevlua utils/benchmark/stealth.lua [ticks] [seed] [system]
+
+   Fills a system with increasingly many stealthed pilots of two hostile
+   factions spread over a large area, and reports how long each tick takes
+   along with how long the sensor queries take on their own. Stealth has to
+   look for nearby pilots every tick, so with a linear scan the cost grows
+   quadratically with the number of pilots, while radius searches over the
+   quadtree should keep it close to linear.
+--]]
+local ticks    = tonumber(arg[1]) or 300
+local seed     = tonumber(arg[2]) or 42
+local sysname  = arg[3] or "Delta Polaris"
+local dt       = 1/60
+local counts   = { 50, 100, 200, 400, 800 }
+local spread   = 40e3
+local queries  = 100
+
+bench.space( sysname )
+pilot.toggleSpawn( false )
+
+local facs = {
+   faction.dynAdd( "Empire", "bench_red", "red",
+      { clear_enemies=true, clear_allies=true } ),
+   faction.dynAdd( "Dvaered", "bench_blue", "blue",
+      { clear_enemies=true, clear_allies=true } ),
+}
+facs[2]:dynEnemy( facs[1] )
+
+local function run( n )
+   bench.seed( seed )
+   math.randomseed( seed )
+   pilot.clear()
+
+   local plts = {}
+   for i=1,n do
+      local f = facs[ (i % 2) + 1 ]
+      local p = pilot.add( "Llama", f, vec2.newP( spread*math.sqrt(rnd.rnd()), rnd.angle() ) )
+      p:stealth()
+      plts[i] = p
+   end
+
+   local res = bench.run( ticks, dt )
+
+   -- Time the queries on their own, they are also called by the AI
+   local tstart = naev.clock()
+   for i=1,queries do
+      plts[ (i % #plts) + 1 ]:getVisible()
+   end
+   local tvisible = naev.clock() - tstart
+   tstart = naev.clock()
+   for i=1,queries do
+      plts[ (i % #plts) + 1 ]:getEnemies( 5000 )
+   end
+   local tenemies = naev.clock() - tstart
+
+   print( string.format( "%5d pilots: %7.3f ms/tick (pilots %7.3f ms/tick), getVisible %6.3f ms, getEnemies %6.3f ms",
+      n, res.elapsed * 1000 / ticks, res.phases.pilots * 1000 / ticks,
+      tvisible * 1000 / queries, tenemies * 1000 / queries ) )
+end
+
+print("====== BENCHMARK START ======")
+for _k,n in ipairs(counts) do
+   run( n )
+end
+print("====== BENCHMARK END ======")